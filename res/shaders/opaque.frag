@@ -76,6 +76,7 @@ layout(std140, set = 1, binding = 0) uniform MaterialData {
 	float attenuationDistance;
 	vec4 attenuationColor;
 	float ior;
+	float normalTwoChannel;   // 1 for BC5 normal maps: z is reconstructed
 } uMat;
 
 
@@ -178,6 +179,8 @@ vec3 getNormalFromMap()
     uv = applyTextureTransform(uv, uMat.normalTT);
 
     vec3 tangentNormal = texture(normalTex, uv).xyz * 2.0 - 1.0;
+    if (uMat.normalTwoChannel > 0.5)
+        tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 
     vec3 N0 = normalize(fragNormal);
     vec3 T  = normalize(fragTangent);
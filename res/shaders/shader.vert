@@ -1,5 +1,8 @@
 #version 450
 
+// Config::vertexLayout: 0 float, 1 compact, 2 compact with quantized positions
+layout(constant_id = 0) const int VERTEX_LAYOUT = 0;
+
 layout(push_constant) uniform PushConstants {
     mat4 nodeMatrix;
     vec4  baseColorFactor;
@@ -24,6 +27,9 @@ layout(push_constant) uniform PushConstants {
     int   thicknessTextureIndex;
     int   thicknessTexCoordIndex;
     vec4  attenuation;
+
+    vec4  posOffset;
+    vec4  posScale;
 } pc;
 
 
@@ -52,11 +58,12 @@ layout(set = 0, binding = 3) uniform sampler2D sceneDepth;
 // Vertex Inputs
 // ─────────────────────────────────────────────
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
+layout(location = 1) in vec4 inColor;     // compact: alpha is the tangent sign
 layout(location = 2) in vec2 inTexCoord0;
 layout(location = 3) in vec2 inTexCoord1;
-layout(location = 4) in vec3 inNormal;
-layout(location = 5) in vec4 inTangent;
+layout(location = 4) in vec3 inNormal;    // compact: octahedral xy
+layout(location = 5) in vec4 inTangent;   // compact: octahedral xy
+layout(location = 6) in mat4 inInstance;  // per instance, identity when not instanced
 
 // ─────────────────────────────────────────────
 // Vertex Outputs
@@ -70,23 +77,38 @@ layout(location = 5) out vec3 fragTangent;
 layout(location = 6) out vec3 fragBitangent;
 layout(location = 7) out vec2 fragSceneUV;
 
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
 void main() {
-    mat4 modelNode = ubo.model * pc.nodeMatrix;
+    mat4 modelNode = ubo.model * pc.nodeMatrix * inInstance;
+
+    vec3 position = pc.posOffset.xyz + inPosition * pc.posScale.xyz;
+    vec3 normal = inNormal;
+    vec4 tangent = inTangent;
+    if (VERTEX_LAYOUT != 0) {
+        normal = octDecode(inNormal.xy);
+        tangent = vec4(octDecode(inTangent.xy), inColor.a > 0.5 ? 1.0 : -1.0);
+    }
 
-    vec4 worldPos = modelNode * vec4(inPosition, 1.0);
+    vec4 worldPos = modelNode * vec4(position, 1.0);
     fragWorldPos = worldPos.xyz;
 
     mat3 normalMatrix = transpose(inverse(mat3(modelNode)));
-    vec3 N = normalize(normalMatrix * inNormal);
-    vec3 T = normalize(normalMatrix * inTangent.xyz);
+    vec3 N = normalize(normalMatrix * normal);
+    vec3 T = normalize(normalMatrix * tangent.xyz);
     T = normalize(T - N * dot(N, T));
-    vec3 B = cross(N, T) * inTangent.w;
+    vec3 B = cross(N, T) * tangent.w;
 
     fragNormal   = N;
     fragTangent  = T;
     fragBitangent = B;
 
-    fragColorVS    = inColor;
+    fragColorVS    = inColor.rgb;
     fragTexCoordVS0 = inTexCoord0;
     fragTexCoordVS1 = inTexCoord1;
 
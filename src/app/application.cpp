@@ -2,11 +2,16 @@
 #include "loader/gltf_textures.h"
 #include "loader/gltf_meshes.h"
 #include "loader/gltf_loader.h"
+#include "loader/model_loader.h"
+#include "loader/scene_manifest.h"
 #include "loader/ktx_cubemap.h"
 #include "scene/model.h"
+#include "scene/animation.h"
+#include "scene/transforms.h"
 #include "scene/scene.h"
 #include "scene/camera.h"
 #include "resources/buffers.h"
+#include "resources/staging_arena.h"
 #include "render/command_buffers.h"
 #include "render/frame_buffers.h"
 #include "render/descriptors.h"
@@ -14,11 +19,13 @@
 #include "render/sync_objects.h"
 #include "render/renderer.h"
 #include "render/render_pass.h"
+#include "render/texture_streaming.h"
 #include "core/swapchain.h"
 #include "core/context.h"
 #include "core/window.h"
 #include "core/config.h"
 #include "core/input.h"
+#include "core/jobs.h"
 #include "gui/gui.h"
 #include "core/state.h"	
 
@@ -154,10 +161,13 @@ void init(State* state) {
     state->scene = new Scene{};
     state->scene->camera = new Camera{};
     state->scene->camera->updateCameraVectors();
+    state->jobs = new JobSystem{};
+    jobSystemCreate(state);
 
     windowCreate(state);
     deviceCreate(state);
     commandPoolCreate(state);
+    textureStreamerCreate(state);
 
     swapchainCreate(state);
     swapchainImageGet(state);
@@ -176,6 +186,7 @@ void init(State* state) {
     presentSetLayoutCreate(state);
 
     createSkyboxVbo(state);
+    identityInstanceBufferCreate(state);
 
     skyboxPipelineCreate(state);
     opaquePipelineCreate(state);
@@ -191,6 +202,10 @@ void init(State* state) {
     presentSamplerCreate(state);
 
     iblSetLayoutCreate(state);
+    skinSetLayoutCreate(state);
+    skinPipelineCreate(state);
+    morphSetLayoutCreate(state);
+    morphPipelineCreate(state);
 
     uint32_t texWidth, texHeight;
 
@@ -285,13 +300,12 @@ void init(State* state) {
     presentFramebuffersCreate(state);
     callbackSetup(state);
 
-    // Load model + textures BEFORE descriptor sets
-    loadModel(state, state->config->MODEL_PATH);
-    state->scene->models[0]->setTransform(
-        { 1.0f, -1.0f, 0.0f },
-        { 0.0f, -90.0f, 0.0f },
-        { 1.0f, 1.0f, 1.0f }
-    );
+    // Load models + textures BEFORE descriptor sets
+    modelLoaderCreate(state);
+    if (!state->config->SCENE_PATH.empty())
+        sceneManifestLoad(state, state->config->SCENE_PATH);
+    else
+        loadModel(state, state->config->MODEL_PATH);
 
     uniformBuffersCreate(state);
 
@@ -312,10 +326,18 @@ void init(State* state) {
 }
 
 void mainloop(State *state) {
+	double lastTime = glfwGetTime();
 	while (!glfwWindowShouldClose(state->window.handle)) {
 		glfwPollEvents();
+		double now = glfwGetTime();
+		float deltaTime = (float)(now - lastTime);
+		lastTime = now;
 		updateFPS(state);
 		processInput(state);
+		modelLoaderPoll(state);
+		textureStreamingUpdate(state);
+		animationsUpdate(state, deltaTime);
+		transformsUpdate(state);
 		uniformBuffersUpdate(state);
 		frameDraw(state);
 	};
@@ -328,7 +350,10 @@ void cleanup(State *state) {
 	swapchainCleanup(state);
 
 	guiClean(state);
+	modelLoaderDestroy(state);
+	textureStreamerDestroy(state);
 	modelUnload(state);
+	stagingArenaDestroy(state);
 	destroyTextures(state);
 
 	uniformBuffersDestroy(state);
@@ -336,15 +361,21 @@ void cleanup(State *state) {
 	globalSetLayoutDestroy(state);
 	indexBufferDestroy(state);
 	vertexBufferDestroy(state);
+	identityInstanceBufferDestroy(state);
 	syncObjectsDestroy(state);
 	commandPoolDestroy(state);
 	presentPipelineDestroy(state);
 	destroySceneColorSampler(state);
 	transparencyPipelineDestroy(state);
 	opaquePipelineDestroy(state);
+	skinPipelineDestroy(state);
+	skinSetLayoutDestroy(state);
+	morphPipelineDestroy(state);
+	morphSetLayoutDestroy(state);
 	presentRenderPassDestroy(state);
 	transparentRenderPassDestroy(state);
 	opaqueRenderPassDestroy(state);
 	deviceDestroy(state);
 	windowDestroy(state);
+	jobSystemDestroy(state);
 };
\ No newline at end of file
@@ -18,6 +18,11 @@ Config config
 			.DEFAULT_BRDF_LUT = "./res/cubemaps/default_lut.ktx2",
 			.DEFAULT_TEXTURE_PATH = "./res/textures/default_texture.ktx2",
 			.MODEL_PATH = "./res/models/DragonAttenuation.glb",
+			.SCENE_PATH = "./res/scenes/default.json",
+			.TEXTURE_CACHE_DIR = "./cache/textures",
+			.meshOptimization = true,
+			.vertexLayout = VertexLayout::Float,
+			.textureBudget = 256ull << 20,
 };
 
 int main() {
@@ -2,6 +2,14 @@
 
 #include <string>
 #include <vulkan/vulkan.h>
+
+// GPU vertex format meshes are uploaded in (see scene/mesh.h)
+enum class VertexLayout : uint32_t {
+	Float,              // Vertex as-is, 72 bytes
+	Compact,            // CompactVertex, 32 bytes
+	CompactQuantized,   // QuantizedVertex, 28 bytes: positions unorm16 over the mesh bounds
+};
+
 struct Config{
 	const std::string windowTitle;
 	const std::string engineName;
@@ -25,5 +33,10 @@ struct Config{
 	const std::string KOBOLD_MODEL_PATH;
 	const std::string HOVER_BIKE_MODEL_PATH;
 	const std::string MODEL_PATH;
+	const std::string SCENE_PATH;			// JSON scene manifest (loader/scene_manifest.h); empty loads MODEL_PATH alone
+	const std::string TEXTURE_CACHE_DIR;	// BC-compressed KTX2 built from PNG/JPEG textures; empty disables
+	bool meshOptimization;					// weld and reorder meshes for the vertex cache, overdraw and fetch
+	VertexLayout vertexLayout;
+	VkDeviceSize textureBudget;				// bytes of streamed texture mips; 0 loads every mip up front
 
 };
@@ -64,6 +64,21 @@ void queueFamilySelect(State* state) {
 			};
 		};
 	PANIC(state->context->queueFamilyIndex == UINT32_MAX, "Failed To Find Queue Family");
+
+	// Prefer a transfer-only (DMA) family for background uploads, then any
+	// non-graphics family with transfer support, then share the graphics queue.
+	state->context->transferFamilyIndex = state->context->queueFamilyIndex;
+	uint32_t bestScore = 0;
+	for (uint32_t queueFamilyIndex = 0; queueFamilyIndex < count; queueFamilyIndex++) {
+		VkQueueFlags flags = queueFamilies[queueFamilyIndex].queueFlags;
+		if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+			continue;
+		uint32_t score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+		if (score > bestScore) {
+			bestScore = score;
+			state->context->transferFamilyIndex = queueFamilyIndex;
+		}
+	}
 	free(queueFamilies);
 };
 
@@ -71,24 +86,37 @@ void deviceCreate(State* state) {
 	physicalDeviceSelect(state);
 	queueFamilySelect(state);
 	float queuePriority = 1.0f;
-	VkDeviceQueueCreateInfo deviceQueueInfo{
-		.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-		.queueFamilyIndex = state->context->queueFamilyIndex,
-		.queueCount = 1,
-		.pQueuePriorities = &queuePriority,
+	VkDeviceQueueCreateInfo deviceQueueInfos[]{
+		{
+			.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+			.queueFamilyIndex = state->context->queueFamilyIndex,
+			.queueCount = 1,
+			.pQueuePriorities = &queuePriority,
+		},
+		{
+			.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+			.queueFamilyIndex = state->context->transferFamilyIndex,
+			.queueCount = 1,
+			.pQueuePriorities = &queuePriority,
+		},
 	};
-	VkDeviceQueueCreateInfo deviceQueueInfos[]{ {} };
+	uint32_t queueInfoCount = state->context->transferFamilyIndex != state->context->queueFamilyIndex ? 2 : 1;
+
+	VkPhysicalDeviceFeatures supported{};
+	vkGetPhysicalDeviceFeatures(state->context->physicalDevice, &supported);
+	state->context->textureCompressionBC = supported.textureCompressionBC == VK_TRUE;
 
 	const char* deviceExtensions{ VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 	VkPhysicalDeviceFeatures deviceFeatures{
 		.independentBlend  = VK_TRUE,
 		.sampleRateShading = VK_TRUE,
 		.samplerAnisotropy = VK_TRUE,
+		.textureCompressionBC = supported.textureCompressionBC,
 	};
 	VkDeviceCreateInfo deviceInfo{
 		.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-		.queueCreateInfoCount = 1,
-		.pQueueCreateInfos = &deviceQueueInfo,
+		.queueCreateInfoCount = queueInfoCount,
+		.pQueueCreateInfos = deviceQueueInfos,
 		.enabledExtensionCount = 1,
 		.ppEnabledExtensionNames = &deviceExtensions,
 		.pEnabledFeatures = &deviceFeatures,
@@ -96,6 +124,7 @@ void deviceCreate(State* state) {
 	PANIC(vkCreateDevice(state->context->physicalDevice, &deviceInfo, nullptr, &state->context->device), "Failed To Create Device");
 	vkGetDeviceQueue(state->context->device, state->context->queueFamilyIndex, 0, &state->context->queue);
 	vkGetDeviceQueue(state->context->device, state->context->presentFamilyIndex, 0, &state->context->presentQueue);
+	vkGetDeviceQueue(state->context->device, state->context->transferFamilyIndex, 0, &state->context->transferQueue);
 	printf("device created = %p\n", (void*)state->context->device);
 
 };
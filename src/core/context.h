@@ -9,12 +9,16 @@ struct Window;
 struct Context{
 	uint32_t queueFamilyIndex;
 	uint32_t presentFamilyIndex;
+	uint32_t transferFamilyIndex;	// dedicated transfer family, or queueFamilyIndex if none
 
 	VkInstance instance;
 	VkPhysicalDevice physicalDevice;
 	VkDevice device;
 	VkQueue queue;
 	VkQueue presentQueue;
+	VkQueue transferQueue;
+
+	bool textureCompressionBC;	// BC1-7 sampled images, target for transcoded textures
 };
 
 void instanceCreate(State* state);
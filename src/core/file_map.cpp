@@ -0,0 +1,135 @@
+#include "core/file_map.h"
+#include "core/hash.h"
+#include <atomic>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool fileMapOpen(const std::string& path, MappedFile& out) {
+	out = MappedFile{};
+
+#ifdef _WIN32
+	// FILE_SHARE_DELETE lets fileReplace rename the file while it is mapped
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	out.data = static_cast<const unsigned char*>(view);
+	out.size = static_cast<size_t>(size.QuadPart);
+	out.fileHandle = file;
+	out.mappingHandle = mapping;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+	out.data = static_cast<const unsigned char*>(view);
+	out.size = static_cast<size_t>(st.st_size);
+	out.fd = fd;
+#endif
+	return true;
+}
+
+void fileMapClose(MappedFile& file) {
+	if (!file.data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(file.data);
+	CloseHandle(file.mappingHandle);
+	CloseHandle(file.fileHandle);
+#else
+	munmap(const_cast<unsigned char*>(file.data), file.size);
+	close(file.fd);
+#endif
+	file = MappedFile{};
+}
+
+bool fileContentHash(const std::string& path, uint64_t& outHash) {
+	MappedFile file;
+	if (!fileMapOpen(path, file))
+		return false;
+
+	outHash = hashBytes(file.data, file.size);
+	fileMapClose(file);
+	return true;
+}
+
+bool fileReplace(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+	if (MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING))
+		return true;
+	// A mapped file cannot be overwritten or deleted, but it can be renamed
+	static std::atomic<uint32_t> serial{ 0 };
+	std::string retired = to + "." + std::to_string(GetCurrentProcessId()) + "_" + std::to_string(serial++) + ".old";
+	if (!MoveFileExA(to.c_str(), retired.c_str(), 0))
+		return false;
+	if (!MoveFileExA(from.c_str(), to.c_str(), 0)) {
+		MoveFileExA(retired.c_str(), to.c_str(), 0);
+		return false;
+	}
+	DeleteFileA(retired.c_str());	// fails while mapped; fileRetiredRemove retries
+	return true;
+#else
+	return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+void fileRetiredRemove(const std::string& path) {
+#ifdef _WIN32
+	std::filesystem::path target(path);
+	std::string prefix = target.filename().string() + ".";
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator(target.parent_path().empty() ? "." : target.parent_path(), ec)) {
+		std::string name = entry.path().filename().string();
+		if (name.size() > prefix.size() + 4 && name.compare(0, prefix.size(), prefix) == 0
+			&& name.compare(name.size() - 4, 4, ".old") == 0)
+			DeleteFileA(entry.path().string().c_str());
+	}
+#else
+	(void)path;
+#endif
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file.
+struct MappedFile {
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int fd = -1;
+#endif
+};
+
+// Mappings do not pin the path: the file can be renamed or replaced while
+// mapped, and the mapping keeps the old contents.
+bool fileMapOpen(const std::string& path, MappedFile& out);
+void fileMapClose(MappedFile& file);
+
+// Atomically renames from over to, even while to is mapped. On Windows a
+// mapped target is first moved aside to to + ".<n>.old" and deleted once
+// nothing maps it (see fileRetiredRemove).
+bool fileReplace(const std::string& from, const std::string& to);
+// Deletes what fileReplace moved aside from path and is no longer mapped.
+void fileRetiredRemove(const std::string& path);
+
+// hashBytes over the file contents; returns false if it cannot be mapped.
+bool fileContentHash(const std::string& path, uint64_t& outHash);
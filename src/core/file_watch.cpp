@@ -0,0 +1,112 @@
+#include "core/file_watch.h"
+#include <unordered_set>
+#include <cstdio>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+static std::string normalizedPath(const std::filesystem::path& path) {
+	std::error_code error;
+	std::filesystem::path absolute = std::filesystem::absolute(path, error);
+	return (error ? path : absolute).lexically_normal().generic_string();
+}
+
+#ifdef __linux__
+void fileWatcherCreate(FileWatcher& watcher) {
+	watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watcher.fd < 0)
+		printf("fileWatcherCreate: inotify unavailable, hot reload disabled\n");
+}
+
+void fileWatcherDestroy(FileWatcher& watcher) {
+	if (watcher.fd >= 0)
+		close(watcher.fd);
+	watcher = FileWatcher{};
+}
+
+void fileWatcherAdd(FileWatcher& watcher, const std::string& path) {
+	std::string key = normalizedPath(path);
+	if (!watcher.paths.emplace(key, path).second || watcher.fd < 0)
+		return;
+
+	std::string directory = std::filesystem::path(key).parent_path().generic_string();
+	if (watcher.directoryWatches.count(directory))
+		return;
+	int wd = inotify_add_watch(watcher.fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (wd < 0) {
+		printf("fileWatcherAdd: cannot watch %s\n", directory.c_str());
+		return;
+	}
+	watcher.directoryWatches[directory] = wd;
+	watcher.directories[wd] = directory;
+}
+
+std::vector<std::string> fileWatcherPoll(FileWatcher& watcher) {
+	std::vector<std::string> changed;
+	if (watcher.fd < 0)
+		return changed;
+
+	std::unordered_set<std::string> seen;
+	alignas(inotify_event) char buffer[4096];
+	for (;;) {
+		ssize_t length = read(watcher.fd, buffer, sizeof(buffer));
+		if (length <= 0)
+			break;
+		for (ssize_t offset = 0; offset < length; ) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			auto directory = watcher.directories.find(event->wd);
+			if (directory == watcher.directories.end() || event->len == 0)
+				continue;
+			auto path = watcher.paths.find(directory->second + "/" + event->name);
+			if (path != watcher.paths.end() && seen.insert(path->first).second)
+				changed.push_back(path->second);
+		}
+	}
+	return changed;
+}
+#else
+// Often enough to feel immediate, rarely enough that stat calls stay cheap
+static constexpr std::chrono::milliseconds POLL_INTERVAL{ 250 };
+
+static std::filesystem::file_time_type writeTime(const std::string& path) {
+	std::error_code error;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+	return error ? std::filesystem::file_time_type{} : time;
+}
+
+void fileWatcherCreate(FileWatcher& watcher) {
+	watcher.lastPoll = std::chrono::steady_clock::now();
+}
+
+void fileWatcherDestroy(FileWatcher& watcher) {
+	watcher = FileWatcher{};
+}
+
+void fileWatcherAdd(FileWatcher& watcher, const std::string& path) {
+	std::string key = normalizedPath(path);
+	if (watcher.paths.emplace(key, path).second)
+		watcher.times[key] = writeTime(key);
+}
+
+std::vector<std::string> fileWatcherPoll(FileWatcher& watcher) {
+	std::vector<std::string> changed;
+	auto now = std::chrono::steady_clock::now();
+	if (now - watcher.lastPoll < POLL_INTERVAL)
+		return changed;
+	watcher.lastPoll = now;
+
+	for (auto& [key, time] : watcher.times) {
+		std::filesystem::file_time_type current = writeTime(key);
+		if (current != time) {
+			time = current;
+			changed.push_back(watcher.paths[key]);
+		}
+	}
+	return changed;
+}
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+
+// Reports edits to a set of files. On Linux, inotify watches each file's
+// directory, so editors that save through a rename are seen too. Elsewhere
+// modification times are polled a few times a second.
+struct FileWatcher {
+	std::unordered_map<std::string, std::string> paths;  // absolute, normalized -> as added
+#ifdef __linux__
+	int fd = -1;
+	std::unordered_map<int, std::string> directories;     // watch descriptor -> absolute directory
+	std::unordered_map<std::string, int> directoryWatches;
+#else
+	std::unordered_map<std::string, std::filesystem::file_time_type> times;
+	std::chrono::steady_clock::time_point lastPoll;
+#endif
+};
+
+void fileWatcherCreate(FileWatcher& watcher);
+void fileWatcherDestroy(FileWatcher& watcher);
+void fileWatcherAdd(FileWatcher& watcher, const std::string& path);
+
+// Paths, as passed to fileWatcherAdd, written since the last call; each
+// appears once however many events it raised. Never blocks.
+std::vector<std::string> fileWatcherPoll(FileWatcher& watcher);
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// 64-bit content hash (xxHash64 construction). Used to key cooked assets and
+// caches by the bytes they were built from; not cryptographic.
+namespace hashdetail {
+	constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+	constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+	constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+	constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+	constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+	inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+	inline uint64_t read64(const unsigned char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+	inline uint32_t read32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+	inline uint64_t round(uint64_t acc, uint64_t lane) { return rotl(acc + lane * P2, 31) * P1; }
+	inline uint64_t merge(uint64_t acc, uint64_t v) { return (acc ^ round(0, v)) * P1 + P4; }
+}
+
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0) {
+	using namespace hashdetail;
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	const unsigned char* end = p + size;
+	uint64_t h;
+
+	if (size >= 32) {
+		uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+		const unsigned char* limit = end - 32;
+		do {
+			v1 = round(v1, read64(p));
+			v2 = round(v2, read64(p + 8));
+			v3 = round(v3, read64(p + 16));
+			v4 = round(v4, read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = merge(h, v1);
+		h = merge(h, v2);
+		h = merge(h, v3);
+		h = merge(h, v4);
+	}
+	else {
+		h = seed + P5;
+	}
+
+	h += size;
+	for (; p + 8 <= end; p += 8)
+		h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+	if (p + 4 <= end) {
+		h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+		p += 4;
+	}
+	for (; p < end; ++p)
+		h = rotl(h ^ (*p * P5), 11) * P1;
+
+	h ^= h >> 33;
+	h *= P2;
+	h ^= h >> 29;
+	h *= P3;
+	h ^= h >> 32;
+	return h;
+}
+
+inline uint64_t hashCombine(uint64_t seed, uint64_t value) {
+	return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
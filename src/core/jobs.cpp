@@ -0,0 +1,133 @@
+#include "core/jobs.h"
+#include "core/state.h"
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <chrono>
+#include <algorithm>
+
+static void workerLoop(JobSystem* jobs) {
+	for (;;) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(jobs->mutex);
+			jobs->wake.wait(lock, [jobs] { return jobs->stopping || !jobs->queue.empty(); });
+			if (jobs->stopping && jobs->queue.empty())
+				return;
+			job = std::move(jobs->queue.front());
+			jobs->queue.pop_front();
+		}
+		job();
+	}
+}
+
+// Pops and runs one queued job on the calling thread. Used while blocking in
+// parallelFor so nested waits from inside a worker can never starve the pool.
+static bool runPendingJob(JobSystem* jobs) {
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(jobs->mutex);
+		if (jobs->queue.empty())
+			return false;
+		job = std::move(jobs->queue.front());
+		jobs->queue.pop_front();
+	}
+	job();
+	return true;
+}
+
+void jobSystemCreate(State* state) {
+	JobSystem* jobs = state->jobs;
+	uint32_t hardware = std::thread::hardware_concurrency();
+	uint32_t workerCount = hardware > 1 ? hardware - 1 : 1;
+
+	jobs->stopping = false;
+	jobs->workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; i++)
+		jobs->workers.emplace_back(workerLoop, jobs);
+
+	printf("jobSystemCreate: %u workers\n", workerCount);
+}
+
+void jobSystemDestroy(State* state) {
+	JobSystem* jobs = state->jobs;
+	{
+		std::lock_guard<std::mutex> lock(jobs->mutex);
+		jobs->stopping = true;
+	}
+	jobs->wake.notify_all();
+	for (std::thread& worker : jobs->workers)
+		worker.join();
+	jobs->workers.clear();
+}
+
+uint32_t jobWorkerCount(const JobSystem* jobs) {
+	return jobs ? static_cast<uint32_t>(jobs->workers.size()) : 0;
+}
+
+void jobSubmit(JobSystem* jobs, std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(jobs->mutex);
+		jobs->queue.push_back(std::move(job));
+	}
+	jobs->wake.notify_one();
+}
+
+void parallelFor(JobSystem* jobs, size_t count, const std::function<void(size_t)>& fn) {
+	if (count == 0)
+		return;
+
+	if (jobWorkerCount(jobs) == 0 || count == 1) {
+		for (size_t i = 0; i < count; i++)
+			fn(i);
+		return;
+	}
+
+	struct Batch {
+		std::atomic<size_t> next{ 0 };
+		std::atomic<uint32_t> running{ 0 };
+		std::mutex mutex;
+		std::condition_variable done;
+		std::exception_ptr error;
+	};
+	auto batch = std::make_shared<Batch>();
+
+	auto drain = [batch, count, &fn]() {
+		for (size_t i = batch->next.fetch_add(1); i < count; i = batch->next.fetch_add(1)) {
+			try {
+				fn(i);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(batch->mutex);
+				if (!batch->error)
+					batch->error = std::current_exception();
+				batch->next.store(count);
+			}
+		}
+	};
+
+	size_t helpers = std::min<size_t>(jobWorkerCount(jobs), count - 1);
+	batch->running.store(static_cast<uint32_t>(helpers));
+	for (size_t h = 0; h < helpers; h++) {
+		jobSubmit(jobs, [batch, drain]() {
+			drain();
+			std::lock_guard<std::mutex> lock(batch->mutex);
+			if (--batch->running == 0)
+				batch->done.notify_all();
+		});
+	}
+
+	drain();
+
+	// Helpers still hold a reference to fn until they exit, so wait for all of
+	// them; run other queued work meanwhile instead of sleeping on it.
+	while (batch->running.load() != 0) {
+		if (runPendingJob(jobs))
+			continue;
+		std::unique_lock<std::mutex> lock(batch->mutex);
+		batch->done.wait_for(lock, std::chrono::milliseconds(1), [&] { return batch->running.load() == 0; });
+	}
+
+	if (batch->error)
+		std::rethrow_exception(batch->error);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+struct State;
+
+// Fixed pool of worker threads fed from a single FIFO queue.
+struct JobSystem {
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> queue;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+};
+
+void jobSystemCreate(State* state);
+void jobSystemDestroy(State* state);
+
+uint32_t jobWorkerCount(const JobSystem* jobs);
+void jobSubmit(JobSystem* jobs, std::function<void()> job);
+
+// Runs fn(i) for every i in [0, count) across the pool. The calling thread
+// takes part and only returns once every index has run; the first exception
+// thrown by fn is rethrown here. Falls back to a serial loop without a pool.
+void parallelFor(JobSystem* jobs, size_t count, const std::function<void(size_t)>& fn);
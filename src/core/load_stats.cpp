@@ -0,0 +1,43 @@
+#include "core/load_stats.h"
+#include "core/state.h"
+
+const char* loadStageName(LoadStage stage) {
+	switch (stage) {
+	case LoadStage::Parse:         return "parse";
+	case LoadStage::ImageDecode:   return "image decode";
+	case LoadStage::TextureUpload: return "texture upload";
+	case LoadStage::Nodes:         return "nodes";
+	case LoadStage::MeshUpload:    return "mesh upload";
+	default:                       return "?";
+	}
+}
+
+void loadStatsReset(LoadStats& stats) {
+	for (std::atomic<uint64_t>& ns : stats.stageNanoseconds)
+		ns = 0;
+	stats.bytesDecoded = 0;
+	stats.bytesUploaded = 0;
+}
+
+void loadStatsAddDecoded(State* state, uint64_t bytes) {
+	if (state->loadStats)
+		state->loadStats->bytesDecoded += bytes;
+}
+
+void loadStatsAddUploaded(State* state, uint64_t bytes) {
+	if (state->loadStats)
+		state->loadStats->bytesUploaded += bytes;
+}
+
+LoadStageTimer::LoadStageTimer(State* state, LoadStage stage)
+	: stats(state->loadStats), stage(stage) {
+	if (stats)
+		start = std::chrono::steady_clock::now();
+}
+
+LoadStageTimer::~LoadStageTimer() {
+	if (!stats)
+		return;
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	stats->stageNanoseconds[(size_t)stage] += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+struct State;
+
+// Loader phases timed for rune-loadbench
+enum class LoadStage : uint32_t {
+	Parse,          // glTF JSON, buffer mapping, meshopt decode
+	ImageDecode,    // PNG/JPEG/KTX2 to a mip chain, summed over workers
+	TextureUpload,  // staging and copying mip chains
+	Nodes,          // node tree, animations and skins
+	MeshUpload,     // accessor decode and mesh optimization into staging, then vertex, index, skin, morph and instance buffers
+	Count,
+};
+
+// Counters loaders add to while state->loadStats is set; the app leaves it
+// null. Thread-safe.
+struct LoadStats {
+	std::array<std::atomic<uint64_t>, (size_t)LoadStage::Count> stageNanoseconds{};
+	std::atomic<uint64_t> bytesDecoded{ 0 };   // texture chains and vertex/index data produced
+	std::atomic<uint64_t> bytesUploaded{ 0 };  // staged for device-local memory
+};
+
+const char* loadStageName(LoadStage stage);
+void loadStatsReset(LoadStats& stats);
+void loadStatsAddDecoded(State* state, uint64_t bytes);
+void loadStatsAddUploaded(State* state, uint64_t bytes);
+
+// Adds the lifetime of the scope to a stage.
+struct LoadStageTimer {
+	LoadStats* stats;
+	LoadStage stage;
+	std::chrono::steady_clock::time_point start;
+
+	LoadStageTimer(State* state, LoadStage stage);
+	~LoadStageTimer();
+};
@@ -20,6 +20,11 @@ struct Scene;
 struct Texture;
 struct Mesh;
 struct Gui;
+struct JobSystem;
+struct ModelLoader;
+struct TextureStreamer;
+struct LoadStats;
+struct StagingArena;
 
 // UBO 
 struct UniformBufferObject {
@@ -64,6 +69,9 @@ struct PushConstantBlock
 	int   thicknessTextureIndex;     // 4
 	int   thicknessTexCoordIndex;    // 4
 	glm::vec4 attenuation;      // replaces vec3 + pad
+
+	glm::vec4 posOffset;             // 16  position = posOffset + inPosition * posScale
+	glm::vec4 posScale;              // 16  (mesh bounds for VertexLayout::CompactQuantized)
 };
 
 
@@ -97,6 +105,11 @@ struct State {
 	Texture *texture;
 	Mesh *mesh;
 	Gui *gui;
+	JobSystem *jobs;
+	ModelLoader *loader;
+	TextureStreamer *streamer;
+	LoadStats *loadStats = nullptr;	// set by rune-loadbench
+	StagingArena *staging = nullptr;	// created by the first synchronous load
 };
 
 enum SwapchainBuffering {
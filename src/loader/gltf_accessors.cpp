@@ -0,0 +1,397 @@
+#include "loader/gltf_accessors.h"
+#include "loader/gltf_accessors_avx2.h"
+#include "tiny_gltf.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define RUNE_ACCESSOR_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(_M_X64) || defined(__x86_64__)
+#define RUNE_ACCESSOR_AVX2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+GltfBuffers gltfBufferSpans(const tinygltf::Model& gltf) {
+	GltfBuffers buffers;
+	buffers.reserve(gltf.buffers.size());
+	for (const tinygltf::Buffer& buffer : gltf.buffers)
+		buffers.emplace_back(buffer.data.data(), buffer.data.size());
+	return buffers;
+}
+
+AccessorView accessorView(const tinygltf::Model& gltf, const GltfBuffers& buffers, int accessorIndex) {
+	if (accessorIndex < 0 || accessorIndex >= (int)gltf.accessors.size())
+		throw std::runtime_error("Accessor index out of range");
+
+	const tinygltf::Accessor& accessor = gltf.accessors[accessorIndex];
+	if (accessor.bufferView < 0)
+		throw std::runtime_error("Accessor without bufferView is not supported");
+
+	if (accessor.bufferView >= (int)gltf.bufferViews.size())
+		throw std::runtime_error("Accessor bufferView out of range");
+
+	const tinygltf::BufferView& bufferView = gltf.bufferViews[accessor.bufferView];
+	if (bufferView.buffer < 0 || bufferView.buffer >= (int)buffers.size())
+		throw std::runtime_error("BufferView buffer out of range");
+	std::span<const unsigned char> buffer = buffers[bufferView.buffer];
+
+	AccessorView view;
+	view.count = accessor.count;
+	view.componentType = accessor.componentType;
+	view.components = tinygltf::GetNumComponentsInType(accessor.type);
+	view.normalized = accessor.normalized;
+
+	int componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+	if (componentSize <= 0 || view.components <= 0)
+		throw std::runtime_error("Unsupported accessor format");
+
+	size_t elementSize = (size_t)componentSize * view.components;
+	view.stride = bufferView.byteStride ? bufferView.byteStride : elementSize;
+
+	size_t offset = bufferView.byteOffset + accessor.byteOffset;
+	if (view.count && offset + (view.count - 1) * view.stride + elementSize > buffer.size())
+		throw std::runtime_error("Accessor reads past the end of its buffer");
+
+	view.data = buffer.data() + offset;
+	return view;
+}
+
+// ─────────────────────────────────────────────
+// CPU features
+// ─────────────────────────────────────────────
+// AVX2 in the CPU and its YMM state saved by the OS
+static bool detectAvx2() {
+#if defined(RUNE_ACCESSOR_AVX2) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(RUNE_ACCESSOR_AVX2)
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+bool accessorCpuHasAvx2() {
+	static const bool hasAvx2 = detectAvx2();
+	return hasAvx2;
+}
+
+// ─────────────────────────────────────────────
+// Scalar conversion
+// ─────────────────────────────────────────────
+// Normalized conversions divide (rather than multiply by a reciprocal) so the
+// SIMD paths produce exactly the same floats as the scalar tail.
+template <typename T, bool Normalized>
+static inline float toFloat(T v) {
+	if constexpr (std::is_same_v<T, float>)
+		return v;
+	else if constexpr (!Normalized)
+		return (float)v;
+	else if constexpr (std::is_same_v<T, uint8_t>)
+		return v / 255.0f;
+	else if constexpr (std::is_same_v<T, uint16_t>)
+		return v / 65535.0f;
+	else if constexpr (std::is_same_v<T, int8_t>)
+		return std::max(v / 127.0f, -1.0f);
+	else
+		return std::max(v / 32767.0f, -1.0f);
+}
+
+template <typename T>
+static constexpr float normalizeScale() {
+	if constexpr (std::is_same_v<T, uint8_t>) return 255.0f;
+	else if constexpr (std::is_same_v<T, uint16_t>) return 65535.0f;
+	else if constexpr (std::is_same_v<T, int8_t>) return 127.0f;
+	else return 32767.0f;
+}
+
+// ─────────────────────────────────────────────
+// Packed stream conversion (n scalars, src contiguous)
+// ─────────────────────────────────────────────
+#ifdef RUNE_ACCESSOR_SSE2
+template <typename T, bool Normalized>
+static inline void storeLanes(float* dst, __m128i lanes) {
+	__m128 f = _mm_cvtepi32_ps(lanes);
+	if constexpr (Normalized) {
+		f = _mm_div_ps(f, _mm_set1_ps(normalizeScale<T>()));
+		if constexpr (std::is_signed_v<T>)
+			f = _mm_max_ps(f, _mm_set1_ps(-1.0f));
+	}
+	_mm_storeu_ps(dst, f);
+}
+#endif
+
+template <typename T, bool Normalized>
+static void convertScalars(const unsigned char* src, float* dst, size_t n) {
+	size_t i = 0;
+
+	if constexpr (std::is_same_v<T, float>) {
+		std::memcpy(dst, src, n * sizeof(float));
+		return;
+	}
+#ifdef RUNE_ACCESSOR_AVX2
+	else if (accessorCpuHasAvx2()) {
+		i = convertScalarsAvx2<T, Normalized>(src, dst, n);
+	}
+#endif
+#ifdef RUNE_ACCESSOR_SSE2
+	else if constexpr (sizeof(T) == 1) {
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= n; i += 16) {
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			__m128i lo, hi;
+			if constexpr (std::is_signed_v<T>) {
+				lo = _mm_srai_epi16(_mm_unpacklo_epi8(b, b), 8);
+				hi = _mm_srai_epi16(_mm_unpackhi_epi8(b, b), 8);
+				storeLanes<T, Normalized>(dst + i + 0, _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16));
+				storeLanes<T, Normalized>(dst + i + 4, _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16));
+				storeLanes<T, Normalized>(dst + i + 8, _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16));
+				storeLanes<T, Normalized>(dst + i + 12, _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16));
+			}
+			else {
+				lo = _mm_unpacklo_epi8(b, zero);
+				hi = _mm_unpackhi_epi8(b, zero);
+				storeLanes<T, Normalized>(dst + i + 0, _mm_unpacklo_epi16(lo, zero));
+				storeLanes<T, Normalized>(dst + i + 4, _mm_unpackhi_epi16(lo, zero));
+				storeLanes<T, Normalized>(dst + i + 8, _mm_unpacklo_epi16(hi, zero));
+				storeLanes<T, Normalized>(dst + i + 12, _mm_unpackhi_epi16(hi, zero));
+			}
+		}
+	}
+	else {
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 8 <= n; i += 8) {
+			__m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+			if constexpr (std::is_signed_v<T>) {
+				storeLanes<T, Normalized>(dst + i + 0, _mm_srai_epi32(_mm_unpacklo_epi16(h, h), 16));
+				storeLanes<T, Normalized>(dst + i + 4, _mm_srai_epi32(_mm_unpackhi_epi16(h, h), 16));
+			}
+			else {
+				storeLanes<T, Normalized>(dst + i + 0, _mm_unpacklo_epi16(h, zero));
+				storeLanes<T, Normalized>(dst + i + 4, _mm_unpackhi_epi16(h, zero));
+			}
+		}
+	}
+#endif
+
+	for (; i < n; ++i) {
+		T v;
+		std::memcpy(&v, src + i * sizeof(T), sizeof(T));
+		dst[i] = toFloat<T, Normalized>(v);
+	}
+}
+
+// ─────────────────────────────────────────────
+// Element kernels
+// ─────────────────────────────────────────────
+template <typename T, int N, int Out, bool Normalized, bool Packed>
+static void decodeKernel(const AccessorView& view, float* dst, size_t dstStride) {
+	unsigned char* out = reinterpret_cast<unsigned char*>(dst);
+
+	if constexpr (Packed) {
+		// Convert the contiguous stream in blocks with SIMD, then scatter the
+		// fixed-size elements into the interleaved destination.
+		constexpr size_t block = 256;
+		float tmp[block * N];
+		for (size_t first = 0; first < view.count; first += block) {
+			size_t n = std::min(block, view.count - first);
+			convertScalars<T, Normalized>(view.data + first * N * sizeof(T), tmp, n * N);
+			for (size_t i = 0; i < n; ++i)
+				std::memcpy(out + (first + i) * dstStride, tmp + i * N, Out * sizeof(float));
+		}
+	}
+	else {
+		for (size_t i = 0; i < view.count; ++i) {
+			T e[N];
+			std::memcpy(e, view.data + i * view.stride, sizeof(e));
+			float f[Out];
+			for (int c = 0; c < Out; ++c)
+				f[c] = toFloat<T, Normalized>(e[c]);
+			std::memcpy(out + i * dstStride, f, sizeof(f));
+		}
+	}
+}
+
+using DecodeFn = void(*)(const AccessorView&, float*, size_t);
+
+template <typename T, int N, int Out>
+static DecodeFn pickKernel(bool normalized, bool packed) {
+	if (normalized)
+		return packed ? decodeKernel<T, N, Out, true, true> : decodeKernel<T, N, Out, true, false>;
+	return packed ? decodeKernel<T, N, Out, false, true> : decodeKernel<T, N, Out, false, false>;
+}
+
+template <int N, int Out>
+static DecodeFn pickComponentType(const AccessorView& view) {
+	bool packed = view.stride == N * (size_t)tinygltf::GetComponentSizeInBytes(view.componentType);
+
+	switch (view.componentType) {
+	case TINYGLTF_COMPONENT_TYPE_FLOAT:          return pickKernel<float, N, Out>(false, packed);
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  return pickKernel<uint8_t, N, Out>(view.normalized, packed);
+	case TINYGLTF_COMPONENT_TYPE_BYTE:           return pickKernel<int8_t, N, Out>(view.normalized, packed);
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return pickKernel<uint16_t, N, Out>(view.normalized, packed);
+	case TINYGLTF_COMPONENT_TYPE_SHORT:          return pickKernel<int16_t, N, Out>(view.normalized, packed);
+	default:
+		throw std::runtime_error("Unsupported componentType for float conversion");
+	}
+}
+
+void accessorReadFloats(const AccessorView& view, float* dst, size_t dstStride, int outComponents) {
+	DecodeFn kernel = nullptr;
+
+	switch (view.components * 8 + outComponents) {
+	case 1 * 8 + 1: kernel = pickComponentType<1, 1>(view); break;
+	case 2 * 8 + 2: kernel = pickComponentType<2, 2>(view); break;
+	case 3 * 8 + 3: kernel = pickComponentType<3, 3>(view); break;
+	case 4 * 8 + 3: kernel = pickComponentType<4, 3>(view); break;
+	case 4 * 8 + 4: kernel = pickComponentType<4, 4>(view); break;
+	default:
+		throw std::runtime_error("Unsupported accessor component count");
+	}
+
+	kernel(view, dst, dstStride);
+}
+
+// ─────────────────────────────────────────────
+// Indices
+// ─────────────────────────────────────────────
+template <typename T>
+static void widenIndices(const unsigned char* src, uint32_t* dst, size_t n, uint32_t baseVertex) {
+	size_t i = 0;
+
+#ifdef RUNE_ACCESSOR_AVX2
+	if (accessorCpuHasAvx2())
+		i = widenIndicesAvx2<T>(src, dst, n, baseVertex);
+#endif
+#ifdef RUNE_ACCESSOR_SSE2
+	const __m128i base = _mm_set1_epi32((int)baseVertex);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= n; i += 16) {
+		__m128i* out = reinterpret_cast<__m128i*>(dst + i);
+		if constexpr (sizeof(T) == 1) {
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			__m128i lo = _mm_unpacklo_epi8(b, zero);
+			__m128i hi = _mm_unpackhi_epi8(b, zero);
+			_mm_storeu_si128(out + 0, _mm_add_epi32(_mm_unpacklo_epi16(lo, zero), base));
+			_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_unpackhi_epi16(lo, zero), base));
+			_mm_storeu_si128(out + 2, _mm_add_epi32(_mm_unpacklo_epi16(hi, zero), base));
+			_mm_storeu_si128(out + 3, _mm_add_epi32(_mm_unpackhi_epi16(hi, zero), base));
+		}
+		else if constexpr (sizeof(T) == 2) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2 + 16));
+			_mm_storeu_si128(out + 0, _mm_add_epi32(_mm_unpacklo_epi16(a, zero), base));
+			_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_unpackhi_epi16(a, zero), base));
+			_mm_storeu_si128(out + 2, _mm_add_epi32(_mm_unpacklo_epi16(b, zero), base));
+			_mm_storeu_si128(out + 3, _mm_add_epi32(_mm_unpackhi_epi16(b, zero), base));
+		}
+		else {
+			for (int k = 0; k < 4; ++k) {
+				__m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + k * 16));
+				_mm_storeu_si128(out + k, _mm_add_epi32(w, base));
+			}
+		}
+	}
+#endif
+
+	for (; i < n; ++i) {
+		T v;
+		std::memcpy(&v, src + i * sizeof(T), sizeof(T));
+		dst[i] = baseVertex + v;
+	}
+}
+
+void accessorReadIndices(const AccessorView& view, uint32_t* dst, uint32_t baseVertex) {
+	if (view.components != 1)
+		throw std::runtime_error("Index accessor must be SCALAR");
+	if (view.stride != (size_t)tinygltf::GetComponentSizeInBytes(view.componentType))
+		throw std::runtime_error("Index accessor must be tightly packed");
+
+	switch (view.componentType) {
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  widenIndices<uint8_t>(view.data, dst, view.count, baseVertex); break;
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: widenIndices<uint16_t>(view.data, dst, view.count, baseVertex); break;
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:   widenIndices<uint32_t>(view.data, dst, view.count, baseVertex); break;
+	default: throw std::runtime_error("Unsupported index type");
+	}
+}
+
+// ─────────────────────────────────────────────
+// Sparse accessors
+// ─────────────────────────────────────────────
+static AccessorView sparseView(const tinygltf::Model& gltf, const GltfBuffers& buffers, int bufferView, size_t byteOffset,
+	size_t count, int componentType, int components, bool normalized) {
+	if (bufferView < 0 || bufferView >= (int)gltf.bufferViews.size())
+		throw std::runtime_error("Sparse accessor bufferView out of range");
+	const tinygltf::BufferView& view = gltf.bufferViews[bufferView];
+	if (view.buffer < 0 || view.buffer >= (int)buffers.size())
+		throw std::runtime_error("BufferView buffer out of range");
+	std::span<const unsigned char> buffer = buffers[view.buffer];
+
+	int componentSize = tinygltf::GetComponentSizeInBytes(componentType);
+	if (componentSize <= 0)
+		throw std::runtime_error("Unsupported sparse accessor format");
+
+	AccessorView out;
+	out.count = count;
+	out.componentType = componentType;
+	out.components = components;
+	out.normalized = normalized;
+	out.stride = (size_t)componentSize * components;   // sparse data is tightly packed
+	size_t offset = view.byteOffset + byteOffset;
+	if (count && offset + count * out.stride > buffer.size())
+		throw std::runtime_error("Sparse accessor reads past the end of its buffer");
+	out.data = buffer.data() + offset;
+	return out;
+}
+
+void accessorReadFloatsSparse(const tinygltf::Model& gltf, const GltfBuffers& buffers, int accessorIndex,
+	size_t count, float* dst, size_t dstStride, int outComponents) {
+	if (accessorIndex < 0 || accessorIndex >= (int)gltf.accessors.size())
+		throw std::runtime_error("Accessor index out of range");
+	const tinygltf::Accessor& accessor = gltf.accessors[accessorIndex];
+	if (accessor.count != count)
+		throw std::runtime_error("Accessor count does not match its attribute");
+
+	unsigned char* out = reinterpret_cast<unsigned char*>(dst);
+	if (accessor.bufferView >= 0) {
+		accessorReadFloats(accessorView(gltf, buffers, accessorIndex), dst, dstStride, outComponents);
+	}
+	else {
+		for (size_t i = 0; i < count; i++)
+			std::fill_n(reinterpret_cast<float*>(out + i * dstStride), outComponents, 0.0f);
+	}
+	if (!accessor.sparse.isSparse || accessor.sparse.count <= 0)
+		return;
+
+	size_t sparseCount = (size_t)accessor.sparse.count;
+	AccessorView indexView = sparseView(gltf, buffers, accessor.sparse.indices.bufferView, accessor.sparse.indices.byteOffset,
+		sparseCount, accessor.sparse.indices.componentType, 1, false);
+	AccessorView valueView = sparseView(gltf, buffers, accessor.sparse.values.bufferView, accessor.sparse.values.byteOffset,
+		sparseCount, accessor.componentType, tinygltf::GetNumComponentsInType(accessor.type), accessor.normalized);
+
+	std::vector<uint32_t> indices(sparseCount);
+	accessorReadIndices(indexView, indices.data(), 0);
+	std::vector<float> values(sparseCount * outComponents);
+	accessorReadFloats(valueView, values.data(), outComponents * sizeof(float), outComponents);
+
+	for (size_t i = 0; i < sparseCount; i++) {
+		if (indices[i] >= count)
+			throw std::runtime_error("Sparse accessor index out of range");
+		memcpy(out + indices[i] * dstStride, &values[i * outComponents], outComponents * sizeof(float));
+	}
+}
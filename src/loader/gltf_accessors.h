@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace tinygltf {
+	class Model;
+}
+
+// Bytes of every glTF buffer, indexed like gltf.buffers. Normally views into
+// file mappings (see GltfSource) rather than tinygltf::Buffer::data.
+using GltfBuffers = std::vector<std::span<const unsigned char>>;
+
+// Spans over tinygltf::Buffer::data, for models tinygltf loaded itself.
+GltfBuffers gltfBufferSpans(const tinygltf::Model& gltf);
+
+// Resolved accessor: first element, element stride and format.
+struct AccessorView {
+	const unsigned char* data = nullptr;
+	size_t count = 0;
+	size_t stride = 0;
+	int componentType = 0;
+	int components = 0;
+	bool normalized = false;
+};
+
+AccessorView accessorView(const tinygltf::Model& gltf, const GltfBuffers& buffers, int accessorIndex);
+
+// Converts every element to outComponents floats (outComponents <= components)
+// written to dst, advancing dstStride bytes per element. The kernel is picked
+// once per call from (componentType, components, outComponents, normalized,
+// packed/interleaved), so the element loop itself never branches on format.
+void accessorReadFloats(const AccessorView& view, float* dst, size_t dstStride, int outComponents);
+
+// accessorReadFloats over a whole accessor of count elements, with its
+// sparse substitutions applied. Without a bufferView the base is all zeros,
+// as is common for morph targets.
+void accessorReadFloatsSparse(const tinygltf::Model& gltf, const GltfBuffers& buffers, int accessorIndex,
+	size_t count, float* dst, size_t dstStride, int outComponents);
+
+// Widens u8/u16/u32 indices to u32 and adds baseVertex.
+void accessorReadIndices(const AccessorView& view, uint32_t* dst, uint32_t baseVertex);
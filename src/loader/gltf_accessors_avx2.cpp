@@ -0,0 +1,109 @@
+// Built with AVX2 code generation: /arch:AVX2 on this file in the project,
+// a target pragma elsewhere. Nothing here may run unless
+// accessorCpuHasAvx2(), so the file defines only its own kernels and pulls
+// in no inline library code another translation unit could end up sharing.
+#include "loader/gltf_accessors_avx2.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#if defined(__clang__) && !defined(__AVX2__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#define RUNE_AVX2_PRAGMA_POP 1
+#elif defined(__GNUC__) && !defined(__AVX2__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define RUNE_AVX2_PRAGMA_POP 1
+#endif
+#include <immintrin.h>
+
+template <typename T>
+static constexpr bool isSigned() {
+	return T(-1) < T(0);
+}
+
+template <typename T>
+static constexpr float normalizeScale() {
+	if constexpr (sizeof(T) == 1) return isSigned<T>() ? 127.0f : 255.0f;
+	else return isSigned<T>() ? 32767.0f : 65535.0f;
+}
+
+template <typename T, bool Normalized>
+static inline void storeLanes8(float* dst, __m256i lanes) {
+	__m256 f = _mm256_cvtepi32_ps(lanes);
+	if constexpr (Normalized) {
+		f = _mm256_div_ps(f, _mm256_set1_ps(normalizeScale<T>()));
+		if constexpr (isSigned<T>())
+			f = _mm256_max_ps(f, _mm256_set1_ps(-1.0f));
+	}
+	_mm256_storeu_ps(dst, f);
+}
+
+template <typename T, bool Normalized>
+size_t convertScalarsAvx2(const unsigned char* src, float* dst, size_t n) {
+	size_t i = 0;
+	if constexpr (sizeof(T) == 1) {
+		for (; i + 8 <= n; i += 8) {
+			__m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+			__m256i w = isSigned<T>() ? _mm256_cvtepi8_epi32(b) : _mm256_cvtepu8_epi32(b);
+			storeLanes8<T, Normalized>(dst + i, w);
+		}
+	}
+	else {
+		for (; i + 8 <= n; i += 8) {
+			__m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+			__m256i w = isSigned<T>() ? _mm256_cvtepi16_epi32(h) : _mm256_cvtepu16_epi32(h);
+			storeLanes8<T, Normalized>(dst + i, w);
+		}
+	}
+	return i;
+}
+
+template <typename T>
+size_t widenIndicesAvx2(const unsigned char* src, uint32_t* dst, size_t n, uint32_t baseVertex) {
+	const __m256i base = _mm256_set1_epi32((int)baseVertex);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i w;
+		if constexpr (sizeof(T) == 1)
+			w = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+		else if constexpr (sizeof(T) == 2)
+			w = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2)));
+		else
+			w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_add_epi32(w, base));
+	}
+	return i;
+}
+
+#else
+// No AVX2 on this architecture; accessorCpuHasAvx2() is always false
+template <typename T, bool Normalized>
+size_t convertScalarsAvx2(const unsigned char*, float*, size_t) {
+	return 0;
+}
+
+template <typename T>
+size_t widenIndicesAvx2(const unsigned char*, uint32_t*, size_t, uint32_t) {
+	return 0;
+}
+#endif
+
+template size_t convertScalarsAvx2<uint8_t, false>(const unsigned char*, float*, size_t);
+template size_t convertScalarsAvx2<uint8_t, true>(const unsigned char*, float*, size_t);
+template size_t convertScalarsAvx2<int8_t, false>(const unsigned char*, float*, size_t);
+template size_t convertScalarsAvx2<int8_t, true>(const unsigned char*, float*, size_t);
+template size_t convertScalarsAvx2<uint16_t, false>(const unsigned char*, float*, size_t);
+template size_t convertScalarsAvx2<uint16_t, true>(const unsigned char*, float*, size_t);
+template size_t convertScalarsAvx2<int16_t, false>(const unsigned char*, float*, size_t);
+template size_t convertScalarsAvx2<int16_t, true>(const unsigned char*, float*, size_t);
+
+template size_t widenIndicesAvx2<uint8_t>(const unsigned char*, uint32_t*, size_t, uint32_t);
+template size_t widenIndicesAvx2<uint16_t>(const unsigned char*, uint32_t*, size_t, uint32_t);
+template size_t widenIndicesAvx2<uint32_t>(const unsigned char*, uint32_t*, size_t, uint32_t);
+
+#ifdef RUNE_AVX2_PRAGMA_POP
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
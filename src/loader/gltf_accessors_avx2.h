@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// AVX2 accessor kernels, compiled on their own with AVX2 enabled and only
+// called when accessorCpuHasAvx2() says the CPU and OS support it. Each
+// converts the largest multiple of 8 elements of n and returns that count;
+// the caller finishes the tail.
+
+bool accessorCpuHasAvx2();
+
+// n scalars of T to floats, normalized like toFloat in gltf_accessors.cpp
+template <typename T, bool Normalized>
+size_t convertScalarsAvx2(const unsigned char* src, float* dst, size_t n);
+
+// n u8/u16/u32 indices to u32 plus baseVertex
+template <typename T>
+size_t widenIndicesAvx2(const unsigned char* src, uint32_t* dst, size_t n, uint32_t baseVertex);
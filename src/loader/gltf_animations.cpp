@@ -0,0 +1,131 @@
+#include "loader/gltf_animations.h"
+#include "scene/animation.h"
+#include "resources/animation_pack.h"
+#include "scene/model.h"
+#include "scene/node.h"
+#include "tiny_gltf.h"
+#include <algorithm>
+#include <stdexcept>
+
+static bool trackPath(const std::string& path, AnimationTrack::Path& out) {
+	if (path == "translation") out = AnimationTrack::TRANSLATION;
+	else if (path == "rotation") out = AnimationTrack::ROTATION;
+	else if (path == "scale") out = AnimationTrack::SCALE;
+	else if (path == "weights") out = AnimationTrack::WEIGHTS;
+	else return false;
+	return true;
+}
+
+static AnimationTrack::Interpolation trackInterpolation(const std::string& interpolation) {
+	if (interpolation == "STEP") return AnimationTrack::STEP;
+	if (interpolation == "CUBICSPLINE") return AnimationTrack::CUBICSPLINE;
+	return AnimationTrack::LINEAR;
+}
+
+// A weights sampler outputs every morph target of the node per key; it is
+// split into vec4 tracks of four targets each for the batched kernels.
+static void addWeightTracks(std::vector<RawAnimationTrack>& tracks, const RawAnimationTrack& source, const AccessorView& output, size_t valueCount) {
+	size_t targets = source.track.node->morphWeights.size();
+	if (targets == 0)
+		return;
+	if (output.components != 1 || output.count != valueCount * targets)
+		throw std::runtime_error("Animation weights output does not match its input and morph targets");
+
+	std::vector<float> weights(output.count);
+	accessorReadFloats(output, weights.data(), sizeof(float), 1);
+	for (size_t first = 0; first < targets; first += 4) {
+		RawAnimationTrack& raw = tracks.emplace_back(source);
+		raw.track.firstWeight = (uint32_t)first;
+		raw.values.assign(valueCount, glm::vec4(0.0f));
+		for (size_t k = 0; k < valueCount; k++) {
+			for (size_t c = 0; c < 4 && first + c < targets; c++)
+				raw.values[k][(int)c] = weights[k * targets + first + c];
+		}
+	}
+}
+
+void parseAnimations(const tinygltf::Model& gltf, const GltfBuffers& buffers, Model* model) {
+	model->animations.reserve(gltf.animations.size());
+
+	for (const tinygltf::Animation& source : gltf.animations) {
+		Animation animation;
+		animation.name = source.name;
+		std::vector<RawAnimationTrack> tracks;
+
+		for (const tinygltf::AnimationChannel& channel : source.channels) {
+			RawAnimationTrack raw;
+			AnimationTrack& track = raw.track;
+			if (!trackPath(channel.target_path, track.path))
+				continue;
+			if (channel.target_node < 0 || channel.target_node >= (int)model->nodes.size() || !model->nodes[channel.target_node])
+				continue;
+			if (channel.sampler < 0 || channel.sampler >= (int)source.samplers.size())
+				throw std::runtime_error("Animation channel sampler out of range");
+
+			const tinygltf::AnimationSampler& sampler = source.samplers[channel.sampler];
+			track.node = model->nodes[channel.target_node];
+			track.interpolation = trackInterpolation(sampler.interpolation);
+
+			AccessorView input = accessorView(gltf, buffers, sampler.input);
+			if (input.components != 1 || input.count == 0)
+				throw std::runtime_error("Animation sampler input must be a non-empty SCALAR accessor");
+			raw.times.resize(input.count);
+			accessorReadFloats(input, raw.times.data(), sizeof(float), 1);
+
+			size_t valueCount = input.count * (track.interpolation == AnimationTrack::CUBICSPLINE ? 3 : 1);
+			AccessorView output = accessorView(gltf, buffers, sampler.output);
+			if (track.path == AnimationTrack::WEIGHTS) {
+				addWeightTracks(tracks, raw, output, valueCount);
+				continue;
+			}
+
+			int components = track.path == AnimationTrack::ROTATION ? 4 : 3;
+			if (output.components != components || output.count != valueCount)
+				throw std::runtime_error("Animation sampler output does not match its input and path");
+
+			raw.values.assign(valueCount, glm::vec4(0.0f));
+			accessorReadFloats(output, &raw.values[0].x, sizeof(glm::vec4), components);
+			tracks.push_back(std::move(raw));
+		}
+
+		packAnimation(animation, tracks);
+		model->animations.push_back(std::move(animation));
+	}
+}
+
+void parseSkins(const tinygltf::Model& gltf, const GltfBuffers& buffers, Model* model) {
+	model->skins.resize(gltf.skins.size());
+
+	for (size_t i = 0; i < gltf.skins.size(); i++) {
+		const tinygltf::Skin& source = gltf.skins[i];
+		Skin& skin = model->skins[i];
+		skin.name = source.name;
+
+		skin.joints.reserve(source.joints.size());
+		for (int joint : source.joints)
+			skin.joints.push_back(joint >= 0 && joint < (int)model->nodes.size() ? model->nodes[joint] : nullptr);
+
+		// Without inverseBindMatrices every joint's is identity
+		skin.inverseBindMatrices.assign(source.joints.size(), glm::mat4(1.0f));
+		if (source.inverseBindMatrices >= 0) {
+			AccessorView view = accessorView(gltf, buffers, source.inverseBindMatrices);
+			if (view.components != 16 || view.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || view.count < source.joints.size())
+				throw std::runtime_error("Skin inverseBindMatrices must be a float MAT4 per joint");
+
+			// Read as four interleaved vec4 columns
+			view.count = source.joints.size();
+			view.components = 4;
+			for (int column = 0; column < 4 && view.count > 0; column++) {
+				AccessorView columnView = view;
+				columnView.data += column * sizeof(glm::vec4);
+				accessorReadFloats(columnView, glm::value_ptr(skin.inverseBindMatrices[0][column]), sizeof(glm::mat4), 4);
+			}
+		}
+	}
+
+	// Node::skin came straight from the file
+	for (Node* node : model->nodes) {
+		if (node && node->skin >= (int32_t)model->skins.size())
+			node->skin = -1;
+	}
+}
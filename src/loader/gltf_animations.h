@@ -0,0 +1,17 @@
+#pragma once
+#include "loader/gltf_accessors.h"
+
+namespace tinygltf {
+	class Model;
+}
+
+struct Model;
+
+// Imports gltf.animations into model->animations as compressed
+// structure-of-arrays clips (see packAnimation). Needs model->nodes from
+// parseSceneNodes; channels targeting nodes outside the scene are skipped.
+void parseAnimations(const tinygltf::Model& gltf, const GltfBuffers& buffers, Model* model);
+
+// Imports gltf.skins into model->skins (same indices as Node::skin). Also
+// needs model->nodes.
+void parseSkins(const tinygltf::Model& gltf, const GltfBuffers& buffers, Model* model);
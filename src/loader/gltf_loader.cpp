@@ -7,19 +7,31 @@
 #include "loader/gltf_loader.h"
 #include "loader/gltf_textures.h"
 #include "loader/gltf_nodes.h"
+#include "loader/gltf_animations.h"
 #include "loader/gltf_meshes.h"
 #include "loader/gltf_materials.h"
+#include "loader/runepak.h"
+#include "loader/meshopt_decode.h"
 #include "resources/images.h"
 #include "resources/buffers.h"
+#include "render/skinning.h"
 #include "scene/texture.h"
 #include "scene/materials.h"
 #include "scene/mesh.h"
 #include "scene/model.h"
 #include "scene/scene.h"
+#include "scene/transforms.h"
 #include "core/config.h"
 #include "core/context.h"
 #include "core/state.h"
+#include "core/file_map.h"
+#include "core/jobs.h"
+#include "core/load_stats.h"
 #include <vector>
+#include <span>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
 //Utility
 std::string extractBaseDir(const std::string& path){
 	size_t pos = path.find_last_of("/\\");
@@ -31,38 +43,304 @@ std::string extractBaseDir(const std::string& path){
 void loadModel(State* state, std::string modelPath)
 {
 	Model* model = new Model{};
+
+	// Prefer the cooked package; (re)cook it when missing or the source changed.
+	uint64_t sourceHash = 0;
+	if (fileContentHash(modelPath, sourceHash)) {
+		std::string pakPath = runepakPath(modelPath);
+		bool loaded = runepakLoad(state, pakPath, sourceHash, model);
+		if (!loaded && runepakCook(state, modelPath, pakPath, sourceHash))
+			loaded = runepakLoad(state, pakPath, sourceHash, model);
+		if (loaded) {
+			state->scene->models.push_back(model);
+			return;
+		}
+	}
+
+	loadModelFromGltf(state, model, modelPath);
+	state->scene->models.push_back(model);
+};
+void loadModelFromGltf(State* state, Model* model, const std::string& modelPath)
+{
 	model->rootNode = new Node();
 	model->rootNode->name = "Root";
-	tinygltf::Model gltf = loadGltf(modelPath);
+	GltfSource source;
+	tinygltf::Model gltf;
 	std::unordered_map<int, TextureRole> textureRoles;
-	parseMaterials(state, model, gltf, textureRoles);
+	std::vector<Material*> materials;
+	{
+		LoadStageTimer timer(state, LoadStage::Parse);
+		gltf = loadGltf(modelPath, source, state->jobs);
+		materials = parseMaterials(gltf, textureRoles);
+	}
+	createModelTextures(state, model, gltf, source, textureRoles);
+	for (Material* mat : materials)
+		model->materialIndices.push_back(sceneInternMaterial(state->scene, mat, model->textureIndices));
 	std::string baseDir = extractBaseDir(modelPath);
-	parseSceneNodes(gltf, model, baseDir);
-	createMeshBuffers(state, model->rootNode);
-	createModelTextures(state, model, gltf, textureRoles);
-	state->scene->models.push_back(model);
+	std::vector<PrimitiveJob> primitives;
+	{
+		LoadStageTimer timer(state, LoadStage::Nodes);
+		buildSceneNodes(gltf, source.buffers, model, baseDir, primitives);
+		modelTransformsInit(model);
+		parseAnimations(gltf, source.buffers, model);
+		parseSkins(gltf, source.buffers, model);
+	}
+	{
+		LoadStageTimer timer(state, LoadStage::MeshUpload);
+		decodeMeshBuffers(state, gltf, source.buffers, model, primitives);
+		createInstanceBuffer(state, model);
+		skinningCreate(state, model);
+	}
+	gltfSourceClose(source);
 };
-tinygltf::Model loadGltf(std::string modelPath) {
+// ─────────────────────────────────────────────
+// Mapped glTF source
+// ─────────────────────────────────────────────
+static constexpr uint32_t GLB_MAGIC = 0x46546C67;       // "glTF"
+static constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+static constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;   // "BIN\0"
+
+static uint32_t readU32(const unsigned char* p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static std::span<const unsigned char> mapSourceFile(GltfSource& source, const std::string& path) {
+	MappedFile file;
+	if (!fileMapOpen(path, file))
+		throw std::runtime_error("Failed to map " + path);
+	source.files.push_back(file);
+	source.paths.push_back(path);
+	return { file.data, file.size };
+}
+
+// Splits a .glb into its JSON and (optional) BIN chunk without copying.
+static void splitGlb(std::span<const unsigned char> file, std::span<const unsigned char>& json, std::span<const unsigned char>& bin) {
+	if (file.size() < 20 || readU32(file.data()) != GLB_MAGIC || readU32(file.data() + 4) != 2)
+		throw std::runtime_error("Invalid GLB header");
+
+	size_t length = std::min<size_t>(readU32(file.data() + 8), file.size());
+	size_t offset = 12;
+	while (offset + 8 <= length) {
+		uint32_t chunkLength = readU32(file.data() + offset);
+		uint32_t chunkType = readU32(file.data() + offset + 4);
+		offset += 8;
+		if (chunkLength > length - offset)
+			throw std::runtime_error("GLB chunk runs past the end of the file");
+
+		if (chunkType == GLB_CHUNK_JSON && json.empty())
+			json = file.subspan(offset, chunkLength);
+		else if (chunkType == GLB_CHUNK_BIN && bin.empty())
+			bin = file.subspan(offset, chunkLength);
+		offset += (chunkLength + 3) & ~3u;
+	}
+	if (json.empty())
+		throw std::runtime_error("GLB has no JSON chunk");
+}
+
+static std::string percentDecode(const std::string& uri) {
+	std::string out;
+	out.reserve(uri.size());
+	for (size_t i = 0; i < uri.size(); i++) {
+		if (uri[i] == '%' && i + 2 < uri.size() && isxdigit((unsigned char)uri[i + 1]) && isxdigit((unsigned char)uri[i + 2])) {
+			out += (char)std::stoi(uri.substr(i + 1, 2), nullptr, 16);
+			i += 2;
+		}
+		else {
+			out += uri[i];
+		}
+	}
+	return out;
+}
+
+static void base64Decode(const std::string& in, size_t start, std::vector<unsigned char>& out) {
+	auto value = [](char c) -> int {
+		if (c >= 'A' && c <= 'Z') return c - 'A';
+		if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+		if (c >= '0' && c <= '9') return c - '0' + 52;
+		if (c == '+') return 62;
+		if (c == '/') return 63;
+		return -1;
+	};
+
+	out.reserve((in.size() - start) / 4 * 3);
+	uint32_t bits = 0;
+	int count = 0;
+	for (size_t i = start; i < in.size() && in[i] != '='; i++) {
+		int v = value(in[i]);
+		if (v < 0)
+			throw std::runtime_error("Invalid base64 in data URI");
+		bits = (bits << 6) | (uint32_t)v;
+		if (++count == 4) {
+			out.push_back((unsigned char)(bits >> 16));
+			out.push_back((unsigned char)(bits >> 8));
+			out.push_back((unsigned char)bits);
+			bits = 0;
+			count = 0;
+		}
+	}
+	if (count == 2) {
+		out.push_back((unsigned char)(bits >> 4));
+	}
+	else if (count == 3) {
+		out.push_back((unsigned char)(bits >> 10));
+		out.push_back((unsigned char)(bits >> 2));
+	}
+}
+
+// data: URIs are decoded into the source; anything else is mapped from baseDir.
+static std::span<const unsigned char> resolveUri(GltfSource& source, const std::string& uri, const std::string& baseDir) {
+	if (uri.rfind("data:", 0) == 0) {
+		size_t comma = uri.find(',');
+		if (comma == std::string::npos || comma < 7 || uri.compare(comma - 7, 7, ";base64") != 0)
+			throw std::runtime_error("Only base64 data URIs are supported");
+
+		std::vector<unsigned char>& bytes = source.decoded.emplace_back();
+		base64Decode(uri, comma + 1, bytes);
+		return { bytes.data(), bytes.size() };
+	}
+	return mapSourceFile(source, baseDir + percentDecode(uri));
+}
+
+void decodeGltfImage(std::span<const unsigned char> bytes, tinygltf::Image& image) {
+	int width = 0, height = 0, channels = 0;
+	stbi_uc* pixels = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &channels, STBI_rgb_alpha);
+	if (!pixels)
+		throw std::runtime_error("Failed to decode image '" + image.name + "': " + stbi_failure_reason());
+
+	image.width = width;
+	image.height = height;
+	image.component = 4;
+	image.bits = 8;
+	image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+	image.image.assign(pixels, pixels + (size_t)width * height * 4);
+	stbi_image_free(pixels);
+}
+
+void gltfSourceClose(GltfSource& source) {
+	for (MappedFile& file : source.files)
+		fileMapClose(file);
+	source = GltfSource{};
+}
+
+// ─────────────────────────────────────────────
+// EXT_meshopt_compression
+// ─────────────────────────────────────────────
+static const nlohmann::json* meshoptExtension(const nlohmann::json& object) {
+	auto extensions = object.find("extensions");
+	if (extensions == object.end() || !extensions->is_object())
+		return nullptr;
+	auto extension = extensions->find("EXT_meshopt_compression");
+	return extension != extensions->end() && extension->is_object() ? &*extension : nullptr;
+}
+
+static MeshoptMode meshoptMode(const std::string& mode) {
+	if (mode == "ATTRIBUTES") return MeshoptMode::Attributes;
+	if (mode == "TRIANGLES") return MeshoptMode::Triangles;
+	if (mode == "INDICES") return MeshoptMode::Indices;
+	throw std::runtime_error("Unknown EXT_meshopt_compression mode " + mode);
+}
+
+static MeshoptFilter meshoptFilter(const std::string& filter) {
+	if (filter == "NONE") return MeshoptFilter::None;
+	if (filter == "OCTAHEDRAL") return MeshoptFilter::Octahedral;
+	if (filter == "QUATERNION") return MeshoptFilter::Quaternion;
+	if (filter == "EXPONENTIAL") return MeshoptFilter::Exponential;
+	throw std::runtime_error("Unknown EXT_meshopt_compression filter " + filter);
+}
+
+// Decodes every compressed bufferView into its place in the fallback buffer.
+// writable[i] is the decoded storage of buffer i, or null when the buffer
+// carries real bytes (then the uncompressed fallback data is used as-is).
+static void decodeMeshoptViews(const nlohmann::json& bufferViews, const GltfBuffers& buffers,
+	const std::vector<unsigned char*>& writable, JobSystem* jobs)
+{
+	struct Pending {
+		MeshoptStream stream;
+		unsigned char* target;
+		size_t index;
+	};
+	std::vector<Pending> pending;
+
+	for (size_t i = 0; i < bufferViews.size(); i++) {
+		const nlohmann::json* extension = meshoptExtension(bufferViews[i]);
+		if (!extension)
+			continue;
+
+		int target = bufferViews[i].value("buffer", -1);
+		if (target < 0 || target >= (int)buffers.size())
+			throw std::runtime_error("Compressed bufferView " + std::to_string(i) + " has an invalid buffer");
+		if (!writable[target])
+			continue;
+
+		int source = extension->value("buffer", -1);
+		size_t sourceOffset = extension->value("byteOffset", (size_t)0);
+		size_t sourceLength = extension->value("byteLength", (size_t)0);
+		if (source < 0 || source >= (int)buffers.size() || sourceOffset + sourceLength > buffers[source].size())
+			throw std::runtime_error("Compressed bufferView " + std::to_string(i) + " reads past its buffer");
+
+		Pending p;
+		p.index = i;
+		p.stream.data = buffers[source].data() + sourceOffset;
+		p.stream.size = sourceLength;
+		p.stream.count = extension->value("count", (size_t)0);
+		p.stream.stride = extension->value("byteStride", (size_t)0);
+		p.stream.mode = meshoptMode(extension->value("mode", std::string()));
+		p.stream.filter = meshoptFilter(extension->value("filter", std::string("NONE")));
+
+		size_t targetOffset = bufferViews[i].value("byteOffset", (size_t)0);
+		size_t decodedSize = p.stream.count * p.stream.stride;
+		if (decodedSize > bufferViews[i].value("byteLength", (size_t)0) ||
+			targetOffset + decodedSize > buffers[target].size())
+			throw std::runtime_error("Compressed bufferView " + std::to_string(i) + " decodes past its buffer");
+		p.target = writable[target] + targetOffset;
+		pending.push_back(p);
+	}
+
+	// Views never overlap, so each decodes straight into place
+	parallelFor(jobs, pending.size(), [&](size_t i) {
+		if (!meshoptDecode(pending[i].stream, pending[i].target))
+			throw std::runtime_error("Failed to decode compressed bufferView " + std::to_string(pending[i].index));
+	});
+}
+
+static tinygltf::Model loadGltfMapped(const std::string& modelPath, GltfSource& source, JobSystem* jobs) {
 	tinygltf::Model model;
 	tinygltf::TinyGLTF loader;
 	std::string        err;
 	std::string        warn;
 
-	// Detect file extension to determine which loader to use
-	bool ret = false;
+	// Detect file extension to determine the container
 	std::string extension = modelPath.substr(modelPath.find_last_of(".") + 1);
 	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	if (extension != "glb" && extension != "gltf")
+		throw std::runtime_error("Unsupported file extension: " + extension + ". Expected .gltf or .glb");
 
+	std::string baseDir = extractBaseDir(modelPath);
+	std::span<const unsigned char> file = mapSourceFile(source, modelPath);
+	std::span<const unsigned char> json = file;
+	std::span<const unsigned char> bin;
 	if (extension == "glb") {
-		ret = loader.LoadBinaryFromFile(&model, &err, &warn, modelPath);
-	}
-	else if (extension == "gltf") {
-		ret = loader.LoadASCIIFromFile(&model, &err, &warn, modelPath);
-	}
-	else {
-		err = "Unsupported file extension: " + extension + ". Expected .gltf or .glb";
+		json = {};
+		splitGlb(file, json, bin);
 	}
 
+	// tinygltf would copy every buffer (and the BIN chunk) into
+	// tinygltf::Buffer::data, so it only gets the JSON without buffers and
+	// images; both are resolved against the mappings below.
+	nlohmann::json document = nlohmann::json::parse(json.begin(), json.end(), nullptr, false);
+	if (document.is_discarded() || !document.is_object())
+		throw std::runtime_error("Failed to parse glTF JSON");
+
+	nlohmann::json buffers = document.contains("buffers") ? std::move(document["buffers"]) : nlohmann::json::array();
+	nlohmann::json images = document.contains("images") ? std::move(document["images"]) : nlohmann::json::array();
+	document.erase("buffers");
+	document.erase("images");
+	std::string stripped = document.dump();
+
+	bool ret = loader.LoadASCIIFromString(&model, &err, &warn, stripped.c_str(), (unsigned int)stripped.size(), baseDir);
+
 	if (!warn.empty())
 	{
 		std::cout << "glTF warning: " << warn << std::endl;
@@ -77,49 +355,98 @@ tinygltf::Model loadGltf(std::string modelPath) {
 	{
 		throw std::runtime_error("Failed to load glTF model");
 	}
+
+	// Buffers: the GLB-stored buffer is the BIN chunk, the rest are URIs.
+	// Meshopt fallback buffers without data are filled by decoding below.
+	source.buffers.reserve(buffers.size());
+	std::vector<unsigned char*> writable(buffers.size(), nullptr);
+	for (size_t i = 0; i < buffers.size(); i++) {
+		const nlohmann::json& buffer = buffers[i];
+		size_t byteLength = buffer.value("byteLength", (size_t)0);
+		const nlohmann::json* meshopt = meshoptExtension(buffer);
+
+		std::span<const unsigned char> bytes;
+		if (buffer.contains("uri")) {
+			bytes = resolveUri(source, buffer["uri"].get<std::string>(), baseDir);
+		}
+		else if (i == 0 && !bin.empty()) {
+			bytes = bin;
+		}
+		else if (meshopt && meshopt->value("fallback", false)) {
+			std::vector<unsigned char>& storage = source.decoded.emplace_back(byteLength);
+			writable[i] = storage.data();
+			bytes = { storage.data(), storage.size() };
+		}
+		else {
+			throw std::runtime_error("glTF buffer " + std::to_string(i) + " has no data");
+		}
+
+		if (bytes.size() < byteLength)
+			throw std::runtime_error("glTF buffer " + std::to_string(i) + " is shorter than its byteLength");
+		source.buffers.push_back(bytes.first(byteLength));
+	}
+
+	if (document.contains("bufferViews"))
+		decodeMeshoptViews(document["bufferViews"], source.buffers, writable, jobs);
+
+	// Images: only located here; decodeGltfImage runs later on the job system
+	model.images.resize(images.size());
+	source.images.resize(images.size());
+	for (size_t i = 0; i < images.size(); i++) {
+		const nlohmann::json& entry = images[i];
+		tinygltf::Image& image = model.images[i];
+		image.name = entry.value("name", std::string());
+		image.uri = entry.value("uri", std::string());
+		image.mimeType = entry.value("mimeType", std::string());
+		image.bufferView = entry.value("bufferView", -1);
+
+		std::span<const unsigned char> bytes;
+		if (image.bufferView >= 0) {
+			if (image.bufferView >= (int)model.bufferViews.size())
+				throw std::runtime_error("Image bufferView out of range");
+			const tinygltf::BufferView& view = model.bufferViews[image.bufferView];
+			if (view.buffer < 0 || view.buffer >= (int)source.buffers.size() ||
+				view.byteOffset + view.byteLength > source.buffers[view.buffer].size())
+				throw std::runtime_error("Image bufferView runs past its buffer");
+			bytes = source.buffers[view.buffer].subspan(view.byteOffset, view.byteLength);
+		}
+		else if (!image.uri.empty()) {
+			bytes = resolveUri(source, image.uri, baseDir);
+		}
+		else {
+			throw std::runtime_error("Image " + std::to_string(i) + " has neither uri nor bufferView");
+		}
+		source.images[i] = bytes;
+	}
 	return model;
 }
 
+tinygltf::Model loadGltf(std::string modelPath, GltfSource& source, JobSystem* jobs) {
+	try {
+		return loadGltfMapped(modelPath, source, jobs);
+	}
+	catch (...) {
+		gltfSourceClose(source);
+		throw;
+	}
+}
+
 void modelUnload(State* state)
 {
-	// 1. Destroy mesh buffers for every node in every model
-	std::function<void(Node*)> cleanupNode = [&](Node* node)
-		{
-			for (Mesh* mesh : node->meshes)
-			{
-				if (mesh->vertexBuffer) {
-					vkDestroyBuffer(state->context->device, mesh->vertexBuffer, nullptr);
-					mesh->vertexBuffer = VK_NULL_HANDLE;
-				}
-				if (mesh->vertexMemory) {
-					vkFreeMemory(state->context->device, mesh->vertexMemory, nullptr);
-					mesh->vertexMemory = VK_NULL_HANDLE;
-				}
-				if (mesh->indexBuffer) {
-					vkDestroyBuffer(state->context->device, mesh->indexBuffer, nullptr);
-					mesh->indexBuffer = VK_NULL_HANDLE;
-				}
-				if (mesh->indexMemory) {
-					vkFreeMemory(state->context->device, mesh->indexMemory, nullptr);
-					mesh->indexMemory = VK_NULL_HANDLE;
-				}
-			}
-
-			for (Node* child : node->children)
-				if (child) cleanupNode(child);
-		};
-
-	// 2. Walk each model's node tree and clean GPU buffers ONLY
+	// 1. Destroy every model's node tree; shared meshes free their buffers
+	//    when the last node holding them goes
 	for (Model* model : state->scene->models)
 	{
 		if (model->rootNode)
-			cleanupNode(model->rootNode);
+			nodeTreeDestroy(state, model->rootNode);
+		model->rootNode = nullptr;
+		instanceBufferDestroy(state, model);
+		skinningDestroy(state, model);
+		delete model;
 	}
-
-	// 3. Clear models – this calls ~Model and deletes all nodes in linearNodes
 	state->scene->models.clear();
 
-	// 4. Destroy global material UBOs
+	// 2. Destroy global material UBOs
 	for (Material* mat : state->scene->materials)
 	{
 		if (mat->materialBuffer) {
@@ -133,7 +460,7 @@ void modelUnload(State* state)
 	}
 	state->scene->materials.clear();
 
-	// 5. Destroy global textures
+	// 3. Destroy global textures
 	for (Texture* tex : state->scene->textures)
 	{
 		if (tex->textureImageView)
@@ -146,7 +473,8 @@ void modelUnload(State* state)
 			vkFreeMemory(state->context->device, tex->textureImageMemory, nullptr);
 	}
 	state->scene->textures.clear();
+	sceneClearCaches(state->scene);
 
-	// 6. Fallback texture if you still use one
+	// 4. Fallback texture if you still use one
 	textureImageDestroy(state);
 }
\ No newline at end of file
@@ -1,12 +1,39 @@
 #pragma once
 #include <string>
+#include <deque>
+#include <vector>
+#include "core/file_map.h"
+#include "loader/gltf_accessors.h"
 namespace tinygltf {
 	class Model;
+	struct Image;
 };
 struct State;
+struct Model;
+struct JobSystem;
+
+// Backing storage for a glTF loaded by loadGltf. The .glb (or .gltf and its
+// .bin/image files) stays memory mapped and buffers points straight into the
+// mappings; only data: URIs and EXT_meshopt_compression fallback buffers are
+// decoded into memory. Keep it open for as long as accessors are read.
+struct GltfSource {
+	std::vector<MappedFile> files;
+	std::vector<std::string> paths;  // parallel to files; the .gltf/.glb first
+	std::deque<std::vector<unsigned char>> decoded;
+	GltfBuffers buffers;
+	std::vector<std::span<const unsigned char>> images;  // encoded bytes per gltf.images entry
+};
+void gltfSourceClose(GltfSource& source);
 //Utility
 std::string extractBaseDir(const std::string& path);
 //Loading
 void loadModel(State* state, std::string modelPath);
-tinygltf::Model loadGltf(std::string modelPath);
+void loadModelFromGltf(State* state, Model* model, const std::string& modelPath);
+// tinygltf only parses the JSON: gltf.buffers is left empty (use
+// source.buffers) and gltf.images only carries metadata until each entry is
+// decoded from source.images with decodeGltfImage. Meshopt-compressed
+// bufferViews are decoded across jobs before this returns.
+tinygltf::Model loadGltf(std::string modelPath, GltfSource& source, JobSystem* jobs = nullptr);
+// Decodes PNG/JPEG bytes to RGBA8 into image. Thread-safe.
+void decodeGltfImage(std::span<const unsigned char> bytes, tinygltf::Image& image);
 void modelUnload(State* state);
\ No newline at end of file
@@ -142,22 +142,15 @@ void fillMaterialFromGltf(const tinygltf::Material& m, Material& mat,
 
 
 
-void parseMaterials(State *state, Model* model, const tinygltf::Model& gltf, std::unordered_map<int, TextureRole>& textureRoles) {
-    model->baseMaterialIndex = static_cast<uint32_t>(state->scene->materials.size());
-    model->baseTextureIndex = static_cast<uint32_t>(state->scene->textures.size());
-
-    state->scene->materials.reserve(
-        state->scene->materials.size() + gltf.materials.size()
-    );
+std::vector<Material*> parseMaterials(const tinygltf::Model& gltf, std::unordered_map<int, TextureRole>& textureRoles) {
+    std::vector<Material*> materials;
+    materials.reserve(gltf.materials.size());
 
     for (size_t i = 0; i < gltf.materials.size(); i++)
     {
-        const tinygltf::Material& gm = gltf.materials[i];
-
         Material* mat = new Material{};
-        fillMaterialFromGltf(gm, *mat, model->baseTextureIndex, textureRoles);
-
-        state->scene->materials.push_back(mat);
+        fillMaterialFromGltf(gltf.materials[i], *mat, 0, textureRoles);
+        materials.push_back(mat);
     }
-
+    return materials;
 };
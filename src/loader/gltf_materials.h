@@ -1,5 +1,7 @@
 #pragma once
 #include "core/math.h"
+#include <vector>
+#include <unordered_map>
 namespace tinygltf{
 	class Model;
 	class Material;
@@ -11,4 +13,6 @@ struct State;
 
 void fillMaterialFromGltf(const tinygltf::Material& m, Material& mat, uint32_t baseTextureIndex, std::unordered_map<int, TextureRole>& roles);
 
-void parseMaterials(State* state, Model* model, const tinygltf::Model& gltf, std::unordered_map<int, TextureRole>& textureRoles);
\ No newline at end of file
+// Materials with model-local texture indices, for sceneInternMaterial;
+// textureRoles is keyed by the same local indices
+std::vector<Material*> parseMaterials(const tinygltf::Model& gltf, std::unordered_map<int, TextureRole>& textureRoles);
\ No newline at end of file
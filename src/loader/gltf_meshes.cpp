@@ -1,26 +1,165 @@
 #include "loader/gltf_meshes.h"
 #include "resources/buffers.h"
+#include "resources/staging_arena.h"
+#include "resources/vertex_pack.h"
+#include "resources/mesh_optimize.h"
 #include "scene/node.h"
+#include "scene/model.h"
+#include "core/context.h"
 #include "core/state.h"
-#include <iostream>
+#include "core/config.h"
+#include "core/load_stats.h"
+#include "core/jobs.h"
+#include <cstring>
+#include <span>
 
-void createMeshBuffers(State* state, Node* node) {
-	for (Mesh* mesh : node->meshes) {
-		std::cout << "createMeshBuffers: node=" << node->name
-			<< " verts=" << mesh->vertices.size()
-			<< " idx=" << mesh->indices.size() << "\n";
+// A primitive's decode space in the staging arena: floats and 32-bit
+// indices as decodePrimitive writes them, packed in place into the GPU
+// layout once decoded
+struct StagedPrimitive {
+	const PrimitiveJob* job;
+	VkDeviceSize vertexOffset;
+	VkDeviceSize indexOffset;
+	Vertex* vertices;
+	uint32_t* indices;
+	PrimitiveCounts counts;
+};
+
+static VkDeviceSize alignArena(VkDeviceSize value) {
+	return (value + 15) & ~VkDeviceSize(15);
+}
+
+// Packs a decoded primitive over its own decode space and queues the copies
+// to its vertex and index buffers
+static void stageGeometry(State* state, const StagedPrimitive& staged) {
+	VertexLayout layout = state->config->vertexLayout;
+	Mesh* mesh = staged.job->mesh;
+	mesh->indexType = meshIndexType(mesh->vertexCount);
+
+	if (mesh->vertexCount) {
+		VkDeviceSize bytes = (VkDeviceSize)vertexStride(layout) * mesh->vertexCount;
+		packVerticesTo(layout, staged.vertices, mesh->vertexCount, mesh->minBounds, mesh->maxBounds,
+			reinterpret_cast<unsigned char*>(staged.vertices));
+		stagingArenaCopy(state, staged.vertexOffset, bytes, meshVertexUsage(*mesh), mesh->vertexBuffer, mesh->vertexMemory);
+		loadStatsAddDecoded(state, bytes);
+	}
+	if (mesh->indexCount) {
+		VkDeviceSize bytes = (VkDeviceSize)indexTypeSize(mesh->indexType) * mesh->indexCount;
+		packIndicesTo(staged.indices, mesh->indexCount, mesh->indexType,
+			reinterpret_cast<unsigned char*>(staged.indices));
+		stagingArenaCopy(state, staged.indexOffset, bytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mesh->indexBuffer, mesh->indexMemory);
+		loadStatsAddDecoded(state, bytes);
+	}
+}
+
+// Skin and morph streams come out of the decoder as vectors; they take new
+// arena space, so only once every reservation of the batch is queued
+static void stageDeformation(State* state, Mesh* mesh) {
+	if (mesh->skinned) {
+		VkDeviceSize bytes = mesh->skinVertices.size() * sizeof(SkinVertex);
+		memcpy(stagingArenaBuffer(state, bytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, mesh->skinBuffer, mesh->skinMemory),
+			mesh->skinVertices.data(), (size_t)bytes);
+	}
+	if (mesh->morphVertexCount) {
+		VkDeviceSize bytes = morphTargetsBytes(mesh->morphVertices, mesh->morphDeltas);
+		packMorphTargetsTo(mesh->morphVertices, mesh->morphDeltas,
+			stagingArenaBuffer(state, bytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, mesh->morphBuffer, mesh->morphMemory));
+	}
+	std::vector<SkinVertex>().swap(mesh->skinVertices);
+	std::vector<MorphVertex>().swap(mesh->morphVertices);
+	std::vector<MorphDelta>().swap(mesh->morphDeltas);
+}
 
-		if (!mesh->vertices.empty()) {
-			vertexBufferCreateForMesh(state, mesh->vertices, mesh->vertexBuffer, mesh->vertexMemory);
-			std::cout << "  -> VBO created: " << (mesh->vertexBuffer != VK_NULL_HANDLE) << "\n";
+void decodeMeshBuffers(State* state, const tinygltf::Model& gltf, const GltfBuffers& buffers, Model* model, const std::vector<PrimitiveJob>& jobs) {
+	bool optimize = state->config->meshOptimization;
+	std::vector<MeshOptimizeStats> stats(jobs.size());
+
+	size_t next = 0;
+	while (next < jobs.size()) {
+		// Reserve decode space for as many primitives as fit behind what
+		// is already staged
+		std::vector<StagedPrimitive> batch;
+		for (; next < jobs.size(); next++) {
+			PrimitiveCounts counts = primitiveCounts(gltf, *jobs[next].primitive);
+			VkDeviceSize vertexBytes = alignArena(counts.vertices * sizeof(Vertex));
+			VkDeviceSize offset = 0;
+			unsigned char* space = stagingArenaReserve(state, vertexBytes + counts.indices * sizeof(uint32_t), offset);
+			if (!space)
+				break;
+			batch.push_back({
+				.job = &jobs[next],
+				.vertexOffset = offset,
+				.indexOffset = offset + vertexBytes,
+				.vertices = reinterpret_cast<Vertex*>(space),
+				.indices = reinterpret_cast<uint32_t*>(space + vertexBytes),
+				.counts = counts,
+			});
 		}
-		if (!mesh->indices.empty()) {
-			indexBufferCreateForMesh(state, mesh->indices, mesh->indexBuffer, mesh->indexMemory);
-			std::cout << "  -> IBO created: " << (mesh->indexBuffer != VK_NULL_HANDLE) << "\n";
+		if (batch.empty()) {
+			stagingArenaFlush(state);
+			continue;
 		}
+
+		size_t first = next - batch.size();
+		parallelFor(state->jobs, batch.size(), [&](size_t i) {
+			const StagedPrimitive& staged = batch[i];
+			Mesh* mesh = staged.job->mesh;
+			decodePrimitive(gltf, buffers, *staged.job->primitive, staged.vertices, staged.indices, mesh, model);
+			// The optimizer reorders vertices without the parallel skin and
+			// morph streams
+			if (optimize && !mesh->skinned && mesh->morphVertices.empty()) {
+				stats[first + i] = optimizeMesh(std::span<Vertex>(staged.vertices, staged.counts.vertices),
+					std::span<uint32_t>(staged.indices, staged.counts.indices), mesh->center);
+				mesh->vertexCount = (uint32_t)stats[first + i].verticesAfter;
+			}
+		});
+
+		for (const StagedPrimitive& staged : batch)
+			stageGeometry(state, staged);
+		for (const StagedPrimitive& staged : batch)
+			stageDeformation(state, staged.job->mesh);
 	}
+	stagingArenaFlush(state);
+
+	if (optimize)
+		meshOptimizeReport(stats);
+}
+
+void createInstanceBuffer(State* state, Model* model) {
+	if (model->instances.empty() || model->instanceBuffer != VK_NULL_HANDLE)
+		return;
+	deviceBufferCreateFromMemory(state, model->instances.data(), model->instances.size() * sizeof(glm::mat4),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, model->instanceBuffer, model->instanceMemory);
+}
 
-	for (Node* child : node->children) {
-		createMeshBuffers(state, child);
+void instanceBufferDestroy(State* state, Model* model) {
+	VkDevice device = state->context->device;
+	if (model->instanceBuffer) vkDestroyBuffer(device, model->instanceBuffer, nullptr);
+	if (model->instanceMemory) vkFreeMemory(device, model->instanceMemory, nullptr);
+	model->instanceBuffer = VK_NULL_HANDLE;
+	model->instanceMemory = VK_NULL_HANDLE;
+}
+
+static void meshDestroy(State* state, Mesh* mesh) {
+	VkDevice device = state->context->device;
+	if (mesh->vertexBuffer) vkDestroyBuffer(device, mesh->vertexBuffer, nullptr);
+	if (mesh->vertexMemory) vkFreeMemory(device, mesh->vertexMemory, nullptr);
+	if (mesh->indexBuffer) vkDestroyBuffer(device, mesh->indexBuffer, nullptr);
+	if (mesh->indexMemory) vkFreeMemory(device, mesh->indexMemory, nullptr);
+	if (mesh->skinBuffer) vkDestroyBuffer(device, mesh->skinBuffer, nullptr);
+	if (mesh->skinMemory) vkFreeMemory(device, mesh->skinMemory, nullptr);
+	if (mesh->morphBuffer) vkDestroyBuffer(device, mesh->morphBuffer, nullptr);
+	if (mesh->morphMemory) vkFreeMemory(device, mesh->morphMemory, nullptr);
+	delete mesh;
+}
+
+void nodeTreeDestroy(State* state, Node* node) {
+	for (Node* child : node->children)
+		nodeTreeDestroy(state, child);
+
+	for (Mesh* mesh : node->meshes) {
+		if (--mesh->refCount == 0)
+			meshDestroy(state, mesh);
 	}
-}
\ No newline at end of file
+	delete node;
+}
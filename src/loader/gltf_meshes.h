@@ -1,6 +1,18 @@
 #pragma once
 #include "vulkan/vulkan.h"
+#include "loader/gltf_nodes.h"
 
 struct Node;
 struct State;
-void createMeshBuffers(State* state, Node* node);
\ No newline at end of file
+struct Model;
+// Decodes every primitive of jobs straight into the staging arena, packs it
+// there into Config::vertexLayout and uploads it, so the meshes never hold
+// CPU copies of their vertices and indices. Large loads go through the
+// arena in batches, a flush between them.
+void decodeMeshBuffers(State* state, const tinygltf::Model& gltf, const GltfBuffers& buffers, Model* model, const std::vector<PrimitiveJob>& jobs);
+// Uploads Model::instances (no-op without EXT_mesh_gpu_instancing nodes).
+void createInstanceBuffer(State* state, Model* model);
+void instanceBufferDestroy(State* state, Model* model);
+// Deletes node and its subtree. Each mesh loses one reference per node
+// holding it; its buffers and the Mesh go with the last one.
+void nodeTreeDestroy(State* state, Node* node);
\ No newline at end of file
@@ -3,16 +3,302 @@
 #include "scene/node.h"
 #include "core/math.h"
 #include <glfw/glfw3.h>
+#include "core/state.h"
+#include "core/jobs.h"
+#include "core/config.h"
+#include "resources/mesh_optimize.h"
+#include "loader/gltf_accessors.h"
 #include "tiny_gltf.h"
+
+PrimitiveCounts primitiveCounts(const tinygltf::Model& gltf, const tinygltf::Primitive& primitive) {
+	return {
+		.vertices = gltf.accessors.at(primitive.attributes.at("POSITION")).count,
+		.indices = gltf.accessors.at(primitive.indices).count,
+	};
+}
+
+void decodePrimitive(
+	const tinygltf::Model& gltf,
+	const GltfBuffers& buffers,
+	const tinygltf::Primitive& primitive,
+	Vertex* vertices,
+	uint32_t* indices,
+	Mesh* mesh,
+	Model* model)
+{
+	auto findAttribute = [&](const char* name) -> int {
+		auto it = primitive.attributes.find(name);
+		return it != primitive.attributes.end() ? it->second : -1;
+		};
+
+	// KHR_mesh_quantization allows integer positions, normals, tangents and
+	// texcoords; accessorReadFloats dequantizes them. Positions stay in the
+	// quantized space, the node transform carries the dequantization.
+	const bool quantized = std::find(gltf.extensionsUsed.begin(), gltf.extensionsUsed.end(),
+		"KHR_mesh_quantization") != gltf.extensionsUsed.end();
+
+	auto requireType = [&](const char* name, const AccessorView& view, bool allowInteger, bool requireNormalized) {
+		if (view.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+			return;
+		bool integer = view.componentType == TINYGLTF_COMPONENT_TYPE_BYTE ||
+			view.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ||
+			view.componentType == TINYGLTF_COMPONENT_TYPE_SHORT ||
+			view.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+		if (!quantized || !allowInteger || !integer || (requireNormalized && !view.normalized))
+			throw std::runtime_error(std::string(name) + (quantized ? " has an unsupported componentType" : " must be FLOAT"));
+		};
+	auto signedNormalized = [](const AccessorView& view) {
+		return view.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT ||
+			view.componentType == TINYGLTF_COMPONENT_TYPE_BYTE ||
+			view.componentType == TINYGLTF_COMPONENT_TYPE_SHORT;
+		};
+
+	// ─────────────────────────────────────────────
+	// POSITION
+	// ─────────────────────────────────────────────
+	const AccessorView positions = accessorView(gltf, buffers, primitive.attributes.at("POSITION"));
+	requireType("POSITION", positions, true, false);
+	if (positions.components != 3)
+		throw std::runtime_error("POSITION must be VEC3");
+
+	Vertex defaults{};
+	defaults.color = { 1.0f, 1.0f, 1.0f };
+	defaults.tangent = { 1.0f, 0.0f, 0.0f, 1.0f };
+	std::fill(vertices, vertices + positions.count, defaults);
+
+	Vertex* first = vertices;
+	accessorReadFloats(positions, glm::value_ptr(first->pos), sizeof(Vertex), 3);
+
+	// Reads one attribute column straight into the interleaved vertices.
+	auto readAttribute = [&](const char* name, AccessorView view, float* dst, int outComponents) {
+		if (view.count != positions.count)
+			throw std::runtime_error(std::string(name) + " count does not match POSITION");
+		accessorReadFloats(view, dst, sizeof(Vertex), outComponents);
+		};
+
+	// ─────────────────────────────────────────────
+	// NORMAL / TANGENT (float, or normalized BYTE/SHORT when quantized)
+	// ─────────────────────────────────────────────
+	if (int idx = findAttribute("NORMAL"); idx >= 0) {
+		AccessorView view = accessorView(gltf, buffers, idx);
+		requireType("NORMAL", view, signedNormalized(view), true);
+		readAttribute("NORMAL", view, glm::value_ptr(first->normal), 3);
+	}
+
+	if (int idx = findAttribute("TANGENT"); idx >= 0) {
+		AccessorView view = accessorView(gltf, buffers, idx);
+		requireType("TANGENT", view, signedNormalized(view), true);
+		if (view.components != 4)
+			throw std::runtime_error("TANGENT must be VEC4");
+		readAttribute("TANGENT", view, glm::value_ptr(first->tangent), 4);
+	}
+
+	// ─────────────────────────────────────────────
+	// TEXCOORD_n / COLOR_0 (float or normalized int)
+	// ─────────────────────────────────────────────
+	// Integer texcoords and colors are always normalized in core glTF; some
+	// exporters leave the flag off, so force it rather than trust it. Quantized
+	// texcoords may be unnormalized (rescaled by KHR_texture_transform) or
+	// signed, so there the accessor is taken as written.
+	auto readNormalized = [&](const char* name, float* dst, int outComponents) -> bool {
+		int idx = findAttribute(name);
+		if (idx < 0)
+			return false;
+
+		AccessorView view = accessorView(gltf, buffers, idx);
+		bool texCoord = outComponents == 2;
+		if (texCoord && quantized) {
+			requireType(name, view, true, false);
+		}
+		else if (view.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT &&
+			view.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+			view.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+			throw std::runtime_error(std::string("Unsupported ") + name + " componentType");
+		}
+		else {
+			view.normalized = true;
+		}
+		if (outComponents == 2 && view.components != 2)
+			throw std::runtime_error(std::string(name) + " must be VEC2");
+		if (outComponents == 3 && view.components != 3 && view.components != 4)
+			throw std::runtime_error(std::string(name) + " must be VEC3 or VEC4");
+
+		readAttribute(name, view, dst, outComponents);
+		return true;
+		};
+
+	readNormalized("TEXCOORD_0", glm::value_ptr(first->texCoord0), 2);
+
+	if (!readNormalized("TEXCOORD_1", glm::value_ptr(first->texCoord1), 2)) {
+		for (size_t i = 0; i < positions.count; ++i)
+			first[i].texCoord1 = first[i].texCoord0; // fallback
+	}
+
+	readNormalized("COLOR_0", glm::value_ptr(first->color), 3);
+
+	// ─────────────────────────────────────────────
+	// JOINTS_0 / WEIGHTS_0 (input of the skinning pass)
+	// ─────────────────────────────────────────────
+	int jointsIdx = findAttribute("JOINTS_0");
+	int weightsIdx = findAttribute("WEIGHTS_0");
+	if (jointsIdx >= 0 && weightsIdx >= 0) {
+		AccessorView joints = accessorView(gltf, buffers, jointsIdx);
+		AccessorView weights = accessorView(gltf, buffers, weightsIdx);
+		if (joints.components != 4 || weights.components != 4)
+			throw std::runtime_error("JOINTS_0 and WEIGHTS_0 must be VEC4");
+		if (joints.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+			joints.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+			throw std::runtime_error("JOINTS_0 must be UNSIGNED_BYTE or UNSIGNED_SHORT");
+		if (joints.count != positions.count || weights.count != positions.count)
+			throw std::runtime_error("JOINTS_0/WEIGHTS_0 count does not match POSITION");
+		if (weights.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+			weights.normalized = true;
+
+		std::vector<glm::vec4> jointValues(positions.count);
+		accessorReadFloats(joints, glm::value_ptr(jointValues[0]), sizeof(glm::vec4), 4);
+
+		mesh->skinVertices.resize(positions.count);
+		SkinVertex* skin = mesh->skinVertices.data();
+		accessorReadFloats(weights, glm::value_ptr(skin->weights), sizeof(SkinVertex), 4);
+		for (size_t i = 0; i < positions.count; ++i) {
+			skin[i].joints = glm::uvec4(jointValues[i]);
+			// Quantized weights rarely sum to exactly 1
+			float sum = skin[i].weights.x + skin[i].weights.y + skin[i].weights.z + skin[i].weights.w;
+			if (sum > 0.0f)
+				skin[i].weights /= sum;
+		}
+		mesh->skinned = true;
+	}
+
+	// ─────────────────────────────────────────────
+	// Morph targets, kept as sparse deltas of the vertices they move
+	// ─────────────────────────────────────────────
+	if (!primitive.targets.empty()) {
+		size_t count = positions.count;
+		size_t targets = primitive.targets.size();
+		std::vector<glm::vec3> deltas[3];   // position, normal, tangent; [target * count + vertex]
+		for (std::vector<glm::vec3>& attribute : deltas)
+			attribute.assign(targets * count, glm::vec3(0.0f));
+
+		for (size_t t = 0; t < targets; t++) {
+			for (const auto& [name, accessor] : primitive.targets[t]) {
+				int attribute = name == "POSITION" ? 0 : name == "NORMAL" ? 1 : name == "TANGENT" ? 2 : -1;
+				if (attribute >= 0)
+					accessorReadFloatsSparse(gltf, buffers, accessor, count,
+						glm::value_ptr(deltas[attribute][t * count]), sizeof(glm::vec3), 3);
+			}
+		}
+
+		const glm::vec3 zero(0.0f);
+		for (size_t v = 0; v < count; v++) {
+			uint32_t firstDelta = (uint32_t)mesh->morphDeltas.size();
+			for (size_t t = 0; t < targets; t++) {
+				size_t at = t * count + v;
+				if (deltas[0][at] == zero && deltas[1][at] == zero && deltas[2][at] == zero)
+					continue;
+				mesh->morphDeltas.push_back(MorphDelta{
+					.position = deltas[0][at], .target = (uint32_t)t,
+					.normal = deltas[1][at], .tangent = deltas[2][at] });
+			}
+			uint32_t deltaCount = (uint32_t)mesh->morphDeltas.size() - firstDelta;
+			if (deltaCount)
+				mesh->morphVertices.push_back({ (uint32_t)v, firstDelta, deltaCount, 0 });
+		}
+		mesh->morphTargetCount = (uint32_t)targets;
+		mesh->morphVertexCount = (uint32_t)mesh->morphVertices.size();
+		mesh->morphDeltaCount = (uint32_t)mesh->morphDeltas.size();
+	}
+
+	// ─────────────────────────────────────────────
+	// Compute mesh bounds + center (minimal fix)
+	// ─────────────────────────────────────────────
+	mesh->minBounds = glm::vec3(FLT_MAX);
+	mesh->maxBounds = glm::vec3(-FLT_MAX);
+
+	for (size_t i = 0; i < positions.count; i++)
+	{
+		mesh->minBounds = glm::min(mesh->minBounds, vertices[i].pos);
+		mesh->maxBounds = glm::max(mesh->maxBounds, vertices[i].pos);
+	}
+
+	mesh->center = 0.5f * (mesh->minBounds + mesh->maxBounds);
+
+	// ─────────────────────────────────────────────
+	// Indices
+	// ─────────────────────────────────────────────
+	const AccessorView indexView = accessorView(gltf, buffers, primitive.indices);
+	accessorReadIndices(indexView, indices, 0);
+	mesh->vertexCount = (uint32_t)positions.count;
+	mesh->indexCount = (uint32_t)indexView.count;
+
+	if (primitive.material >= 0 && primitive.material < (int)model->materialIndices.size())
+		mesh->materialIndex = (int)model->materialIndices[primitive.material];
+}
+
+// Node-local TRS per instance from EXT_mesh_gpu_instancing; missing
+// attributes keep their identity value.
+static void readInstances(const tinygltf::Model& gltf, const GltfBuffers& buffers, const tinygltf::Value& extension, Node* node, Model* model) {
+	if (!extension.Has("attributes"))
+		return;
+	const tinygltf::Value& attributes = extension.Get("attributes");
+
+	struct Column {
+		const char* name;
+		int components;
+		AccessorView view;
+	};
+	Column columns[] = { { "TRANSLATION", 3 }, { "ROTATION", 4 }, { "SCALE", 3 } };
+
+	size_t count = 0;
+	bool found = false;
+	for (Column& column : columns) {
+		if (!attributes.Has(column.name))
+			continue;
+		column.view = accessorView(gltf, buffers, attributes.Get(column.name).GetNumberAsInt());
+		if (column.view.components != column.components)
+			throw std::runtime_error(std::string("EXT_mesh_gpu_instancing ") + column.name + " has the wrong type");
+		if (found && column.view.count != count)
+			throw std::runtime_error("EXT_mesh_gpu_instancing attribute counts differ");
+		count = column.view.count;
+		found = true;
+	}
+	if (count == 0)
+		return;
+
+	std::vector<glm::vec3> translations(count, glm::vec3(0.0f));
+	std::vector<glm::vec4> rotations(count, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));  // x, y, z, w
+	std::vector<glm::vec3> scales(count, glm::vec3(1.0f));
+	if (columns[0].view.data)
+		accessorReadFloats(columns[0].view, glm::value_ptr(translations[0]), sizeof(glm::vec3), 3);
+	if (columns[1].view.data)
+		accessorReadFloats(columns[1].view, glm::value_ptr(rotations[0]), sizeof(glm::vec4), 4);
+	if (columns[2].view.data)
+		accessorReadFloats(columns[2].view, glm::value_ptr(scales[0]), sizeof(glm::vec3), 3);
+
+	node->firstInstance = (uint32_t)model->instances.size();
+	node->instanceCount = (uint32_t)count;
+	model->instances.reserve(model->instances.size() + count);
+	for (size_t i = 0; i < count; i++) {
+		glm::quat rotation = glm::normalize(glm::quat(rotations[i].w, rotations[i].x, rotations[i].y, rotations[i].z));
+		model->instances.push_back(glm::translate(glm::mat4(1.0f), translations[i]) * glm::mat4_cast(rotation) *
+			glm::scale(glm::mat4(1.0f), scales[i]));
+	}
+}
+
 void processNode(
 	const tinygltf::Model& gltf,
+	const GltfBuffers& buffers,
 	const tinygltf::Node& node,
 	Node* parent,
 	const std::string& baseDir,
-	Model* model)
+	Model* model,
+	std::vector<std::vector<Mesh*>>& meshes,
+	std::vector<PrimitiveJob>& jobs)
 {
 	Node* newNode = new Node();
 	newNode->name = node.name;
+	model->nodes[&node - gltf.nodes.data()] = newNode;
+	newNode->skin = node.skin;
 
 	// ─────────────────────────────────────────────
 	// Node transform
@@ -39,373 +325,46 @@ void processNode(
 	}
 
 	// ─────────────────────────────────────────────
-	// Helper: decode normalized integer → float
-	// ─────────────────────────────────────────────
-	auto readFloat = [](const unsigned char* src, int componentType) -> float {
-		switch (componentType) {
-		case TINYGLTF_COMPONENT_TYPE_FLOAT:
-			return *reinterpret_cast<const float*>(src);
-
-		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-			return (*src) / 255.0f;
-
-		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-			return (*reinterpret_cast<const uint16_t*>(src)) / 65535.0f;
-
-		default:
-			throw std::runtime_error("Unsupported componentType for float conversion");
-		}
-		};
-
-	// ─────────────────────────────────────────────
-	// Process mesh
+	// Mesh slots (decoded later by decodePrimitive), created on the first
+	// node that uses a glTF mesh and shared by the rest
 	// ─────────────────────────────────────────────
 	if (node.mesh >= 0) {
-		const tinygltf::Mesh& mesh = gltf.meshes[node.mesh];
-
-		for (const auto& primitive : mesh.primitives) {
-			Mesh* newMesh = new Mesh;
-
-			// ─────────────────────────────────────────────
-			// Index buffer
-			// ─────────────────────────────────────────────
-			const auto& indexAccessor = gltf.accessors[primitive.indices];
-			const auto& indexBufferView = gltf.bufferViews[indexAccessor.bufferView];
-			const auto& indexBuffer = gltf.buffers[indexBufferView.buffer];
-
-			size_t indexCount = indexAccessor.count;
-
-			const unsigned char* indexData =
-				&indexBuffer.data[indexBufferView.byteOffset + indexAccessor.byteOffset];
-
-			size_t indexStride = 0;
-			switch (indexAccessor.componentType) {
-			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: indexStride = 2; break;
-			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:   indexStride = 4; break;
-			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  indexStride = 1; break;
-			default: throw std::runtime_error("Unsupported index type");
-			}
-
-			// ─────────────────────────────────────────────
-			// POSITION (float only)
-			// ─────────────────────────────────────────────
-			const auto& posAccessor = gltf.accessors[primitive.attributes.at("POSITION")];
-			const auto& posBufferView = gltf.bufferViews[posAccessor.bufferView];
-			const auto& posBuffer = gltf.buffers[posBufferView.buffer];
-
-			if (posAccessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
-				throw std::runtime_error("POSITION must be FLOAT");
-
-			size_t posStride = posBufferView.byteStride ?
-				posBufferView.byteStride :
-				3 * sizeof(float);
-
-			// ─────────────────────────────────────────────
-			// NORMAL (float only)
-			// ─────────────────────────────────────────────
-			bool hasNormals = primitive.attributes.count("NORMAL");
-			const tinygltf::Accessor* normalAccessor = nullptr;
-			const tinygltf::BufferView* normalBufferView = nullptr;
-			const tinygltf::Buffer* normalBuffer = nullptr;
-			size_t normalStride = 0;
-
-			if (hasNormals) {
-				normalAccessor = &gltf.accessors[primitive.attributes.at("NORMAL")];
-				if (normalAccessor->componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
-					throw std::runtime_error("NORMAL must be FLOAT");
-
-				normalBufferView = &gltf.bufferViews[normalAccessor->bufferView];
-				normalBuffer = &gltf.buffers[normalBufferView->buffer];
-				normalStride = normalBufferView->byteStride ?
-					normalBufferView->byteStride :
-					3 * sizeof(float);
-			}
-			// ─────────────────────────────────────────────
-			// TEXCOORD_0 (float or normalized int)
-			// ─────────────────────────────────────────────
-			bool hasTexCoords0 = primitive.attributes.count("TEXCOORD_0") > 0;
-			const tinygltf::Accessor* uvAccessor = nullptr;
-			const tinygltf::BufferView* uvBufferView = nullptr;
-			const tinygltf::Buffer* uvBuffer = nullptr;
-			size_t uvStride = 0;
-
-			if (hasTexCoords0) {
-				uvAccessor = &gltf.accessors[primitive.attributes.at("TEXCOORD_0")];
-				uvBufferView = &gltf.bufferViews[uvAccessor->bufferView];
-				uvBuffer = &gltf.buffers[uvBufferView->buffer];
-
-				if (uvAccessor->type != TINYGLTF_TYPE_VEC2)
-					throw std::runtime_error("TEXCOORD_0 must be VEC2");
-
-				if (uvBufferView->byteStride != 0) {
-					uvStride = uvBufferView->byteStride;
-				}
-				else {
-					switch (uvAccessor->componentType) {
-					case TINYGLTF_COMPONENT_TYPE_FLOAT:          uvStride = 2 * sizeof(float);   break;
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  uvStride = 2 * sizeof(uint8_t); break;
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: uvStride = 2 * sizeof(uint16_t); break;
-					default:
-						throw std::runtime_error("Unsupported TEXCOORD_0 componentType");
-					}
-				}
-			}
-
-			// ─────────────────────────────────────────────
-			// TEXCOORD_1 (float or normalized int)
-			// ─────────────────────────────────────────────
-			bool hasTexCoords1 = primitive.attributes.count("TEXCOORD_1") > 0;
-			const tinygltf::Accessor* uv1Accessor = nullptr;
-			const tinygltf::BufferView* uv1BufferView = nullptr;
-			const tinygltf::Buffer* uv1Buffer = nullptr;
-			size_t uv1Stride = 0;
-
-			if (hasTexCoords1) {
-				uv1Accessor = &gltf.accessors[primitive.attributes.at("TEXCOORD_1")];
-				uv1BufferView = &gltf.bufferViews[uv1Accessor->bufferView];
-				uv1Buffer = &gltf.buffers[uv1BufferView->buffer];
-
-				if (uv1Accessor->type != TINYGLTF_TYPE_VEC2)
-					throw std::runtime_error("TEXCOORD_1 must be VEC2");
-
-				if (uv1BufferView->byteStride != 0) {
-					uv1Stride = uv1BufferView->byteStride;
-				}
-				else {
-					switch (uv1Accessor->componentType) {
-					case TINYGLTF_COMPONENT_TYPE_FLOAT:          uv1Stride = 2 * sizeof(float);   break;
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  uv1Stride = 2 * sizeof(uint8_t); break;
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: uv1Stride = 2 * sizeof(uint16_t); break;
-					default:
-						throw std::runtime_error("Unsupported TEXCOORD_1 componentType");
-					}
-				}
+		std::vector<Mesh*>& shared = meshes[node.mesh];
+		if (shared.empty()) {
+			for (const auto& primitive : gltf.meshes[node.mesh].primitives) {
+				Mesh* newMesh = new Mesh;
+				shared.push_back(newMesh);
+				jobs.push_back({ &primitive, newMesh });
 			}
-
-			// ─────────────────────────────────────────────
-			// COLOR_0 (float or normalized int)
-			// ─────────────────────────────────────────────
-			bool hasColors = primitive.attributes.count("COLOR_0");
-			const tinygltf::Accessor* colorAccessor = nullptr;
-			const tinygltf::BufferView* colorBufferView = nullptr;
-			const tinygltf::Buffer* colorBuffer = nullptr;
-			size_t colorStride = 0;
-
-			if (hasColors) {
-				colorAccessor = &gltf.accessors[primitive.attributes.at("COLOR_0")];
-				colorBufferView = &gltf.bufferViews[colorAccessor->bufferView];
-				colorBuffer = &gltf.buffers[colorBufferView->buffer];
-
-				int comps = (colorAccessor->type == TINYGLTF_TYPE_VEC3 ? 3 :
-					colorAccessor->type == TINYGLTF_TYPE_VEC4 ? 4 : 0);
-				if (!comps) throw std::runtime_error("COLOR_0 must be VEC3 or VEC4");
-
-				if (colorBufferView->byteStride)
-					colorStride = colorBufferView->byteStride;
-				else {
-					switch (colorAccessor->componentType) {
-					case TINYGLTF_COMPONENT_TYPE_FLOAT:          colorStride = comps * 4; break;
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  colorStride = comps * 1; break;
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: colorStride = comps * 2; break;
-					default: throw std::runtime_error("Unsupported COLOR_0 componentType");
-					}
-				}
-			}
-
-			// ─────────────────────────────────────────────
-			// TANGENT (float only)
-			// ─────────────────────────────────────────────
-			bool hasTangents = primitive.attributes.count("TANGENT");
-			const tinygltf::Accessor* tanAccessor = nullptr;
-			const tinygltf::BufferView* tanBufferView = nullptr;
-			const tinygltf::Buffer* tanBuffer = nullptr;
-			size_t tanStride = 0;
-
-			if (hasTangents) {
-				tanAccessor = &gltf.accessors[primitive.attributes.at("TANGENT")];
-				if (tanAccessor->componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
-					throw std::runtime_error("TANGENT must be FLOAT");
-
-				tanBufferView = &gltf.bufferViews[tanAccessor->bufferView];
-				tanBuffer = &gltf.buffers[tanBufferView->buffer];
-				tanStride = tanBufferView->byteStride ?
-					tanBufferView->byteStride :
-					4 * sizeof(float);
-			}
-
-			// ─────────────────────────────────────────────
-			// Vertex loop
-			// ─────────────────────────────────────────────
-			uint32_t baseVertex = (uint32_t)newMesh->vertices.size();
-			newMesh->vertices.reserve(newMesh->vertices.size() + posAccessor.count);
-
-			for (size_t i = 0; i < posAccessor.count; ++i) {
-				Vertex v{};
-
-				// POSITION
-				const float* pos = reinterpret_cast<const float*>(
-					&posBuffer.data[posBufferView.byteOffset + posAccessor.byteOffset + i * posStride]);
-				v.pos = { pos[0], pos[1], pos[2] };
-
-				// NORMAL
-				if (hasNormals) {
-					const float* n = reinterpret_cast<const float*>(
-						&normalBuffer->data[normalBufferView->byteOffset + normalAccessor->byteOffset + i * normalStride]);
-					v.normal = { n[0], n[1], n[2] };
-				}
-
-				// TEXCOORD_0
-				if (hasTexCoords0) {
-					const unsigned char* base = &uvBuffer->data[
-						uvBufferView->byteOffset +
-							uvAccessor->byteOffset +
-							i * uvStride
-					];
-
-					switch (uvAccessor->componentType) {
-					case TINYGLTF_COMPONENT_TYPE_FLOAT: {
-						const float* uv = reinterpret_cast<const float*>(base);
-						v.texCoord0 = { uv[0], uv[1] };
-						break;
-					}
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
-						const uint8_t* uv = reinterpret_cast<const uint8_t*>(base);
-						v.texCoord0 = {
-							uv[0] / 255.0f,
-							uv[1] / 255.0f
-						};
-						break;
-					}
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
-						const uint16_t* uv = reinterpret_cast<const uint16_t*>(base);
-						v.texCoord0 = {
-							uv[0] / 65535.0f,
-							uv[1] / 65535.0f
-						};
-						break;
-					}
-					default:
-						v.texCoord0 = { 0.0f, 0.0f }; // should never hit due to earlier check
-						break;
-					}
-				}
-				else {
-					v.texCoord0 = { 0.0f, 0.0f };
-				}
-
-				// TEXCOORD_1
-				if (hasTexCoords1) {
-					const unsigned char* base = &uv1Buffer->data[
-						uv1BufferView->byteOffset +
-							uv1Accessor->byteOffset +
-							i * uv1Stride
-					];
-
-					switch (uv1Accessor->componentType) {
-					case TINYGLTF_COMPONENT_TYPE_FLOAT: {
-						const float* uv = reinterpret_cast<const float*>(base);
-						v.texCoord1 = { uv[0], uv[1] };
-						break;
-					}
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
-						const uint8_t* uv = reinterpret_cast<const uint8_t*>(base);
-						v.texCoord1 = {
-							uv[0] / 255.0f,
-							uv[1] / 255.0f
-						};
-						break;
-					}
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
-						const uint16_t* uv = reinterpret_cast<const uint16_t*>(base);
-						v.texCoord1 = {
-							uv[0] / 65535.0f,
-							uv[1] / 65535.0f
-						};
-						break;
-					}
-					default:
-						v.texCoord1 = { 0.0f, 0.0f }; // should never hit
-						break;
-					}
-				}
-				else {
-					v.texCoord1 = v.texCoord0; // fallback
-				}
-
-				// COLOR_0
-				if (hasColors) {
-					const unsigned char* base = &colorBuffer->data[
-						colorBufferView->byteOffset + colorAccessor->byteOffset + i * colorStride];
-
-					v.color.r = readFloat(base + 0 * (colorStride / (colorAccessor->type == TINYGLTF_TYPE_VEC4 ? 4 : 3)), colorAccessor->componentType);
-					v.color.g = readFloat(base + 1 * (colorStride / (colorAccessor->type == TINYGLTF_TYPE_VEC4 ? 4 : 3)), colorAccessor->componentType);
-					v.color.b = readFloat(base + 2 * (colorStride / (colorAccessor->type == TINYGLTF_TYPE_VEC4 ? 4 : 3)), colorAccessor->componentType);
-				}
-				else {
-					v.color = { 1,1,1 };
-				}
-
-				// TANGENT
-				v.tangent = { 1.0f, 0.0f, 0.0f, 1.0f };
-				if (hasTangents) {
-					const float* t = reinterpret_cast<const float*>(
-						&tanBuffer->data[tanBufferView->byteOffset + tanAccessor->byteOffset + i * tanStride]);
-					v.tangent = { t[0], t[1], t[2], t[3] };
-				}
-
-				newMesh->vertices.push_back(v);
-			}
-			// ─────────────────────────────────────────────
-			// Compute mesh bounds + center (minimal fix)
-			// ─────────────────────────────────────────────
-			newMesh->minBounds = glm::vec3(FLT_MAX);
-			newMesh->maxBounds = glm::vec3(-FLT_MAX);
-
-			for (const Vertex& v : newMesh->vertices)
-			{
-				newMesh->minBounds = glm::min(newMesh->minBounds, v.pos);
-				newMesh->maxBounds = glm::max(newMesh->maxBounds, v.pos);
-			}
-
-			newMesh->center = 0.5f * (newMesh->minBounds + newMesh->maxBounds);
-
-			// ─────────────────────────────────────────────
-			// Index loop
-			// ─────────────────────────────────────────────
-			newMesh->indices.reserve(newMesh->indices.size() + indexCount);
-
-			for (size_t i = 0; i < indexCount; ++i) {
-				uint32_t idx = 0;
-				const unsigned char* src = indexData + i * indexStride;
-
-				switch (indexAccessor.componentType) {
-				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: idx = *reinterpret_cast<const uint16_t*>(src); break;
-				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:   idx = *reinterpret_cast<const uint32_t*>(src); break;
-				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  idx = *reinterpret_cast<const uint8_t*>(src);  break;
-				}
-
-				newMesh->indices.push_back(baseVertex + idx);
-			}
-
-			if (primitive.material >= 0)
-				newMesh->materialIndex = model->baseMaterialIndex + primitive.material;
-
-
-			newNode->meshes.push_back(newMesh);
 		}
+		for (Mesh* mesh : shared)
+			newNode->addMesh(mesh);
+
+		// Morph weights: the node's own, else the mesh defaults, one per target
+		const tinygltf::Mesh& mesh = gltf.meshes[node.mesh];
+		size_t targets = mesh.primitives.empty() ? 0 : mesh.primitives[0].targets.size();
+		const std::vector<double>& weights = node.weights.empty() ? mesh.weights : node.weights;
+		newNode->morphWeights.assign(targets, 0.0f);
+		for (size_t i = 0; i < targets && i < weights.size(); i++)
+			newNode->morphWeights[i] = (float)weights[i];
+
+		if (auto it = node.extensions.find("EXT_mesh_gpu_instancing"); it != node.extensions.end())
+			readInstances(gltf, buffers, it->second, newNode, model);
 	}
 
 	// ─────────────────────────────────────────────
 	// Recurse
 	// ─────────────────────────────────────────────
 	for (int child : node.children)
-		processNode(gltf, gltf.nodes[child], newNode, baseDir, model);
+		processNode(gltf, buffers, gltf.nodes[child], newNode, baseDir, model, meshes, jobs);
 }
 
-void parseSceneNodes(
+void buildSceneNodes(
 	const tinygltf::Model& gltf,
+	const GltfBuffers& buffers,
 	Model* model,
-	const std::string& baseDir)
+	const std::string& baseDir,
+	std::vector<PrimitiveJob>& jobs)
 {
 	// glTF may have zero scenes
 	if (gltf.scenes.empty())
@@ -422,9 +381,42 @@ void parseSceneNodes(
 
 	const tinygltf::Scene& scene = gltf.scenes[sceneIndex];
 
+	// Built serially so node and mesh order stay deterministic; every
+	// distinct primitive gets its preallocated Mesh and a job to decode it
+	std::vector<std::vector<Mesh*>> meshes(gltf.meshes.size());
+	model->nodes.assign(gltf.nodes.size(), nullptr);
 	for (int nodeIndex : scene.nodes)
 	{
 		const tinygltf::Node& node = gltf.nodes[nodeIndex];
-		processNode(gltf, node, model->rootNode, baseDir, model);
+		processNode(gltf, buffers, node, model->rootNode, baseDir, model, meshes, jobs);
 	}
 }
+
+void parseSceneNodes(
+	State* state,
+	const tinygltf::Model& gltf,
+	const GltfBuffers& buffers,
+	Model* model,
+	const std::string& baseDir)
+{
+	std::vector<PrimitiveJob> jobs;
+	buildSceneNodes(gltf, buffers, model, baseDir, jobs);
+
+	std::vector<MeshOptimizeStats> stats(jobs.size());
+	bool optimize = state->config->meshOptimization;
+	parallelFor(state->jobs, jobs.size(), [&](size_t i) {
+		Mesh* mesh = jobs[i].mesh;
+		PrimitiveCounts counts = primitiveCounts(gltf, *jobs[i].primitive);
+		mesh->vertices.resize(counts.vertices);
+		mesh->indices.resize(counts.indices);
+		decodePrimitive(gltf, buffers, *jobs[i].primitive, mesh->vertices.data(), mesh->indices.data(), mesh, model);
+		// The optimizer reorders vertices without the parallel skin and
+		// morph streams
+		if (optimize && !mesh->skinned && mesh->morphVertices.empty())
+			stats[i] = optimizeMesh(mesh->vertices, mesh->indices, mesh->center);
+		mesh->vertexCount = (uint32_t)mesh->vertices.size();
+	});
+
+	if (optimize)
+		meshOptimizeReport(stats);
+}
@@ -1,15 +1,43 @@
 #pragma once
 #include "vulkan/vulkan.h"
 #include <string>
+#include <vector>
+#include "loader/gltf_accessors.h"
 
 namespace tinygltf{
 	class Model;
 	class Node;
+	struct Primitive;
 }
 
+struct State;
 struct Node;
 struct Model;
+struct Mesh;
+struct Vertex;
 
+struct PrimitiveJob {
+	const tinygltf::Primitive* primitive;
+	Mesh* mesh;
+};
 
-void processNode(const tinygltf::Model& gltf, const tinygltf::Node& node, Node* parent, const std::string& baseDir, Model* model);
-void parseSceneNodes(const tinygltf::Model& gltf, Model* model, const std::string& baseDir);
\ No newline at end of file
+struct PrimitiveCounts {
+	size_t vertices;
+	size_t indices;
+};
+
+// What decodePrimitive writes, from the POSITION and index accessors
+PrimitiveCounts primitiveCounts(const tinygltf::Model& gltf, const tinygltf::Primitive& primitive);
+// Decodes the primitive's vertices and indices into the given arrays, sized
+// by primitiveCounts, and the rest (bounds, counts, skin, morph targets,
+// material) into mesh
+void decodePrimitive(const tinygltf::Model& gltf, const GltfBuffers& buffers, const tinygltf::Primitive& primitive, Vertex* vertices, uint32_t* indices, Mesh* mesh, Model* model);
+// meshes holds the Mesh per primitive of each gltf.meshes entry once created.
+// EXT_mesh_gpu_instancing transforms are appended to model->instances.
+void processNode(const tinygltf::Model& gltf, const GltfBuffers& buffers, const tinygltf::Node& node, Node* parent, const std::string& baseDir, Model* model, std::vector<std::vector<Mesh*>>& meshes, std::vector<PrimitiveJob>& jobs);
+// Node tree of the default scene, with a job per distinct primitive left
+// for the caller to decode
+void buildSceneNodes(const tinygltf::Model& gltf, const GltfBuffers& buffers, Model* model, const std::string& baseDir, std::vector<PrimitiveJob>& jobs);
+// buildSceneNodes, then every primitive decoded (and optimized) into
+// Mesh::vertices and Mesh::indices, as the cooker needs them
+void parseSceneNodes(State* state, const tinygltf::Model& gltf, const GltfBuffers& buffers, Model* model, const std::string& baseDir);
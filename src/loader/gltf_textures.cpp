@@ -6,16 +6,29 @@
 #include "gltf_textures.h"
 #include "resources/images.h"
 #include "resources/buffers.h"
+#include "resources/mipmaps.h"
+#include "loader/ktx_cubemap.h"
+#include "loader/ktx_transcode.h"
 #include "render/renderer.h"
 #include "render/command_buffers.h"
 
 #include "loader/gltf_materials.h"
+#include "loader/gltf_loader.h"
 #include "scene/texture.h"
 #include "scene/model.h"
 #include "scene/scene.h"
 #include "core/context.h"
 #include "core/config.h"
 #include "core/state.h"
+#include "core/jobs.h"
+#include "core/load_stats.h"
+#include "core/hash.h"
+#include "core/file_map.h"
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
 
 // Base type
 void readTextureTransform(const tinygltf::TextureInfo& info, TextureTransform& out)
@@ -227,29 +240,35 @@ void generateMipmaps(State* state, VkImage image, VkFormat imageFormat, int32_t
     endSingleTimeCommands(state, commandBuffer);
 }
 
+static VkFormat modelTextureFormat(TextureRole role, int channels)
+{
+    if (textureRoleIsLinear(role))
+        return channels == 3 ? VK_FORMAT_R8G8B8_UNORM : VK_FORMAT_R8G8B8A8_UNORM;
+    return channels == 3 ? VK_FORMAT_R8G8B8_SRGB : VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+static void modelTextureSamplerCreate(State* state, Texture& outTex)
+{
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = static_cast<float>(outTex.mipLevels);
+
+    vkCreateSampler(state->context->device, &samplerInfo, nullptr, &outTex.textureSampler);
+}
+
 void createTextureFromMemory(State* state, const unsigned char* pixels, size_t size, int width, int height, int channels, Texture& outTex)
 {
     VkDevice device = state->context->device;
 
     // 1. Determine format
-    TextureRole role = outTex.role;
-    bool linear =
-        role == TextureRole::Normal ||
-        role == TextureRole::MetallicRoughness ||
-        role == TextureRole::Occlusion;
-   
-    VkFormat format;
-
-    if (linear) {
-        format = VK_FORMAT_R8G8B8A8_UNORM;
-        if (channels == 3)
-            format = VK_FORMAT_R8G8B8_UNORM;
-    }
-    else {
-        format = VK_FORMAT_R8G8B8A8_SRGB;
-        if (channels == 3)
-            format = VK_FORMAT_R8G8B8_SRGB;
-    }
+    VkFormat format = modelTextureFormat(outTex.role, channels);
     outTex.format = format;
 
     // 2. Create staging buffer
@@ -269,6 +288,7 @@ void createTextureFromMemory(State* state, const unsigned char* pixels, size_t s
     void* data;
     vkMapMemory(device, stagingMemory, 0, size, 0, &data);
     memcpy(data, pixels, size);
+    loadStatsAddUploaded(state, size);
     vkUnmapMemory(device, stagingMemory);
 
     // 3. Create Vulkan image
@@ -328,23 +348,244 @@ void createTextureFromMemory(State* state, const unsigned char* pixels, size_t s
     );
 
     // 6. Create sampler
-    VkSamplerCreateInfo samplerInfo{};
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = VK_FILTER_LINEAR;
-    samplerInfo.minFilter = VK_FILTER_LINEAR;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = static_cast<float>(outTex.mipLevels);
-
-    vkCreateSampler(device, &samplerInfo, nullptr, &outTex.textureSampler);
+    modelTextureSamplerCreate(state, outTex);
 
     // 7. Cleanup staging
     vkDestroyBuffer(device, stagingBuffer, nullptr);
     vkFreeMemory(device, stagingMemory, nullptr);
 }
+// Bytes per 4x4 block, 0 for uncompressed formats
+static uint32_t blockBytes(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return 8;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+std::vector<MipLevel> textureChainLayout(VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels)
+{
+    uint32_t block = blockBytes(format);
+    bool rgba8 = format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+    if ((!block && !rgba8) || width == 0 || height == 0 || mipLevels == 0 || mipLevels > mipLevelCount(width, height))
+        return {};
+
+    std::vector<MipLevel> levels(mipLevels);
+    size_t offset = 0;
+    for (MipLevel& level : levels) {
+        level.width = width;
+        level.height = height;
+        level.offset = offset;
+        level.size = block
+            ? static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * block
+            : static_cast<size_t>(width) * height * 4;
+        offset += level.size;
+
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+    return levels;
+}
+
+int gltfTextureImage(const tinygltf::Model& gltf, int textureIndex)
+{
+    if (textureIndex < 0 || textureIndex >= (int)gltf.textures.size())
+        return -1;
+    const tinygltf::Texture& texture = gltf.textures[textureIndex];
+
+    auto it = texture.extensions.find("KHR_texture_basisu");
+    if (it != texture.extensions.end() && it->second.Has("source")) {
+        int source = it->second.Get("source").GetNumberAsInt();
+        if (source >= 0 && source < (int)gltf.images.size())
+            return source;
+    }
+    return texture.source;
+}
+
+// <TEXTURE_CACHE_DIR>/<content hash>_<role>.ktx2
+static std::string textureCachePath(State* state, std::span<const unsigned char> bytes, TextureRole role)
+{
+    char name[40];
+    snprintf(name, sizeof(name), "%016llx_%u.ktx2", (unsigned long long)hashBytes(bytes.data(), bytes.size()), (unsigned)role);
+    return (std::filesystem::path(state->config->TEXTURE_CACHE_DIR) / name).string();
+}
+
+void decodeTextureLevels(State* state, std::span<const unsigned char> bytes, TextureRole role, TextureLevels& out)
+{
+    if (isKtx2(bytes)) {
+        transcodeKtx2(state, bytes, role, out);
+        return;
+    }
+
+    // PNG/JPEG go through the block-compressed cache when BC can be sampled
+    std::string cachePath;
+    if (state->context->textureCompressionBC && !state->config->TEXTURE_CACHE_DIR.empty()) {
+        cachePath = textureCachePath(state, bytes, role);
+        MappedFile cached;
+        if (fileMapOpen(cachePath, cached)) {
+            try {
+                transcodeKtx2(state, { cached.data, cached.size }, role, out);
+                fileMapClose(cached);
+                return;
+            }
+            catch (const std::exception& e) {
+                printf("texture cache: rebuilding %s (%s)\n", cachePath.c_str(), e.what());
+                fileMapClose(cached);
+                out = TextureLevels{};
+            }
+        }
+    }
+
+    tinygltf::Image image;
+    decodeGltfImage(bytes, image);
+    if (image.width <= 0 || image.height <= 0 || image.component != 4)
+        throw std::runtime_error("image decoded to no RGBA8 pixels");
+
+    out.format = textureRoleIsLinear(role) ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
+    out.width = (uint32_t)image.width;
+    out.height = (uint32_t)image.height;
+    out.levels = textureChainLayout(out.format, out.width, out.height, mipLevelCount(out.width, out.height));
+
+    // Level 0 is already in place; grow the buffer for the rest of the chain
+    out.data = std::move(image.image);
+    out.data.resize(out.levels.back().offset + out.levels.back().size);
+    buildMipChainRGBA8(out.data.data(), out.levels, !textureRoleIsLinear(role));
+
+    if (cachePath.empty())
+        return;
+
+    // First load: compress and store; the RGBA8 chain is still usable if that fails
+    try {
+        std::error_code ec;
+        std::filesystem::create_directories(state->config->TEXTURE_CACHE_DIR, ec);
+
+        TextureLevels compressed;
+        compressKtx2(out, role, cachePath, compressed);
+        out = std::move(compressed);
+    }
+    catch (const std::exception& e) {
+        printf("texture cache: keeping RGBA8 for %s (%s)\n", cachePath.c_str(), e.what());
+    }
+}
+
+std::vector<VkBufferImageCopy> mipCopyRegions(const std::vector<MipLevel>& levels, VkDeviceSize bufferOffset)
+{
+    // One region per prebuilt level, no blits
+    std::vector<VkBufferImageCopy> regions(levels.size());
+    for (size_t i = 0; i < levels.size(); i++) {
+        VkBufferImageCopy& region = regions[i];
+        region.bufferOffset = bufferOffset + levels[i].offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = static_cast<uint32_t>(i);
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { levels[i].width, levels[i].height, 1 };
+    }
+    return regions;
+}
+
+void createTextureForLevels(State* state, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels, Texture& outTex)
+{
+    outTex.format = format;
+    outTex.mipLevels = mipLevels;
+
+    imageCreate(
+        state,
+        width,
+        height,
+        outTex.format,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        outTex.textureImage,
+        outTex.textureImageMemory,
+        outTex.mipLevels,
+        VK_SAMPLE_COUNT_1_BIT
+    );
+
+    // BC4 only holds grey images; read them back as (r, r, r, 1)
+    VkComponentMapping components{};
+    if (format == VK_FORMAT_BC4_UNORM_BLOCK)
+        components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_ONE };
+
+    outTex.textureImageView = imageViewCreate(
+        state,
+        outTex.textureImage,
+        outTex.format,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        outTex.mipLevels,
+        components
+    );
+    modelTextureSamplerCreate(state, outTex);
+}
+
+void createTextureFromLevels(State* state, const unsigned char* chain, size_t size, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels, Texture& outTex)
+{
+    VkDevice device = state->context->device;
+
+    std::vector<MipLevel> levels = textureChainLayout(format, width, height, mipLevels);
+    if (levels.empty() || levels.back().offset + levels.back().size > size)
+        throw std::runtime_error("mip chain is smaller than its layout");
+
+    // Staging buffer filled straight from the caller's memory
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingMemory;
+
+    createBuffer(
+        state,
+        size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer,
+        stagingMemory
+    );
+
+    void* data;
+    vkMapMemory(device, stagingMemory, 0, size, 0, &data);
+    memcpy(data, chain, size);
+    vkUnmapMemory(device, stagingMemory);
+    loadStatsAddUploaded(state, size);
+
+    createTextureForLevels(state, format, width, height, mipLevels, outTex);
+
+    transitionImageLayout(
+        state,
+        outTex.textureImage,
+        outTex.format,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        outTex.mipLevels,
+        1
+    );
+
+    copyBufferToImageRegions(state, stagingBuffer, outTex.textureImage, mipCopyRegions(levels, 0));
+
+    transitionImageLayout(
+        state,
+        outTex.textureImage,
+        outTex.format,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        outTex.mipLevels,
+        1
+    );
+
+    vkDestroyBuffer(device, stagingBuffer, nullptr);
+    vkFreeMemory(device, stagingMemory, nullptr);
+}
+
 void destroyTextures(State* state) {
     VkDevice device = state->context->device;
 
@@ -448,6 +689,7 @@ void textureImageCreate(
     vkMapMemory(state->context->device, stagingMemory, 0, imageSize, 0, &data);
     memcpy(data, ktxData, imageSize);
     vkUnmapMemory(state->context->device, stagingMemory);
+    loadStatsAddUploaded(state, imageSize);
 
     // Create 2D image
     imageCreate(
@@ -509,6 +751,10 @@ void textureImageDestroy(State* state) {
 
     if (state->texture->textureImageMemory != VK_NULL_HANDLE)
         vkFreeMemory(state->context->device, state->texture->textureImageMemory, nullptr);
+
+    // modelUnload runs once per reload; a model without textures may not recreate these
+    state->texture->textureImage = VK_NULL_HANDLE;
+    state->texture->textureImageMemory = VK_NULL_HANDLE;
 };
 
 void textureImageViewCreate(
@@ -567,58 +813,128 @@ void textureSamplerDestroy(State* state) {
     vkDestroySampler(state->context->device, state->texture->textureSampler, nullptr);
 };
 
-void createModelTextures(State* state, Model* model, const tinygltf::Model& gltf, std::unordered_map<int, TextureRole>& textureRoles) 
+void createModelTextures(State* state, Model* model, tinygltf::Model& gltf, const GltfSource& source, std::unordered_map<int, TextureRole>& textureRoles) 
 {
-    const uint32_t baseIndex = model->baseTextureIndex;
+    const size_t textureCount = gltf.textures.size();
 
-    // If the glTF has embedded or external images
-    if (!gltf.images.empty())
+    // No textures in glTF → use fallback texture
+    if (textureCount == 0)
     {
-        state->scene->textures.reserve(
-            state->scene->textures.size() + gltf.images.size()
-        );
+        createFallbackModelTexture(state);
+        return;
+    }
 
-        for (int i = 0; i < (int)gltf.images.size(); i++)
+    // Textures whose image bytes and role are already resident, from this
+    // model or another, share the scene entry. The rest get their slot up
+    // front, so the indices are known whatever order the decodes finish in.
+    struct PendingTexture {
+        Texture* tex;
+        int image;
+    };
+    std::vector<PendingTexture> pending;
+    model->textureIndices.resize(textureCount);
+    for (size_t i = 0; i < textureCount; i++)
+    {
+        TextureRole role = textureRoles.count((int)i) ? textureRoles[(int)i] : TextureRole::BaseColor;
+        int image = gltfTextureImage(gltf, (int)i);
+        if (image < 0 || image >= (int)source.images.size())
+            throw std::runtime_error("texture " + std::to_string(i) + " has no image");
+
+        uint64_t contentHash = hashBytes(source.images[image].data(), source.images[image].size());
+        uint64_t key = textureCacheKey(contentHash, role);
+        int cached = sceneAcquireTexture(state->scene, key);
+        if (cached >= 0)
         {
-            const tinygltf::Image& img = gltf.images[i];
+            model->textureIndices[i] = (uint32_t)cached;
+            continue;
+        }
 
-            Texture* tex = new Texture{};
+        Texture* tex = new Texture{};
+        tex->role = role;
+        tex->contentHash = contentHash;
+        model->textureIndices[i] = sceneAddTexture(state->scene, tex, key);
+        pending.push_back({ tex, image });
+    }
 
-            int globalIndex = baseIndex + i;
+    // Decode (or transcode) every new texture on the job system; this thread
+    // uploads each one as soon as it is ready, since the upload path owns the
+    // graphics queue
+    const size_t pendingCount = pending.size();
+    std::mutex mutex;
+    std::condition_variable readyChanged;
+    std::deque<size_t> ready;
+    std::vector<TextureLevels> decoded(pendingCount);
+    std::vector<std::exception_ptr> errors(pendingCount);
+
+    for (size_t i = 0; i < pendingCount; i++)
+    {
+        jobSubmit(state->jobs, [&, i] {
+            try {
+                LoadStageTimer timer(state, LoadStage::ImageDecode);
+                decodeTextureLevels(state, source.images[pending[i].image], pending[i].tex->role, decoded[i]);
+                loadStatsAddDecoded(state, decoded[i].data.size());
+            }
+            catch (...) {
+                errors[i] = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.push_back(i);
+            readyChanged.notify_one();
+        });
+    }
 
-            // Assign role if known, otherwise default to BaseColor
-            if (textureRoles.count(globalIndex))
-                tex->role = textureRoles[globalIndex];
-            else
-                tex->role = TextureRole::BaseColor;
+    // Wait for every job before returning, even after a failure, since they
+    // reference locals of this call
+    std::exception_ptr firstError;
+    for (size_t done = 0; done < pendingCount; done++)
+    {
+        size_t i;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            readyChanged.wait(lock, [&] { return !ready.empty(); });
+            i = ready.front();
+            ready.pop_front();
+        }
 
+        TextureLevels& levels = decoded[i];
+        if (errors[i] || firstError)
+        {
+            if (!firstError)
+                firstError = errors[i];
+        }
+        else
+        {
             // Upload to GPU
-            createTextureFromMemory(
+            LoadStageTimer timer(state, LoadStage::TextureUpload);
+            createTextureFromLevels(
                 state,
-                img.image.data(),
-                img.image.size(),
-                img.width,
-                img.height,
-                img.component,
-                *tex
+                levels.data.data(),
+                levels.data.size(),
+                levels.format,
+                levels.width,
+                levels.height,
+                (uint32_t)levels.levels.size(),
+                *pending[i].tex
             );
-
-            state->scene->textures.push_back(tex);
         }
+        levels = TextureLevels{};
     }
-    else
-    {
-        // No images in glTF → use fallback texture
-        Texture* tex = new Texture{};
 
-        textureImageCreate(state, state->config->DEFAULT_TEXTURE_PATH, state->texture->textureImage, state->texture->textureImageMemory, state->texture->format, state->texture->mipLevels);
-        textureImageViewCreate(state, state->texture->textureImage, state->texture->format, VK_IMAGE_ASPECT_COLOR_BIT, state->texture->mipLevels, state->texture->textureImageView);
-        textureSamplerCreate(state, state->texture->textureSampler, state->texture->mipLevels);
+    if (firstError)
+        std::rethrow_exception(firstError);
+}
 
-        tex->textureImageView = state->texture->textureImageView;
-        tex->textureSampler = state->texture->textureSampler;
-        tex->role = TextureRole::BaseColor;
+void createFallbackModelTexture(State* state)
+{
+    Texture* tex = new Texture{};
 
-        state->scene->textures.push_back(tex);
-    }
+    textureImageCreate(state, state->config->DEFAULT_TEXTURE_PATH, state->texture->textureImage, state->texture->textureImageMemory, state->texture->format, state->texture->mipLevels);
+    textureImageViewCreate(state, state->texture->textureImage, state->texture->format, VK_IMAGE_ASPECT_COLOR_BIT, state->texture->mipLevels, state->texture->textureImageView);
+    textureSamplerCreate(state, state->texture->textureSampler, state->texture->mipLevels);
+
+    tex->textureImageView = state->texture->textureImageView;
+    tex->textureSampler = state->texture->textureSampler;
+    tex->role = TextureRole::BaseColor;
+
+    state->scene->textures.push_back(tex);
 }
@@ -1,7 +1,10 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include "core/math.h"
+#include <span>
 #include <string>
+#include <vector>
+#include "resources/mipmaps.h"
 namespace tinygltf {
 	struct TextureInfo;
 	struct NormalTextureInfo;
@@ -15,6 +18,7 @@ struct Texture;
 struct TextureTransform;
 enum TextureRole;
 struct Model;
+struct GltfSource;
 
 // Base type
 void readTextureTransform(
@@ -43,6 +47,38 @@ void createTextureFromMemory(
 	int height,
 	int channels,
 	Texture& outTex);
+// A texture's mip chain in its GPU format, tightly packed level 0 first.
+struct TextureLevels {
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<MipLevel> levels;
+	std::vector<unsigned char> data;
+};
+// Level layout for RGBA8 or BC formats (4x4 blocks), level 0 first. Empty for
+// any other format.
+std::vector<MipLevel> textureChainLayout(VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+// Image sampled by a glTF texture: the KHR_texture_basisu source when present,
+// otherwise texture.source. -1 if there is none.
+int gltfTextureImage(const tinygltf::Model& gltf, int textureIndex);
+// Decodes KTX2/Basis, PNG or JPEG bytes into the chain uploaded for role;
+// PNG/JPEG get RGBA8 mips built on the CPU. Thread-safe.
+void decodeTextureLevels(State* state, std::span<const unsigned char> bytes, TextureRole role, TextureLevels& out);
+// Uploads a chain laid out by textureChainLayout; no GPU blits.
+void createTextureFromLevels(
+	State* state,
+	const unsigned char* chain,
+	size_t size,
+	VkFormat format,
+	uint32_t width,
+	uint32_t height,
+	uint32_t mipLevels,
+	Texture& outTex);
+// Image, view and sampler for such a chain, left in
+// VK_IMAGE_LAYOUT_UNDEFINED for the caller to fill.
+void createTextureForLevels(State* state, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels, Texture& outTex);
+// One copy region per level, starting at bufferOffset.
+std::vector<VkBufferImageCopy> mipCopyRegions(const std::vector<MipLevel>& levels, VkDeviceSize bufferOffset);
 void destroyTextures(State* state);
 
 void brdfLutImageCreate(State* state);
@@ -73,4 +109,8 @@ void textureSamplerCreate(
 
 void textureSamplerDestroy(State* state);
 
-void createModelTextures(State* state, Model* model, const tinygltf::Model& gltf, std::unordered_map<int, TextureRole>& textureRoles);
+// Fills model->textureIndices, one per gltf.textures entry (textureRoles is
+// keyed by the same indices). Textures already in the scene cache are shared;
+// the rest are decoded in parallel and uploaded as each finishes.
+void createModelTextures(State* state, Model* model, tinygltf::Model& gltf, const GltfSource& source, std::unordered_map<int, TextureRole>& textureRoles);
+void createFallbackModelTexture(State* state);
@@ -0,0 +1,181 @@
+#include "loader/ktx_transcode.h"
+#include "loader/gltf_textures.h"
+#include "resources/mipmaps.h"
+#include "core/context.h"
+#include "core/state.h"
+#include <ktx.h>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+static const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+bool isKtx2(std::span<const unsigned char> bytes) {
+	return bytes.size() >= sizeof(KTX2_IDENTIFIER) && memcmp(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+}
+
+static void ktxCheck(KTX_error_code result, const char* what) {
+	if (result != KTX_SUCCESS)
+		throw std::runtime_error(std::string(what) + ": " + ktxErrorString(result));
+}
+
+// Picks the transcode target and the matching VkFormat for role.
+static ktx_transcode_fmt_e transcodeTarget(State* state, ktxTexture2* tex, TextureRole role, VkFormat& format) {
+	bool linear = textureRoleIsLinear(role);
+
+	if (!state->context->textureCompressionBC) {
+		format = linear ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
+		return KTX_TTF_RGBA32;
+	}
+
+	// ETC1S keeps a second slice for alpha; normal-mode ETC1S stores Y there
+	bool etc1s = tex->supercompressionScheme == KTX_SS_BASIS_LZ;
+	uint32_t components = ktxTexture2_GetNumComponents(tex);
+	bool hasAlpha = components == 2 || components == 4;
+
+	if (role == TextureRole::Normal && (!etc1s || hasAlpha)) {
+		format = VK_FORMAT_BC5_UNORM_BLOCK;
+		return KTX_TTF_BC5_RG;
+	}
+	if (etc1s && !hasAlpha) {
+		format = linear ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		return KTX_TTF_BC1_RGB;
+	}
+	format = linear ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC7_SRGB_BLOCK;
+	return KTX_TTF_BC7_RGBA;
+}
+
+static void copyLevels(ktxTexture2* tex, TextureLevels& out) {
+	ktxTexture* base = ktxTexture(tex);
+
+	out.width = tex->baseWidth;
+	out.height = tex->baseHeight;
+	out.levels = textureChainLayout(out.format, out.width, out.height, tex->numLevels);
+	if (out.levels.empty())
+		throw std::runtime_error("KTX2 format " + std::to_string((int)out.format) + " is not supported");
+
+	// Repack level 0 first; KTX2 stores the smallest level first
+	out.data.resize(out.levels.back().offset + out.levels.back().size);
+	const ktx_uint8_t* data = ktxTexture_GetData(base);
+	for (uint32_t level = 0; level < tex->numLevels; level++) {
+		ktx_size_t offset = 0;
+		ktxCheck(ktxTexture_GetImageOffset(base, level, 0, 0, &offset), "KTX2 level offset");
+		if (ktxTexture_GetImageSize(base, level) != out.levels[level].size)
+			throw std::runtime_error("KTX2 level " + std::to_string(level) + " does not match its format");
+		memcpy(out.data.data() + out.levels[level].offset, data + offset, out.levels[level].size);
+	}
+}
+
+void transcodeKtx2(State* state, std::span<const unsigned char> bytes, TextureRole role, TextureLevels& out) {
+	ktxTexture2* tex = nullptr;
+	ktxCheck(ktxTexture2_CreateFromMemory(bytes.data(), bytes.size(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &tex),
+		"KTX2 load");
+
+	try {
+		if (tex->numDimensions != 2 || tex->numLayers != 1 || tex->numFaces != 1 || tex->numLevels == 0)
+			throw std::runtime_error("KTX2 texture is not a single 2D image");
+
+		if (ktxTexture2_NeedsTranscoding(tex)) {
+			ktx_transcode_fmt_e target = transcodeTarget(state, tex, role, out.format);
+			ktxCheck(ktxTexture2_TranscodeBasis(tex, target, 0), "KTX2 transcode");
+		}
+		else {
+			out.format = (VkFormat)tex->vkFormat;
+			if (!state->context->textureCompressionBC &&
+				out.format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && out.format <= VK_FORMAT_BC7_SRGB_BLOCK)
+				throw std::runtime_error("KTX2 texture is BC compressed but the device has no BC support");
+		}
+		copyLevels(tex, out);
+	}
+	catch (...) {
+		ktxTexture_Destroy(ktxTexture(tex));
+		throw;
+	}
+	ktxTexture_Destroy(ktxTexture(tex));
+
+	// Single-level RGBA8 (e.g. the no-BC fallback) still gets a full chain
+	bool rgba8 = out.format == VK_FORMAT_R8G8B8A8_UNORM || out.format == VK_FORMAT_R8G8B8A8_SRGB;
+	if (rgba8 && out.levels.size() == 1 && mipLevelCount(out.width, out.height) > 1) {
+		out.levels = textureChainLayout(out.format, out.width, out.height, mipLevelCount(out.width, out.height));
+		out.data.resize(out.levels.back().offset + out.levels.back().size);
+		buildMipChainRGBA8(out.data.data(), out.levels, out.format == VK_FORMAT_R8G8B8A8_SRGB);
+	}
+}
+
+// True if every texel of level 0 has r == g == b
+static bool isGrey(const TextureLevels& rgba8) {
+	const unsigned char* p = rgba8.data.data();
+	size_t count = (size_t)rgba8.width * rgba8.height;
+	for (size_t i = 0; i < count; i++, p += 4)
+		if (p[0] != p[1] || p[0] != p[2])
+			return false;
+	return true;
+}
+
+static ktx_transcode_fmt_e compressTarget(const TextureLevels& rgba8, TextureRole role) {
+	switch (role) {
+	case TextureRole::Normal:            return KTX_TTF_BC5_RG;
+	case TextureRole::MetallicRoughness: return KTX_TTF_BC1_RGB;
+	// Occlusion may share an ORM texture with metallic-roughness, so only
+	// single-channel content drops to BC4
+	case TextureRole::Occlusion:         return isGrey(rgba8) ? KTX_TTF_BC4_R : KTX_TTF_BC1_RGB;
+	default:                             return KTX_TTF_BC7_RGBA;
+	}
+}
+
+void compressKtx2(const TextureLevels& rgba8, TextureRole role, const std::string& path, TextureLevels& out) {
+	ktxTextureCreateInfo createInfo{};
+	createInfo.vkFormat = (ktx_uint32_t)rgba8.format;
+	createInfo.baseWidth = rgba8.width;
+	createInfo.baseHeight = rgba8.height;
+	createInfo.baseDepth = 1;
+	createInfo.numDimensions = 2;
+	createInfo.numLevels = (ktx_uint32_t)rgba8.levels.size();
+	createInfo.numLayers = 1;
+	createInfo.numFaces = 1;
+	createInfo.isArray = KTX_FALSE;
+	createInfo.generateMipmaps = KTX_FALSE;
+
+	ktxTexture2* tex = nullptr;
+	ktxCheck(ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &tex), "KTX2 create");
+
+	try {
+		for (uint32_t level = 0; level < createInfo.numLevels; level++) {
+			const MipLevel& mip = rgba8.levels[level];
+			ktxCheck(ktxTexture_SetImageFromMemory(ktxTexture(tex), level, 0, 0, rgba8.data.data() + mip.offset, mip.size),
+				"KTX2 set level");
+		}
+
+		// Callers already run one texture per job
+		ktxBasisParams params{};
+		params.structSize = sizeof(params);
+		params.uastc = KTX_TRUE;
+		params.uastcFlags = KTX_PACK_UASTC_LEVEL_DEFAULT;
+		params.threadCount = 1;
+		ktxCheck(ktxTexture2_CompressBasisEx(tex, &params), "KTX2 UASTC encode");
+		ktxCheck(ktxTexture2_TranscodeBasis(tex, compressTarget(rgba8, role), 0), "KTX2 transcode");
+
+		out.format = (VkFormat)tex->vkFormat;
+		copyLevels(tex, out);
+
+		// Temp name per call: two textures may share an image and role
+		static std::atomic<uint32_t> serial{ 0 };
+		std::string tempPath = path + "." + std::to_string(serial++) + ".tmp";
+		// A failed write only costs the next load a re-encode
+		std::error_code ec;
+		if (ktxTexture_WriteToNamedFile(ktxTexture(tex), tempPath.c_str()) == KTX_SUCCESS)
+			std::filesystem::rename(tempPath, path, ec);
+		else
+			printf("compressKtx2: cannot write %s\n", tempPath.c_str());
+		if (ec)
+			std::filesystem::remove(tempPath, ec);
+	}
+	catch (...) {
+		ktxTexture_Destroy(ktxTexture(tex));
+		throw;
+	}
+	ktxTexture_Destroy(ktxTexture(tex));
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <span>
+#include <string>
+#include "scene/texture.h"
+
+struct State;
+struct TextureLevels;
+
+// True if bytes start with the KTX2 identifier.
+bool isKtx2(std::span<const unsigned char> bytes);
+
+// Loads a KTX2 image (KHR_texture_basisu) into out. Basis Universal payloads
+// are transcoded for the device: BC5 for normal maps, BC1 for opaque ETC1S,
+// BC7 otherwise, and RGBA8 when BC is unsupported. Mip levels come from the
+// file. Thread-safe; throws on malformed or unsupported files.
+void transcodeKtx2(State* state, std::span<const unsigned char> bytes, TextureRole role, TextureLevels& out);
+
+// Encodes an RGBA8 chain (every level already built) to UASTC and transcodes
+// it to the BC format used for role: BC7 for colour, BC5 for normals, BC1
+// for metallic-roughness, BC1 or BC4 (grey images) for occlusion. Writes the
+// result to path as KTX2 and returns the compressed chain in out. Thread-safe.
+void compressKtx2(const TextureLevels& rgba8, TextureRole role, const std::string& path, TextureLevels& out);
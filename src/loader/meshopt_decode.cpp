@@ -0,0 +1,387 @@
+#include "loader/meshopt_decode.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// ─────────────────────────────────────────────
+// Vertex codec
+// ─────────────────────────────────────────────
+// Each block of up to 256 vertices is stored one byte column at a time as
+// zigzag deltas against the previous vertex, packed in groups of 16 bytes at
+// 0, 2, 4 or 8 bits per byte (with 0xF.../0b11 escapes to a literal byte).
+static constexpr unsigned char VERTEX_HEADER = 0xA0;
+static constexpr size_t VERTEX_BLOCK_SIZE_BYTES = 8192;
+static constexpr size_t VERTEX_BLOCK_MAX_SIZE = 256;
+static constexpr size_t BYTE_GROUP_SIZE = 16;
+static constexpr size_t BYTE_GROUP_DECODE_LIMIT = 24;
+static constexpr size_t TAIL_MAX_SIZE = 32;
+
+static size_t vertexBlockSize(size_t vertexSize) {
+	size_t result = (VERTEX_BLOCK_SIZE_BYTES / vertexSize) & ~(BYTE_GROUP_SIZE - 1);
+	return std::min(result, VERTEX_BLOCK_MAX_SIZE);
+}
+
+static unsigned char unzigzag8(unsigned char v) {
+	return (unsigned char)(-(v & 1) ^ (v >> 1));
+}
+
+template <int Bits>
+static const unsigned char* decodeBytesGroupBits(const unsigned char* data, unsigned char* out) {
+	constexpr unsigned char escape = (1 << Bits) - 1;
+	const unsigned char* literals = data + BYTE_GROUP_SIZE * Bits / 8;
+
+	for (size_t i = 0; i < BYTE_GROUP_SIZE * Bits / 8; ++i) {
+		unsigned char byte = data[i];
+		for (int k = 0; k < 8 / Bits; ++k) {
+			unsigned char enc = byte >> (8 - Bits);
+			byte = (unsigned char)(byte << Bits);
+			*out++ = enc == escape ? *literals++ : enc;
+		}
+	}
+	return literals;
+}
+
+static const unsigned char* decodeBytes(const unsigned char* data, const unsigned char* end, unsigned char* out, size_t size) {
+	const unsigned char* header = data;
+	size_t headerSize = (size / BYTE_GROUP_SIZE + 3) / 4;
+	if ((size_t)(end - data) < headerSize)
+		return nullptr;
+	data += headerSize;
+
+	for (size_t i = 0; i < size; i += BYTE_GROUP_SIZE) {
+		if ((size_t)(end - data) < BYTE_GROUP_DECODE_LIMIT)
+			return nullptr;
+
+		size_t group = i / BYTE_GROUP_SIZE;
+		switch ((header[group / 4] >> ((group % 4) * 2)) & 3) {
+		case 0: memset(out + i, 0, BYTE_GROUP_SIZE); break;
+		case 1: data = decodeBytesGroupBits<2>(data, out + i); break;
+		case 2: data = decodeBytesGroupBits<4>(data, out + i); break;
+		default:
+			memcpy(out + i, data, BYTE_GROUP_SIZE);
+			data += BYTE_GROUP_SIZE;
+			break;
+		}
+	}
+	return data;
+}
+
+static const unsigned char* decodeVertexBlock(const unsigned char* data, const unsigned char* end, unsigned char* out,
+	size_t count, size_t vertexSize, unsigned char last[256])
+{
+	unsigned char deltas[VERTEX_BLOCK_MAX_SIZE];
+	size_t countAligned = (count + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+
+	for (size_t k = 0; k < vertexSize; ++k) {
+		data = decodeBytes(data, end, deltas, countAligned);
+		if (!data)
+			return nullptr;
+
+		unsigned char p = last[k];
+		for (size_t i = 0; i < count; ++i) {
+			p = (unsigned char)(p + unzigzag8(deltas[i]));
+			out[i * vertexSize + k] = p;
+		}
+	}
+	memcpy(last, out + (count - 1) * vertexSize, vertexSize);
+	return data;
+}
+
+static bool decodeVertexBuffer(unsigned char* dst, size_t count, size_t vertexSize, const unsigned char* data, size_t size) {
+	if (vertexSize == 0 || vertexSize > 256 || vertexSize % 4 != 0)
+		return false;
+	if (size < 1 + vertexSize || data[0] != VERTEX_HEADER)
+		return false;
+
+	const unsigned char* end = data + size;
+	unsigned char last[256];
+	memcpy(last, end - vertexSize, vertexSize);
+	++data;
+
+	size_t blockSize = vertexBlockSize(vertexSize);
+	for (size_t first = 0; first < count; first += blockSize) {
+		size_t n = std::min(blockSize, count - first);
+		data = decodeVertexBlock(data, end, dst + first * vertexSize, n, vertexSize, last);
+		if (!data)
+			return false;
+	}
+	return (size_t)(end - data) == std::max(vertexSize, TAIL_MAX_SIZE);
+}
+
+// ─────────────────────────────────────────────
+// Index codec (triangle lists)
+// ─────────────────────────────────────────────
+// One code byte per triangle picks a recently seen edge and/or vertices from
+// 16-entry FIFOs; vertices that are neither new nor recent follow as varint
+// deltas. The last 16 bytes are a lookup table for the common aux codes.
+static constexpr unsigned char INDEX_HEADER = 0xE0;
+static constexpr unsigned char SEQUENCE_HEADER = 0xD0;
+
+struct IndexFifos {
+	uint32_t edges[16][2];
+	uint32_t vertices[16];
+	size_t edgeOffset = 0;
+	size_t vertexOffset = 0;
+
+	IndexFifos() {
+		memset(edges, -1, sizeof(edges));
+		memset(vertices, -1, sizeof(vertices));
+	}
+	void pushEdge(uint32_t a, uint32_t b) {
+		edges[edgeOffset][0] = a;
+		edges[edgeOffset][1] = b;
+		edgeOffset = (edgeOffset + 1) & 15;
+	}
+	void pushVertex(uint32_t v, bool advance = true) {
+		vertices[vertexOffset] = v;
+		vertexOffset = (vertexOffset + (advance ? 1 : 0)) & 15;
+	}
+};
+
+static uint32_t decodeVByte(const unsigned char*& data) {
+	unsigned char lead = *data++;
+	if (lead < 128)
+		return lead;
+
+	uint32_t result = lead & 127;
+	uint32_t shift = 7;
+	for (int i = 0; i < 4; ++i) {
+		unsigned char group = *data++;
+		result |= uint32_t(group & 127) << shift;
+		shift += 7;
+		if (group < 128)
+			break;
+	}
+	return result;
+}
+
+static uint32_t decodeIndexDelta(const unsigned char*& data, uint32_t last) {
+	uint32_t v = decodeVByte(data);
+	return last + ((v >> 1) ^ (0u - (v & 1)));
+}
+
+static void writeIndex(unsigned char* dst, size_t i, size_t indexSize, uint32_t v) {
+	if (indexSize == 2) {
+		uint16_t s = (uint16_t)v;
+		memcpy(dst + i * 2, &s, 2);
+	}
+	else {
+		memcpy(dst + i * 4, &v, 4);
+	}
+}
+
+static bool decodeIndexBuffer(unsigned char* dst, size_t count, size_t indexSize, const unsigned char* buffer, size_t size) {
+	if (count % 3 != 0 || (indexSize != 2 && indexSize != 4))
+		return false;
+	if (size < 1 + count / 3 + 16 || (buffer[0] & 0xF0) != INDEX_HEADER)
+		return false;
+	int version = buffer[0] & 0x0F;
+	if (version > 1)
+		return false;
+
+	IndexFifos fifo;
+	uint32_t next = 0;
+	uint32_t last = 0;
+	int fecMax = version >= 1 ? 13 : 15;
+
+	const unsigned char* code = buffer + 1;
+	const unsigned char* data = code + count / 3;
+	const unsigned char* dataSafeEnd = buffer + size - 16;
+	const unsigned char* codeAuxTable = dataSafeEnd;
+
+	for (size_t i = 0; i < count; i += 3) {
+		// A triangle reads at most 16 bytes past data, which the table covers
+		if (data > dataSafeEnd)
+			return false;
+
+		unsigned char codeTri = *code++;
+		uint32_t a, b, c;
+
+		if (codeTri < 0xF0) {
+			// Reused edge plus one vertex
+			int fe = codeTri >> 4;
+			a = fifo.edges[(fifo.edgeOffset - 1 - fe) & 15][0];
+			b = fifo.edges[(fifo.edgeOffset - 1 - fe) & 15][1];
+
+			int fec = codeTri & 15;
+			if (fec < fecMax) {
+				c = fec == 0 ? next : fifo.vertices[(fifo.vertexOffset - 1 - fec) & 15];
+				next += fec == 0;
+				fifo.pushVertex(c, fec == 0);
+			}
+			else {
+				// 13/14 are +-1 from the last free index (v1), 15 a varint delta
+				c = last = fec != 15 ? last + (fec - (fec ^ 3)) : decodeIndexDelta(data, last);
+				fifo.pushVertex(c);
+			}
+			fifo.pushEdge(c, b);
+			fifo.pushEdge(a, c);
+		}
+		else {
+			int fea, feb, fec;
+			if (codeTri < 0xFE) {
+				unsigned char codeAux = codeAuxTable[codeTri & 15];
+				fea = 0;
+				feb = codeAux >> 4;
+				fec = codeAux & 15;
+			}
+			else {
+				unsigned char codeAux = *data++;
+				fea = codeTri == 0xFE ? 0 : 15;
+				feb = codeAux >> 4;
+				fec = codeAux & 15;
+				if (codeAux == 0)
+					next = 0;
+			}
+
+			// next advances for each new vertex before any free index is read
+			a = fea == 0 ? next++ : 0;
+			b = feb == 0 ? next++ : fifo.vertices[(fifo.vertexOffset - feb) & 15];
+			c = fec == 0 ? next++ : fifo.vertices[(fifo.vertexOffset - fec) & 15];
+
+			if (fea == 15) last = a = decodeIndexDelta(data, last);
+			if (feb == 15) last = b = decodeIndexDelta(data, last);
+			if (fec == 15) last = c = decodeIndexDelta(data, last);
+
+			fifo.pushVertex(a);
+			fifo.pushVertex(b, feb == 0 || feb == 15);
+			fifo.pushVertex(c, fec == 0 || fec == 15);
+			fifo.pushEdge(b, a);
+			fifo.pushEdge(c, b);
+			fifo.pushEdge(a, c);
+		}
+
+		writeIndex(dst, i + 0, indexSize, a);
+		writeIndex(dst, i + 1, indexSize, b);
+		writeIndex(dst, i + 2, indexSize, c);
+	}
+	return data == dataSafeEnd;
+}
+
+// ─────────────────────────────────────────────
+// Index sequence codec (arbitrary index lists)
+// ─────────────────────────────────────────────
+// Varint zigzag deltas against one of two running baselines.
+static bool decodeIndexSequence(unsigned char* dst, size_t count, size_t indexSize, const unsigned char* buffer, size_t size) {
+	if (indexSize != 2 && indexSize != 4)
+		return false;
+	if (size < 1 + count + 4 || (buffer[0] & 0xF0) != SEQUENCE_HEADER || (buffer[0] & 0x0F) > 1)
+		return false;
+
+	const unsigned char* data = buffer + 1;
+	const unsigned char* dataSafeEnd = buffer + size - 4;
+	uint32_t last[2] = {};
+
+	for (size_t i = 0; i < count; ++i) {
+		// At most 5 bytes per index, covered by the 4-byte tail
+		if (data >= dataSafeEnd)
+			return false;
+
+		uint32_t v = decodeVByte(data);
+		uint32_t baseline = v & 1;
+		v >>= 1;
+		uint32_t index = last[baseline] + ((v >> 1) ^ (0u - (v & 1)));
+		last[baseline] = index;
+		writeIndex(dst, i, indexSize, index);
+	}
+	return data == dataSafeEnd;
+}
+
+// ─────────────────────────────────────────────
+// Filters (applied in place after the vertex codec)
+// ─────────────────────────────────────────────
+template <typename T>
+static void filterOctahedral(unsigned char* bytes, size_t count) {
+	const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+
+	for (size_t i = 0; i < count; ++i) {
+		T e[4];
+		memcpy(e, bytes + i * sizeof(e), sizeof(e));
+
+		// z stores the encoding's 1.0 at the same bit count
+		float x = float(e[0]);
+		float y = float(e[1]);
+		float z = float(e[2]) - std::fabs(x) - std::fabs(y);
+		float t = std::min(z, 0.0f);
+		x += x >= 0.0f ? t : -t;
+		y += y >= 0.0f ? t : -t;
+
+		float s = max / std::sqrt(x * x + y * y + z * z);
+		e[0] = T(int(x * s + (x >= 0.0f ? 0.5f : -0.5f)));
+		e[1] = T(int(y * s + (y >= 0.0f ? 0.5f : -0.5f)));
+		e[2] = T(int(z * s + (z >= 0.0f ? 0.5f : -0.5f)));
+		memcpy(bytes + i * sizeof(e), e, sizeof(e));
+	}
+}
+
+static void filterQuaternion(unsigned char* bytes, size_t count) {
+	const float scale = 1.0f / std::sqrt(2.0f);
+
+	for (size_t i = 0; i < count; ++i) {
+		int16_t e[4];
+		memcpy(e, bytes + i * sizeof(e), sizeof(e));
+
+		// w holds the largest component's index (low 2 bits) and the scale
+		float ss = scale / float(e[3] | 3);
+		float x = float(e[0]) * ss;
+		float y = float(e[1]) * ss;
+		float z = float(e[2]) * ss;
+		float w = std::sqrt(std::max(1.0f - x * x - y * y - z * z, 0.0f));
+
+		int qc = e[3] & 3;
+		int16_t out[4];
+		out[(qc + 1) & 3] = int16_t(int(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f)));
+		out[(qc + 2) & 3] = int16_t(int(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f)));
+		out[(qc + 3) & 3] = int16_t(int(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f)));
+		out[(qc + 0) & 3] = int16_t(int(w * 32767.0f + 0.5f));
+		memcpy(bytes + i * sizeof(out), out, sizeof(out));
+	}
+}
+
+static void filterExponential(unsigned char* bytes, size_t words) {
+	for (size_t i = 0; i < words; ++i) {
+		uint32_t v;
+		memcpy(&v, bytes + i * 4, 4);
+
+		// 24-bit signed mantissa, 8-bit signed exponent
+		int32_t m = int32_t(v << 8) >> 8;
+		int32_t e = int32_t(v) >> 24;
+		float f = std::ldexp(float(m), e);
+		memcpy(bytes + i * 4, &f, 4);
+	}
+}
+
+bool meshoptDecode(const MeshoptStream& stream, unsigned char* dst) {
+	switch (stream.mode) {
+	case MeshoptMode::Attributes: {
+		if (!decodeVertexBuffer(dst, stream.count, stream.stride, stream.data, stream.size))
+			return false;
+
+		switch (stream.filter) {
+		case MeshoptFilter::None:
+			return true;
+		case MeshoptFilter::Octahedral:
+			if (stream.stride == 4) filterOctahedral<int8_t>(dst, stream.count);
+			else if (stream.stride == 8) filterOctahedral<int16_t>(dst, stream.count);
+			else return false;
+			return true;
+		case MeshoptFilter::Quaternion:
+			if (stream.stride != 8)
+				return false;
+			filterQuaternion(dst, stream.count);
+			return true;
+		case MeshoptFilter::Exponential:
+			filterExponential(dst, stream.count * stream.stride / 4);
+			return true;
+		}
+		return false;
+	}
+	case MeshoptMode::Triangles:
+		return stream.filter == MeshoptFilter::None &&
+			decodeIndexBuffer(dst, stream.count, stream.stride, stream.data, stream.size);
+	case MeshoptMode::Indices:
+		return stream.filter == MeshoptFilter::None &&
+			decodeIndexSequence(dst, stream.count, stream.stride, stream.data, stream.size);
+	}
+	return false;
+}
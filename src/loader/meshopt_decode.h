@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Decoders for the meshoptimizer bitstreams used by EXT_meshopt_compression
+// (vertex codec v0, index codec v0/v1, index sequence v1).
+enum class MeshoptMode : uint32_t {
+	Attributes,
+	Triangles,
+	Indices,
+};
+
+enum class MeshoptFilter : uint32_t {
+	None,
+	Octahedral,
+	Quaternion,
+	Exponential,
+};
+
+// One compressed bufferView: count elements of stride bytes.
+struct MeshoptStream {
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	size_t count = 0;
+	size_t stride = 0;
+	MeshoptMode mode = MeshoptMode::Attributes;
+	MeshoptFilter filter = MeshoptFilter::None;
+};
+
+// Writes count * stride bytes to dst; false if the stream is malformed or the
+// mode/filter/stride combination is not allowed. Thread-safe.
+bool meshoptDecode(const MeshoptStream& stream, unsigned char* dst);
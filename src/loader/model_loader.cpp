@@ -0,0 +1,983 @@
+#include "loader/model_loader.h"
+#include "loader/runepak.h"
+#include "loader/gltf_textures.h"
+#include "loader/gltf_meshes.h"
+#include "resources/buffers.h"
+#include "render/descriptors.h"
+#include "render/renderer.h"
+#include "render/skinning.h"
+#include "render/texture_streaming.h"
+#include "scene/materials.h"
+#include "scene/texture.h"
+#include "scene/model.h"
+#include "scene/scene.h"
+#include "scene/transforms.h"
+#include "core/config.h"
+#include "core/context.h"
+#include "core/file_map.h"
+#include "core/jobs.h"
+#include "core/load_stats.h"
+#include "core/state.h"
+#include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+// Uploads submitted by one poll share a submission, so also its fence and
+// semaphore; the last upload released destroys them.
+struct UploadBatch {
+	VkFence fence = VK_NULL_HANDLE;
+	VkSemaphore transferDone = VK_NULL_HANDLE;  // transfer to graphics queue, when the families differ
+	uint32_t uploads = 0;
+};
+
+// Everything a load owns between decode and publish.
+struct ModelUpload {
+	RunePakContents pak;
+	std::vector<Texture*> textures;     // null where the scene already had it
+	std::vector<int> textureIndices;    // scene index acquired by the worker, else -1
+	std::vector<glm::mat4> instances;  // copied out, the mapping closes after staging
+	std::vector<bool> meshResident;     // reloads: buffers taken from the replaced model
+	VkBuffer instanceBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory instanceMemory = VK_NULL_HANDLE;
+
+	VkBuffer staging = VK_NULL_HANDLE;
+	VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+
+	VkCommandPool transferPool = VK_NULL_HANDLE;
+	VkCommandBuffer transferCmd = VK_NULL_HANDLE;
+	VkCommandBuffer acquireCmd = VK_NULL_HANDLE;  // from renderer->commandPool
+	UploadBatch* batch = nullptr;                  // once submitted
+
+	// Release half of the ownership transfer; replayed as the acquire on the
+	// graphics queue when the families differ.
+	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+};
+
+static VkDeviceSize alignStaging(VkDeviceSize value) {
+	return (value + 15) & ~VkDeviceSize(15);
+}
+
+static bool ownershipTransfer(State* state) {
+	return state->context->transferFamilyIndex != state->context->queueFamilyIndex;
+}
+
+// First mip level a new texture's image holds
+static uint32_t residentLevel(const Texture* tex) {
+	return tex->stream ? tex->stream->residentMip : 0;
+}
+
+// Bytes uploaded for it, from firstOffset to the end of the packaged chain
+static size_t residentBytes(const RunePakTexture& r, const Texture* tex, size_t& firstOffset) {
+	std::vector<MipLevel> levels = textureChainFrom(r, residentLevel(tex), firstOffset);
+	return levels.back().offset + levels.back().size;
+}
+
+static void deleteNodes(Node* node) {
+	for (Node* child : node->children)
+		deleteNodes(child);
+	delete node;
+}
+
+static void destroyTextureImage(State* state, Texture* tex) {
+	VkDevice device = state->context->device;
+	textureStreamRelease(state, tex);
+	if (tex->textureSampler) vkDestroySampler(device, tex->textureSampler, nullptr);
+	if (tex->textureImageView) vkDestroyImageView(device, tex->textureImageView, nullptr);
+	if (tex->textureImage) vkDestroyImage(device, tex->textureImage, nullptr);
+	if (tex->textureImageMemory) vkFreeMemory(device, tex->textureImageMemory, nullptr);
+}
+
+// Frees the transient upload objects; the model's own resources are kept.
+static void releaseUploadObjects(State* state, ModelUpload* up) {
+	VkDevice device = state->context->device;
+
+	if (up->acquireCmd)
+		vkFreeCommandBuffers(device, state->renderer->commandPool, 1, &up->acquireCmd);
+	if (up->transferPool)
+		vkDestroyCommandPool(device, up->transferPool, nullptr);
+	if (up->batch && --up->batch->uploads == 0) {
+		if (up->batch->transferDone)
+			vkDestroySemaphore(device, up->batch->transferDone, nullptr);
+		vkDestroyFence(device, up->batch->fence, nullptr);
+		delete up->batch;
+	}
+	if (up->staging)
+		vkDestroyBuffer(device, up->staging, nullptr);
+	if (up->stagingMemory)
+		vkFreeMemory(device, up->stagingMemory, nullptr);
+
+	up->acquireCmd = VK_NULL_HANDLE;
+	up->transferCmd = VK_NULL_HANDLE;
+	up->transferPool = VK_NULL_HANDLE;
+	up->batch = nullptr;
+	up->staging = VK_NULL_HANDLE;
+	up->stagingMemory = VK_NULL_HANDLE;
+	fileMapClose(up->pak.file);
+}
+
+// Destroys an upload that never reached the scene, GPU resources included.
+static void discardUpload(State* state, ModelUpload* up) {
+	VkDevice device = state->context->device;
+	releaseUploadObjects(state, up);
+
+	for (Mesh* mesh : up->pak.meshes) {
+		if (mesh->vertexBuffer) vkDestroyBuffer(device, mesh->vertexBuffer, nullptr);
+		if (mesh->vertexMemory) vkFreeMemory(device, mesh->vertexMemory, nullptr);
+		if (mesh->indexBuffer) vkDestroyBuffer(device, mesh->indexBuffer, nullptr);
+		if (mesh->indexMemory) vkFreeMemory(device, mesh->indexMemory, nullptr);
+		if (mesh->skinBuffer) vkDestroyBuffer(device, mesh->skinBuffer, nullptr);
+		if (mesh->skinMemory) vkFreeMemory(device, mesh->skinMemory, nullptr);
+		if (mesh->morphBuffer) vkDestroyBuffer(device, mesh->morphBuffer, nullptr);
+		if (mesh->morphMemory) vkFreeMemory(device, mesh->morphMemory, nullptr);
+		delete mesh;
+	}
+	if (up->instanceBuffer) vkDestroyBuffer(device, up->instanceBuffer, nullptr);
+	if (up->instanceMemory) vkFreeMemory(device, up->instanceMemory, nullptr);
+	for (Texture* tex : up->textures) {
+		if (!tex)
+			continue;
+		destroyTextureImage(state, tex);
+		delete tex;
+	}
+	// Nothing drew the model, so a last reference can go right away
+	for (int index : up->textureIndices) {
+		if (index < 0)
+			continue;
+		if (Texture* tex = sceneReleaseTexture(state->scene, (uint32_t)index)) {
+			destroyTextureImage(state, tex);
+			delete tex;
+		}
+	}
+	for (Material* mat : up->pak.materials)
+		delete mat;
+	if (up->pak.rootNode)
+		deleteNodes(up->pak.rootNode);
+	delete up;
+}
+
+// ─────────────────────────────────────────────
+// Worker side
+// ─────────────────────────────────────────────
+static void openPackage(State* state, const std::string& path, RunePakContents& pak) {
+	uint64_t sourceHash = 0;
+	if (!fileContentHash(path, sourceHash))
+		throw std::runtime_error("cannot read " + path);
+
+	std::string pakPath = runepakPath(path);
+	uint32_t features = runepakFeatures(state);
+	if (runepakOpen(pakPath, sourceHash, features, pak))
+		return;
+	if (!runepakCook(state, path, pakPath, sourceHash) || !runepakOpen(pakPath, sourceHash, features, pak))
+		throw std::runtime_error("cannot cook " + pakPath);
+}
+
+static void recordTransfer(State* state, ModelUpload* up, const std::vector<VkDeviceSize>& offsets) {
+	VkDevice device = state->context->device;
+	const RunePakContents& pak = up->pak;
+	bool ownership = ownershipTransfer(state);
+	uint32_t srcFamily = ownership ? state->context->transferFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+	uint32_t dstFamily = ownership ? state->context->queueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+
+	VkCommandPoolCreateInfo poolInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+		.queueFamilyIndex = state->context->transferFamilyIndex,
+	};
+	PANIC(vkCreateCommandPool(device, &poolInfo, nullptr, &up->transferPool), "Failed To Create Transfer Command Pool");
+
+	VkCommandBufferAllocateInfo allocInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		.commandPool = up->transferPool,
+		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		.commandBufferCount = 1,
+	};
+	PANIC(vkAllocateCommandBuffers(device, &allocInfo, &up->transferCmd), "Failed To Allocate Transfer Command Buffer");
+
+	VkCommandBufferBeginInfo beginInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+	};
+	vkBeginCommandBuffer(up->transferCmd, &beginInfo);
+
+	// Images: UNDEFINED -> TRANSFER_DST
+	std::vector<VkImageMemoryBarrier> toTransfer;
+	for (Texture* tex : up->textures) {
+		if (!tex)
+			continue;
+		toTransfer.push_back(VkImageMemoryBarrier{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = 0,
+			.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = tex->textureImage,
+			.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, tex->mipLevels, 0, 1 },
+		});
+	}
+	if (!toTransfer.empty())
+		vkCmdPipelineBarrier(up->transferCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, (uint32_t)toTransfer.size(), toTransfer.data());
+
+	// Copies, in the same order the staging offsets were laid out. Resident
+	// meshes of a reload and cached textures have no destination.
+	size_t slot = 0;
+	for (uint32_t i = 0; i < pak.header->meshCount; i++) {
+		const RunePakMesh& r = pak.meshRecords[i];
+		const Mesh* mesh = pak.meshes[i];
+		VkDeviceSize vertexBytes = runepakVertexBytes(*pak.header, r);
+		VkDeviceSize indexBytes = runepakIndexBytes(r);
+
+		if (mesh->vertexBuffer) {
+			VkBufferCopy copy{ offsets[slot], 0, vertexBytes };
+			vkCmdCopyBuffer(up->transferCmd, up->staging, mesh->vertexBuffer, 1, &copy);
+			up->bufferBarriers.push_back(VkBufferMemoryBarrier{
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+					(r.skinOffset || r.morphOffset ? VK_ACCESS_SHADER_READ_BIT : 0u) |
+					(r.morphOffset ? VK_ACCESS_TRANSFER_READ_BIT : 0u),
+				.srcQueueFamilyIndex = srcFamily,
+				.dstQueueFamilyIndex = dstFamily,
+				.buffer = mesh->vertexBuffer,
+				.offset = 0,
+				.size = VK_WHOLE_SIZE,
+			});
+		}
+		slot++;
+		if (mesh->indexBuffer) {
+			VkBufferCopy copy{ offsets[slot], 0, indexBytes };
+			vkCmdCopyBuffer(up->transferCmd, up->staging, mesh->indexBuffer, 1, &copy);
+			up->bufferBarriers.push_back(VkBufferMemoryBarrier{
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_INDEX_READ_BIT,
+				.srcQueueFamilyIndex = srcFamily,
+				.dstQueueFamilyIndex = dstFamily,
+				.buffer = mesh->indexBuffer,
+				.offset = 0,
+				.size = VK_WHOLE_SIZE,
+			});
+		}
+		slot++;
+		if (mesh->skinBuffer) {
+			VkBufferCopy copy{ offsets[slot], 0, runepakSkinBytes(r) };
+			vkCmdCopyBuffer(up->transferCmd, up->staging, mesh->skinBuffer, 1, &copy);
+			up->bufferBarriers.push_back(VkBufferMemoryBarrier{
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+				.srcQueueFamilyIndex = srcFamily,
+				.dstQueueFamilyIndex = dstFamily,
+				.buffer = mesh->skinBuffer,
+				.offset = 0,
+				.size = VK_WHOLE_SIZE,
+			});
+		}
+		slot++;
+		if (mesh->morphBuffer) {
+			VkBufferCopy copy{ offsets[slot], 0, runepakMorphBytes(r) };
+			vkCmdCopyBuffer(up->transferCmd, up->staging, mesh->morphBuffer, 1, &copy);
+			up->bufferBarriers.push_back(VkBufferMemoryBarrier{
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+				.srcQueueFamilyIndex = srcFamily,
+				.dstQueueFamilyIndex = dstFamily,
+				.buffer = mesh->morphBuffer,
+				.offset = 0,
+				.size = VK_WHOLE_SIZE,
+			});
+		}
+		slot++;
+	}
+	if (up->instanceBuffer) {
+		VkBufferCopy copy{ offsets[slot], 0, up->instances.size() * sizeof(glm::mat4) };
+		vkCmdCopyBuffer(up->transferCmd, up->staging, up->instanceBuffer, 1, &copy);
+		up->bufferBarriers.push_back(VkBufferMemoryBarrier{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+			.srcQueueFamilyIndex = srcFamily,
+			.dstQueueFamilyIndex = dstFamily,
+			.buffer = up->instanceBuffer,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE,
+		});
+	}
+	slot++;
+	for (uint32_t i = 0; i < pak.header->textureCount; i++) {
+		const RunePakTexture& r = pak.textureRecords[i];
+		Texture* tex = up->textures[i];
+		VkDeviceSize offset = offsets[slot++];
+		if (!tex)
+			continue;
+		size_t firstOffset = 0;
+		std::vector<VkBufferImageCopy> regions = mipCopyRegions(
+			textureChainFrom(r, residentLevel(tex), firstOffset), offset);
+		vkCmdCopyBufferToImage(up->transferCmd, up->staging, tex->textureImage,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(), regions.data());
+
+		up->imageBarriers.push_back(VkImageMemoryBarrier{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+			.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			.srcQueueFamilyIndex = srcFamily,
+			.dstQueueFamilyIndex = dstFamily,
+			.image = tex->textureImage,
+			.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, tex->mipLevels, 0, 1 },
+		});
+	}
+
+	// Release. A transfer-only queue cannot name graphics stages or accesses,
+	// so those belong to the acquire recorded on the graphics queue.
+	std::vector<VkBufferMemoryBarrier> bufferRelease = up->bufferBarriers;
+	std::vector<VkImageMemoryBarrier> imageRelease = up->imageBarriers;
+	VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	if (ownership) {
+		for (VkBufferMemoryBarrier& b : bufferRelease) b.dstAccessMask = 0;
+		for (VkImageMemoryBarrier& b : imageRelease) b.dstAccessMask = 0;
+		dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	}
+	if (!bufferRelease.empty() || !imageRelease.empty())
+		vkCmdPipelineBarrier(up->transferCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr,
+			(uint32_t)bufferRelease.size(), bufferRelease.data(),
+			(uint32_t)imageRelease.size(), imageRelease.data());
+
+	PANIC(vkEndCommandBuffer(up->transferCmd), "Failed To Record Transfer Command Buffer");
+}
+
+// Takes one of the resident copies of hash, if any is left
+static bool takeResident(std::unordered_map<uint64_t, uint32_t>& resident, uint64_t hash) {
+	auto it = resident.find(hash);
+	if (it == resident.end() || it->second == 0)
+		return false;
+	it->second--;
+	return true;
+}
+
+static void decodeModel(State* state, ModelLoad* load) {
+	VkDevice device = state->context->device;
+	ModelUpload* up = new ModelUpload{};
+	load->upload = up;
+
+	openPackage(state, load->path, up->pak);
+	const RunePakContents& pak = up->pak;
+	const unsigned char* data = pak.file.data;
+	up->instances.assign(pak.instances, pak.instances + pak.header->instanceCount);
+	VkDeviceSize instanceBytes = up->instances.size() * sizeof(glm::mat4);
+
+	// A reload skips the meshes the replaced model already has on the GPU
+	// with identical contents; publish moves those handles over
+	std::unordered_map<uint64_t, uint32_t> residentMeshes;
+	for (uint64_t hash : load->residentMeshes)
+		residentMeshes[hash]++;
+	up->meshResident.resize(pak.header->meshCount);
+	for (uint32_t i = 0; i < pak.header->meshCount; i++)
+		up->meshResident[i] = takeResident(residentMeshes, pak.meshRecords[i].contentHash);
+
+	// Textures any model already has resident are referenced, not uploaded.
+	// Streamed ones upload their tail and keep the package mapped.
+	std::shared_ptr<const MappedFile> package = textureStreamPackage(up->pak.file);
+	up->textureIndices.resize(pak.header->textureCount);
+	for (uint32_t i = 0; i < pak.header->textureCount; i++) {
+		const RunePakTexture& r = pak.textureRecords[i];
+		up->textureIndices[i] = sceneAcquireTexture(state->scene, textureCacheKey(r.contentHash, (TextureRole)r.role));
+		if (up->textureIndices[i] >= 0) {
+			up->textures.push_back(nullptr);
+			continue;
+		}
+		Texture* tex = new Texture{};
+		tex->role = (TextureRole)r.role;
+		tex->contentHash = r.contentHash;
+		tex->stream = textureStreamCreate(state, r, package);
+		up->textures.push_back(tex);
+	}
+
+	// One staging buffer for the whole model: vertex, index, skin and morph
+	// blob of every mesh, the instance transforms, then every texture chain
+	std::vector<VkDeviceSize> offsets;
+	VkDeviceSize stagingSize = 0;
+	for (uint32_t i = 0; i < pak.header->meshCount; i++) {
+		const RunePakMesh& r = pak.meshRecords[i];
+		if (up->meshResident[i]) {
+			offsets.insert(offsets.end(), 4, stagingSize);
+			continue;
+		}
+		offsets.push_back(stagingSize);
+		stagingSize = alignStaging(stagingSize + runepakVertexBytes(*pak.header, r));
+		offsets.push_back(stagingSize);
+		stagingSize = alignStaging(stagingSize + runepakIndexBytes(r));
+		offsets.push_back(stagingSize);
+		stagingSize = alignStaging(stagingSize + runepakSkinBytes(r));
+		offsets.push_back(stagingSize);
+		stagingSize = alignStaging(stagingSize + runepakMorphBytes(r));
+	}
+	offsets.push_back(stagingSize);
+	stagingSize = alignStaging(stagingSize + instanceBytes);
+	for (uint32_t i = 0; i < pak.header->textureCount; i++) {
+		offsets.push_back(stagingSize);
+		size_t firstOffset = 0;
+		if (up->textures[i])
+			stagingSize = alignStaging(stagingSize + residentBytes(pak.textureRecords[i], up->textures[i], firstOffset));
+	}
+
+	if (stagingSize > 0) {
+		createBuffer(state, stagingSize,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			up->staging, up->stagingMemory);
+		loadStatsAddUploaded(state, stagingSize);
+
+		unsigned char* mapped = nullptr;
+		vkMapMemory(device, up->stagingMemory, 0, stagingSize, 0, reinterpret_cast<void**>(&mapped));
+		size_t slot = 0;
+		for (uint32_t i = 0; i < pak.header->meshCount; i++) {
+			const RunePakMesh& r = pak.meshRecords[i];
+			if (up->meshResident[i]) {
+				slot += 4;
+				continue;
+			}
+			memcpy(mapped + offsets[slot++], data + r.vertexOffset, (size_t)runepakVertexBytes(*pak.header, r));
+			memcpy(mapped + offsets[slot++], data + r.indexOffset, (size_t)runepakIndexBytes(r));
+			if (r.skinOffset)
+				memcpy(mapped + offsets[slot], data + r.skinOffset, (size_t)runepakSkinBytes(r));
+			slot++;
+			if (r.morphOffset)
+				memcpy(mapped + offsets[slot], data + r.morphOffset, (size_t)runepakMorphBytes(r));
+			slot++;
+		}
+		if (instanceBytes)
+			memcpy(mapped + offsets[slot], up->instances.data(), (size_t)instanceBytes);
+		slot++;
+		for (uint32_t i = 0; i < pak.header->textureCount; i++, slot++) {
+			const RunePakTexture& r = pak.textureRecords[i];
+			if (!up->textures[i])
+				continue;
+			size_t firstOffset = 0;
+			size_t bytes = residentBytes(r, up->textures[i], firstOffset);
+			memcpy(mapped + offsets[slot], data + r.dataOffset + firstOffset, bytes);
+		}
+		vkUnmapMemory(device, up->stagingMemory);
+	}
+
+	// Destination resources, exclusive to the transfer family until released
+	for (uint32_t i = 0; i < pak.header->meshCount; i++) {
+		const RunePakMesh& r = pak.meshRecords[i];
+		Mesh* mesh = pak.meshes[i];
+		if (up->meshResident[i])
+			continue;
+		if (r.vertexCount)
+			createBuffer(state, runepakVertexBytes(*pak.header, r),
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT | meshVertexUsage(*mesh),
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh->vertexBuffer, mesh->vertexMemory);
+		if (r.skinOffset)
+			createBuffer(state, runepakSkinBytes(r),
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh->skinBuffer, mesh->skinMemory);
+		if (r.morphOffset)
+			createBuffer(state, runepakMorphBytes(r),
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh->morphBuffer, mesh->morphMemory);
+		if (r.indexCount)
+			createBuffer(state, runepakIndexBytes(r),
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh->indexBuffer, mesh->indexMemory);
+	}
+	if (instanceBytes)
+		createBuffer(state, instanceBytes,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, up->instanceBuffer, up->instanceMemory);
+	for (uint32_t i = 0; i < pak.header->textureCount; i++) {
+		Texture* tex = up->textures[i];
+		if (!tex)
+			continue;
+		size_t firstOffset = 0;
+		std::vector<MipLevel> levels = textureChainFrom(pak.textureRecords[i], residentLevel(tex), firstOffset);
+		createTextureForLevels(state, (VkFormat)pak.textureRecords[i].format,
+			levels[0].width, levels[0].height, (uint32_t)levels.size(), *tex);
+	}
+
+	recordTransfer(state, up, offsets);
+
+	// The blobs now live in staging; the mapping stays open only for streams
+}
+
+// ─────────────────────────────────────────────
+// Main thread
+// ─────────────────────────────────────────────
+void modelLoaderCreate(State* state) {
+	state->loader = new ModelLoader{};
+	fileWatcherCreate(state->loader->watcher);
+	printf("modelLoaderCreate: transfer family %u (graphics %u)\n",
+		state->context->transferFamilyIndex, state->context->queueFamilyIndex);
+}
+
+static void destroyRetired(State* state, RetiredModel& retired) {
+	VkDevice device = state->context->device;
+	Model* model = retired.model;
+	for (uint32_t index : model->textureIndices) {
+		if (Texture* tex = sceneReleaseTexture(state->scene, index)) {
+			destroyTextureImage(state, tex);
+			delete tex;
+		}
+	}
+	for (uint32_t index : model->materialIndices) {
+		if (Material* mat = sceneReleaseMaterial(state->scene, index)) {
+			if (mat->materialBuffer) vkDestroyBuffer(device, mat->materialBuffer, nullptr);
+			if (mat->materialMemory) vkFreeMemory(device, mat->materialMemory, nullptr);
+			delete mat;
+		}
+	}
+
+	if (model->rootNode)
+		nodeTreeDestroy(state, model->rootNode);
+	model->rootNode = nullptr;
+	instanceBufferDestroy(state, model);
+	skinningDestroy(state, model);
+	delete model;
+}
+
+static void deleteLoad(State* state, ModelLoad* load) {
+	if (load->upload)
+		discardUpload(state, load->upload);
+	delete load;
+}
+
+void modelLoaderDestroy(State* state) {
+	ModelLoader* loader = state->loader;
+	{
+		std::unique_lock<std::mutex> lock(loader->mutex);
+		loader->idle.wait(lock, [loader] { return loader->decoding == 0; });
+	}
+
+	for (ModelLoad* load : loader->loads)
+		deleteLoad(state, load);
+	for (ModelLoad* reload : loader->reloads)
+		deleteLoad(state, reload);
+	for (RetiredModel& retired : loader->retired)
+		destroyRetired(state, retired);
+	for (VkDescriptorPool pool : loader->materialPools)
+		vkDestroyDescriptorPool(state->context->device, pool, nullptr);
+	fileWatcherDestroy(loader->watcher);
+
+	delete loader;
+	state->loader = nullptr;
+}
+
+static void startDecode(State* state, ModelLoad* load) {
+	ModelLoader* loader = state->loader;
+	{
+		std::lock_guard<std::mutex> lock(loader->mutex);
+		loader->decoding++;
+	}
+	jobSubmit(state->jobs, [state, loader, load] {
+		load->status = ModelLoadStatus::Decoding;
+		try {
+			decodeModel(state, load);
+			load->status = ModelLoadStatus::Decoded;
+		}
+		catch (const std::exception& e) {
+			// Whatever was created stays on load->upload; the next poll
+			// discards it on the main thread, which owns the scene's
+			// texture cache and streaming state
+			load->error = e.what();
+			printf("loadModelAsync: %s failed: %s\n", load->path.c_str(), e.what());
+			load->status = ModelLoadStatus::Failed;
+		}
+
+		std::lock_guard<std::mutex> lock(loader->mutex);
+		if (--loader->decoding == 0)
+			loader->idle.notify_all();
+	});
+}
+
+ModelLoad* loadModelAsync(State* state, const std::string& path, const glm::mat4& transform, const ModelLoad* after) {
+	ModelLoad* load = new ModelLoad{};
+	load->path = path;
+	load->transform = transform;
+	load->after = after;
+	state->loader->loads.push_back(load);
+	startDecode(state, load);
+	return load;
+}
+
+static void queueReload(State* state, ModelLoad* load) {
+	ModelLoad* reload = new ModelLoad{};
+	reload->path = load->path;
+	reload->transform = load->transform;
+	reload->replaces = load;
+	for (const Mesh* mesh : load->meshes)
+		reload->residentMeshes.push_back(mesh->contentHash);
+
+	load->reload = reload;
+	state->loader->reloads.push_back(reload);
+	printf("modelLoaderPoll: reloading %s\n", load->path.c_str());
+	startDecode(state, reload);
+}
+
+// Acquire half of up's ownership transfer, for the graphics queue
+static void recordAcquire(State* state, ModelUpload* up) {
+	VkCommandBufferAllocateInfo allocInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		.commandPool = state->renderer->commandPool,
+		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		.commandBufferCount = 1,
+	};
+	PANIC(vkAllocateCommandBuffers(state->context->device, &allocInfo, &up->acquireCmd), "Failed To Allocate Acquire Command Buffer");
+
+	VkCommandBufferBeginInfo beginInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+	};
+	vkBeginCommandBuffer(up->acquireCmd, &beginInfo);
+
+	std::vector<VkBufferMemoryBarrier> bufferAcquire = up->bufferBarriers;
+	std::vector<VkImageMemoryBarrier> imageAcquire = up->imageBarriers;
+	for (VkBufferMemoryBarrier& b : bufferAcquire) b.srcAccessMask = 0;
+	for (VkImageMemoryBarrier& b : imageAcquire) b.srcAccessMask = 0;
+
+	VkPipelineStageFlags useStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	if (!bufferAcquire.empty() || !imageAcquire.empty())
+		vkCmdPipelineBarrier(up->acquireCmd, useStages, useStages, 0, 0, nullptr,
+			(uint32_t)bufferAcquire.size(), bufferAcquire.data(),
+			(uint32_t)imageAcquire.size(), imageAcquire.data());
+	PANIC(vkEndCommandBuffer(up->acquireCmd), "Failed To Record Acquire Command Buffer");
+}
+
+// One submission for every upload decoded since the last poll, rather than
+// one per model; a scene's worth of loads costs a single queue submit (two
+// with an ownership transfer) and a single fence
+static void submitUploads(State* state, const std::vector<ModelUpload*>& uploads) {
+	VkDevice device = state->context->device;
+
+	UploadBatch* batch = new UploadBatch{ .uploads = (uint32_t)uploads.size() };
+	VkFenceCreateInfo fenceInfo{ .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	PANIC(vkCreateFence(device, &fenceInfo, nullptr, &batch->fence), "Failed To Create Upload Fence");
+
+	std::vector<VkCommandBuffer> transferCmds;
+	for (ModelUpload* up : uploads) {
+		up->batch = batch;
+		transferCmds.push_back(up->transferCmd);
+	}
+
+	if (!ownershipTransfer(state)) {
+		VkSubmitInfo submitInfo{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.commandBufferCount = (uint32_t)transferCmds.size(),
+			.pCommandBuffers = transferCmds.data(),
+		};
+		PANIC(vkQueueSubmit(state->context->transferQueue, 1, &submitInfo, batch->fence), "Failed To Submit Upload");
+		return;
+	}
+
+	VkSemaphoreCreateInfo semaphoreInfo{ .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+	PANIC(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &batch->transferDone), "Failed To Create Upload Semaphore");
+
+	VkSubmitInfo transferSubmit{
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.commandBufferCount = (uint32_t)transferCmds.size(),
+		.pCommandBuffers = transferCmds.data(),
+		.signalSemaphoreCount = 1,
+		.pSignalSemaphores = &batch->transferDone,
+	};
+	PANIC(vkQueueSubmit(state->context->transferQueue, 1, &transferSubmit, VK_NULL_HANDLE), "Failed To Submit Upload");
+
+	// Acquire on the graphics queue, ordered after the transfer by the semaphore
+	std::vector<VkCommandBuffer> acquireCmds;
+	for (ModelUpload* up : uploads) {
+		recordAcquire(state, up);
+		acquireCmds.push_back(up->acquireCmd);
+	}
+
+	VkPipelineStageFlags useStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	VkSubmitInfo acquireSubmit{
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.waitSemaphoreCount = 1,
+		.pWaitSemaphores = &batch->transferDone,
+		.pWaitDstStageMask = &useStages,
+		.commandBufferCount = (uint32_t)acquireCmds.size(),
+		.pCommandBuffers = acquireCmds.data(),
+	};
+	PANIC(vkQueueSubmit(state->context->queue, 1, &acquireSubmit, batch->fence), "Failed To Submit Acquire");
+}
+
+// The init-time material pool is sized for the init-time scene, so each
+// publish brings one for the materials new to the scene
+static void writeMaterials(State* state, const std::vector<Material*>& materials) {
+	if (materials.empty())
+		return;
+
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	materialDescriptorPoolCreateFor(state, (uint32_t)materials.size(), pool);
+	state->loader->materialPools.push_back(pool);
+	for (Material* mat : materials) {
+		VkDescriptorSetAllocateInfo allocInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.descriptorPool = pool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &state->renderer->materialSetLayout
+		};
+		PANIC(vkAllocateDescriptorSets(state->context->device, &allocInfo, &mat->descriptorSet), "Failed to allocate material descriptor set");
+		materialSetWrite(state, mat);
+	}
+}
+
+static Model* createModel(ModelLoad* load, ModelUpload* up) {
+	Model* model = new Model{};
+	model->name = load->path;
+	model->transform = load->transform;
+	model->rootNode = up->pak.rootNode;
+	modelTransformsInit(model);
+	model->instances = std::move(up->instances);
+	model->animations = std::move(up->pak.animations);
+	model->skins = std::move(up->pak.skins);
+	model->instanceBuffer = up->instanceBuffer;
+	model->instanceMemory = up->instanceMemory;
+	return model;
+}
+
+// Gives the model its scene textures and materials. A texture another load
+// added since the worker checked replaces the copy just uploaded.
+static void publishMaterials(State* state, ModelUpload* up, Model* model) {
+	for (size_t i = 0; i < up->textures.size(); i++) {
+		if (up->textureIndices[i] >= 0) {
+			model->textureIndices.push_back((uint32_t)up->textureIndices[i]);
+			continue;
+		}
+		Texture* tex = up->textures[i];
+		uint64_t key = textureCacheKey(tex->contentHash, tex->role);
+		int cached = sceneAcquireTexture(state->scene, key);
+		if (cached >= 0) {
+			destroyTextureImage(state, tex);
+			delete tex;
+			model->textureIndices.push_back((uint32_t)cached);
+		}
+		else {
+			model->textureIndices.push_back(sceneAddTexture(state->scene, tex, key));
+			if (tex->stream)
+				textureStreamTrack(state, tex);
+		}
+	}
+	up->textures.clear();
+	up->textureIndices.clear();
+
+	writeMaterials(state, runepakInternMaterials(state, up->pak, model));
+}
+
+// Records what the model was built from and watches those files
+static void adoptModel(State* state, ModelLoad* load, ModelUpload* up, Model* model) {
+	load->model = model;
+	load->meshes = up->pak.meshes;
+
+	load->watchedPaths.assign(1, load->path);
+	load->watchedPaths.insert(load->watchedPaths.end(), up->pak.dependencies.begin(), up->pak.dependencies.end());
+	for (const std::string& path : load->watchedPaths)
+		fileWatcherAdd(state->loader->watcher, path);
+}
+
+static void publishModel(State* state, ModelLoad* load) {
+	Scene* scene = state->scene;
+	ModelUpload* up = load->upload;
+
+	Model* model = createModel(load, up);
+	publishMaterials(state, up, model);
+	skinningCreate(state, model);
+
+	scene->models.push_back(model);
+	adoptModel(state, load, up, model);
+
+	releaseUploadObjects(state, up);
+	delete up;
+	load->upload = nullptr;
+}
+
+// Swaps a reload's model in for the one its load published. Resident
+// meshes take over the old GPU buffers and unchanged textures are shared
+// through the scene cache; the old version is retired until in-flight
+// frames are done with it.
+static void replaceModel(State* state, ModelLoad* reload) {
+	Scene* scene = state->scene;
+	ModelUpload* up = reload->upload;
+	ModelLoad* load = reload->replaces;
+	Model* old = load->model;
+
+	std::unordered_multimap<uint64_t, Mesh*> oldMeshes;
+	for (Mesh* mesh : load->meshes)
+		oldMeshes.emplace(mesh->contentHash, mesh);
+	for (size_t i = 0; i < up->pak.meshes.size(); i++) {
+		if (!up->meshResident[i])
+			continue;
+		auto match = oldMeshes.find(up->pak.meshes[i]->contentHash);
+		Mesh* from = match->second;
+		Mesh* to = up->pak.meshes[i];
+		oldMeshes.erase(match);
+		std::swap(to->vertexBuffer, from->vertexBuffer);
+		std::swap(to->vertexMemory, from->vertexMemory);
+		std::swap(to->indexBuffer, from->indexBuffer);
+		std::swap(to->indexMemory, from->indexMemory);
+		std::swap(to->skinBuffer, from->skinBuffer);
+		std::swap(to->skinMemory, from->skinMemory);
+		std::swap(to->morphBuffer, from->morphBuffer);
+		std::swap(to->morphMemory, from->morphMemory);
+	}
+
+	Model* model = createModel(reload, up);
+	model->transform = old->transform;
+	if (old->activeAnimation < (int32_t)model->animations.size())
+		model->activeAnimation = old->activeAnimation;
+	publishMaterials(state, up, model);
+
+	skinningCreate(state, model);
+	*std::find(scene->models.begin(), scene->models.end(), old) = model;
+
+	state->loader->retired.push_back(RetiredModel{
+		.model = old,
+		.polls = state->config->swapchainBuffering + 1,
+	});
+	adoptModel(state, load, up, model);
+
+	releaseUploadObjects(state, up);
+	delete up;
+	reload->upload = nullptr;
+}
+
+static bool loadSettled(const ModelLoad* load) {
+	ModelLoadStatus status = load->status;
+	return status == ModelLoadStatus::Ready || status == ModelLoadStatus::Failed;
+}
+
+// Uploading, and not held back behind another load
+static bool loadPublishable(const ModelLoad* load) {
+	return load->status == ModelLoadStatus::Uploading && (!load->after || loadSettled(load->after));
+}
+
+static void collectDecoded(ModelLoad* load, std::vector<ModelUpload*>& uploads) {
+	if (load->status != ModelLoadStatus::Decoded)
+		return;
+	uploads.push_back(load->upload);
+	load->status = ModelLoadStatus::Uploading;
+}
+
+// A worker that failed leaves its partial upload for the main thread
+static void discardFailed(State* state, ModelLoad* load) {
+	if (load->status != ModelLoadStatus::Failed || !load->upload)
+		return;
+	discardUpload(state, load->upload);
+	load->upload = nullptr;
+}
+
+static void advanceLoad(State* state, ModelLoad* load) {
+	if (!loadPublishable(load) ||
+		vkGetFenceStatus(state->context->device, load->upload->batch->fence) != VK_SUCCESS)
+		return;
+	if (load->replaces)
+		replaceModel(state, load);
+	else
+		publishModel(state, load);
+	load->status = ModelLoadStatus::Ready;
+}
+
+void modelLoaderPoll(State* state) {
+	ModelLoader* loader = state->loader;
+
+	std::vector<ModelUpload*> decoded;
+	for (ModelLoad* load : loader->loads) {
+		discardFailed(state, load);
+		collectDecoded(load, decoded);
+	}
+	for (ModelLoad* reload : loader->reloads) {
+		discardFailed(state, reload);
+		collectDecoded(reload, decoded);
+	}
+	if (!decoded.empty())
+		submitUploads(state, decoded);
+
+	// In order, so a load waiting on an earlier one publishes in the same poll
+	for (ModelLoad* load : loader->loads)
+		advanceLoad(state, load);
+
+	// Finished reloads hand back to their load; a failed one leaves the
+	// previous version in place
+	for (size_t i = 0; i < loader->reloads.size(); ) {
+		ModelLoad* reload = loader->reloads[i];
+		advanceLoad(state, reload);
+		ModelLoadStatus status = reload->status;
+		if (status != ModelLoadStatus::Ready && status != ModelLoadStatus::Failed) {
+			i++;
+			continue;
+		}
+
+		ModelLoad* load = reload->replaces;
+		loader->reloads.erase(loader->reloads.begin() + i);
+		delete reload;
+		load->reload = nullptr;
+		if (load->reloadPending) {
+			load->reloadPending = false;
+			queueReload(state, load);
+		}
+	}
+
+	// Editors write several files, and the same file several times, per
+	// save; each affected model is queued once, and again after it lands
+	std::vector<ModelLoad*> changed;
+	for (const std::string& path : fileWatcherPoll(loader->watcher)) {
+		for (ModelLoad* load : loader->loads) {
+			if (load->status == ModelLoadStatus::Ready &&
+				std::find(load->watchedPaths.begin(), load->watchedPaths.end(), path) != load->watchedPaths.end() &&
+				std::find(changed.begin(), changed.end(), load) == changed.end())
+				changed.push_back(load);
+		}
+	}
+	for (ModelLoad* load : changed) {
+		if (load->reload)
+			load->reloadPending = true;
+		else
+			queueReload(state, load);
+	}
+
+	for (size_t i = 0; i < loader->retired.size(); ) {
+		if (--loader->retired[i].polls > 0) {
+			i++;
+			continue;
+		}
+		destroyRetired(state, loader->retired[i]);
+		loader->retired.erase(loader->retired.begin() + i);
+	}
+}
+
+void modelLoaderFinish(State* state) {
+	ModelLoader* loader = state->loader;
+	for (;;) {
+		modelLoaderPoll(state);
+
+		bool pending = false;
+		std::vector<VkFence> fences;
+		for (ModelLoad* load : loader->loads) {
+			if (loadSettled(load))
+				continue;
+			pending = true;
+			VkFence fence = loadPublishable(load) ? load->upload->batch->fence : VK_NULL_HANDLE;
+			if (fence && std::find(fences.begin(), fences.end(), fence) == fences.end())
+				fences.push_back(fence);
+		}
+		if (!pending)
+			return;
+
+		// Wake for the first upload to land, or shortly to pick up decodes
+		if (!fences.empty())
+			vkWaitForFences(state->context->device, (uint32_t)fences.size(), fences.data(), VK_FALSE, 1'000'000);
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
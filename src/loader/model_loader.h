@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <vulkan/vulkan.h>
+#include "core/math.h"
+#include "core/file_watch.h"
+
+struct State;
+struct Model;
+struct Mesh;
+struct ModelUpload;
+
+enum class ModelLoadStatus : uint32_t {
+	Queued,     // waiting for a worker
+	Decoding,   // hash / cook / map and staging copy on a worker
+	Decoded,    // transfer commands recorded, waiting for the next poll
+	Uploading,  // submitted on the transfer queue
+	Ready,      // resident and published in Scene::models
+	Failed,
+};
+
+// Handle returned by loadModelAsync. Owned by the loader and valid until
+// modelLoaderDestroy; model and error are only meaningful once status says so.
+struct ModelLoad {
+	std::string path;
+	glm::mat4 transform = glm::mat4(1.0f);
+	std::atomic<ModelLoadStatus> status{ ModelLoadStatus::Queued };
+	Model* model = nullptr;
+	std::string error;
+	const ModelLoad* after = nullptr;   // published only once this one is Ready or Failed
+
+	ModelUpload* upload = nullptr;      // until published, or discarded by the poll after a failure
+
+	// What the published model was built from; a hot reload keeps the
+	// meshes whose content hash did not change. Textures and materials are
+	// shared through the scene cache instead.
+	std::vector<std::string> watchedPaths;  // source, then .bin and image files
+	std::vector<Mesh*> meshes;              // package order
+
+	ModelLoad* reload = nullptr;        // in flight for this load
+	bool reloadPending = false;         // a file changed again meanwhile
+
+	// Reloads only: the load whose model is swapped out, and the mesh
+	// content hashes it already has on the GPU (copied so workers never
+	// touch it)
+	ModelLoad* replaces = nullptr;
+	std::vector<uint64_t> residentMeshes;
+};
+
+// A replaced model, kept until the frames that may still draw it retire
+struct RetiredModel {
+	Model* model = nullptr;
+	uint32_t polls = 0;  // left before destruction
+};
+
+struct ModelLoader {
+	std::vector<ModelLoad*> loads;
+	std::vector<ModelLoad*> reloads;  // internal, never handed out
+	std::vector<RetiredModel> retired;
+	// One per publish. Sets of materials a reload drops are not freed
+	// individually; the pools go at modelLoaderDestroy.
+	std::vector<VkDescriptorPool> materialPools;
+	FileWatcher watcher;
+
+	std::mutex mutex;
+	std::condition_variable idle;
+	uint32_t decoding = 0;
+};
+
+void modelLoaderCreate(State* state);
+// Waits for in-flight decodes; call after vkDeviceWaitIdle and before
+// modelUnload so published models are still owned by the scene.
+void modelLoaderDestroy(State* state);
+
+// Returns immediately. Decoding (through the .runepak cache) runs on the job
+// system and the upload on the transfer queue; the model is added to
+// Scene::models with the given transform by the poll that sees it resident,
+// and not before after has been, when given.
+ModelLoad* loadModelAsync(State* state, const std::string& path, const glm::mat4& transform = glm::mat4(1.0f),
+	const ModelLoad* after = nullptr);
+
+// Frame-boundary step on the main thread: submits every upload recorded
+// since the last poll in one batch and publishes finished ones. Never blocks
+// on the GPU. Ready models whose source, buffers or images change on disk
+// are reloaded in the background and swapped in place; the old version is
+// freed once no frame uses it.
+void modelLoaderPoll(State* state);
+
+// Polls until every load is Ready or Failed; for scene loads before the
+// first frame.
+void modelLoaderFinish(State* state);
@@ -0,0 +1,919 @@
+#include "loader/runepak.h"
+#include "loader/gltf_loader.h"
+#include "loader/gltf_animations.h"
+#include "loader/gltf_materials.h"
+#include "loader/gltf_meshes.h"
+#include "loader/gltf_nodes.h"
+#include "loader/gltf_textures.h"
+#include "render/skinning.h"
+#include "render/texture_streaming.h"
+#include "resources/buffers.h"
+#include "resources/mipmaps.h"
+#include "resources/staging_arena.h"
+#include "resources/vertex_pack.h"
+#include "scene/materials.h"
+#include "scene/model.h"
+#include "scene/scene.h"
+#include "scene/transforms.h"
+#include "core/config.h"
+#include "core/context.h"
+#include "core/file_map.h"
+#include "core/hash.h"
+#include "core/jobs.h"
+#include "core/state.h"
+#include "tiny_gltf.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+
+static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex is written to runepak as raw bytes");
+static_assert(std::is_trivially_copyable_v<RunePakMaterial>, "RunePakMaterial is written as raw bytes");
+
+static const char RUNEPAK_MAGIC[8] = { 'R', 'U', 'N', 'E', 'P', 'A', 'K', '\0' };
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::string runepakPath(const std::string& sourcePath) {
+	return std::filesystem::path(sourcePath).replace_extension(".runepak").string();
+}
+
+// ─────────────────────────────────────────────
+// Material records
+// ─────────────────────────────────────────────
+static int32_t toLocal(int index, uint32_t base) {
+	return index >= 0 ? index - (int)base : -1;
+}
+
+static int toGlobal(int32_t index, uint32_t base) {
+	return index >= 0 ? (int)base + index : -1;
+}
+
+static RunePakMaterial packMaterial(const Material& mat) {
+	RunePakMaterial r{};
+	r.baseColorTexture = toLocal(mat.baseColorTextureIndex, 0);
+	r.metallicRoughnessTexture = toLocal(mat.metallicRoughnessTextureIndex, 0);
+	r.normalTexture = toLocal(mat.normalTextureIndex, 0);
+	r.occlusionTexture = toLocal(mat.occlusionTextureIndex, 0);
+	r.emissiveTexture = toLocal(mat.emissiveTextureIndex, 0);
+	r.transmissionTexture = toLocal(mat.transmissionTextureIndex, 0);
+	r.thicknessTexture = toLocal(mat.thicknessTextureIndex, 0);
+
+	r.baseColorTexCoord = mat.baseColorTexCoordIndex;
+	r.metallicRoughnessTexCoord = mat.metallicRoughnessTexCoordIndex;
+	r.normalTexCoord = mat.normalTexCoordIndex;
+	r.occlusionTexCoord = mat.occlusionTexCoordIndex;
+	r.emissiveTexCoord = mat.emissiveTexCoordIndex;
+	r.transmissionTexCoord = mat.transmissionTexCoordIndex;
+	r.thicknessTexCoord = mat.thicknessTexCoordIndex;
+
+	r.baseColorTransform = mat.baseColorTransform;
+	r.metallicRoughnessTransform = mat.metallicRoughnessTransform;
+	r.normalTransform = mat.normalTransform;
+	r.occlusionTransform = mat.occlusionTransform;
+	r.emissiveTransform = mat.emissiveTransform;
+	r.transmissionTransform = mat.transmissionTransform;
+
+	r.baseColorFactor = mat.baseColorFactor;
+	r.attenuationColor = mat.attenuationColor;
+	r.emissiveFactor = mat.emissiveFactor;
+	r.metallicFactor = mat.metallicFactor;
+	r.roughnessFactor = mat.roughnessFactor;
+	r.transmissionFactor = mat.transmissionFactor;
+	r.thicknessFactor = mat.thicknessFactor;
+	r.attenuationDistance = mat.attenuationDistance;
+	r.ior = mat.ior;
+	r.alphaCutoff = mat.alphaCutoff;
+	r.alphaMode = mat.alphaMode == "MASK" ? 1 : mat.alphaMode == "BLEND" ? 2 : 0;
+	r.doubleSided = mat.doubleSided ? 1 : 0;
+	return r;
+}
+
+static void unpackMaterial(const RunePakMaterial& r, uint32_t baseTextureIndex, Material& mat) {
+	mat.baseColorTextureIndex = toGlobal(r.baseColorTexture, baseTextureIndex);
+	mat.metallicRoughnessTextureIndex = toGlobal(r.metallicRoughnessTexture, baseTextureIndex);
+	mat.normalTextureIndex = toGlobal(r.normalTexture, baseTextureIndex);
+	mat.occlusionTextureIndex = toGlobal(r.occlusionTexture, baseTextureIndex);
+	mat.emissiveTextureIndex = toGlobal(r.emissiveTexture, baseTextureIndex);
+	mat.transmissionTextureIndex = toGlobal(r.transmissionTexture, baseTextureIndex);
+	mat.thicknessTextureIndex = toGlobal(r.thicknessTexture, baseTextureIndex);
+
+	mat.baseColorTexCoordIndex = r.baseColorTexCoord;
+	mat.metallicRoughnessTexCoordIndex = r.metallicRoughnessTexCoord;
+	mat.normalTexCoordIndex = r.normalTexCoord;
+	mat.occlusionTexCoordIndex = r.occlusionTexCoord;
+	mat.emissiveTexCoordIndex = r.emissiveTexCoord;
+	mat.transmissionTexCoordIndex = r.transmissionTexCoord;
+	mat.thicknessTexCoordIndex = r.thicknessTexCoord;
+
+	mat.baseColorTransform = r.baseColorTransform;
+	mat.metallicRoughnessTransform = r.metallicRoughnessTransform;
+	mat.normalTransform = r.normalTransform;
+	mat.occlusionTransform = r.occlusionTransform;
+	mat.emissiveTransform = r.emissiveTransform;
+	mat.transmissionTransform = r.transmissionTransform;
+
+	mat.baseColorFactor = r.baseColorFactor;
+	mat.attenuationColor = r.attenuationColor;
+	mat.emissiveFactor = r.emissiveFactor;
+	mat.metallicFactor = r.metallicFactor;
+	mat.roughnessFactor = r.roughnessFactor;
+	mat.transmissionFactor = r.transmissionFactor;
+	mat.thicknessFactor = r.thicknessFactor;
+	mat.attenuationDistance = r.attenuationDistance;
+	mat.ior = r.ior;
+	mat.alphaCutoff = r.alphaCutoff;
+	mat.alphaMode = r.alphaMode == 1 ? "MASK" : r.alphaMode == 2 ? "BLEND" : "OPAQUE";
+	mat.doubleSided = r.doubleSided != 0;
+}
+
+// ─────────────────────────────────────────────
+// Cook
+// ─────────────────────────────────────────────
+static void flattenNodes(Node* node, int32_t parent, std::vector<Node*>& nodes, std::vector<int32_t>& parents) {
+	int32_t index = (int32_t)nodes.size();
+	nodes.push_back(node);
+	parents.push_back(parent);
+	for (Node* child : node->children)
+		flattenNodes(child, index, nodes, parents);
+}
+
+static bool writePadding(std::ofstream& out, uint64_t target) {
+	static const char zeros[RUNEPAK_ALIGNMENT] = {};
+	uint64_t position = (uint64_t)out.tellp();
+	while (position < target) {
+		uint64_t n = std::min<uint64_t>(target - position, sizeof(zeros));
+		out.write(zeros, (std::streamsize)n);
+		position += n;
+	}
+	return (bool)out;
+}
+
+bool runepakCook(State* state, const std::string& sourcePath, const std::string& pakPath, uint64_t sourceHash)
+{
+	GltfSource source;
+	tinygltf::Model gltf = loadGltf(sourcePath, source, state->jobs);
+
+	// Parse with base indices 0 so every stored index is model-local.
+	Model model{};
+	model.rootNode = new Node();
+	model.rootNode->name = "Root";
+
+	std::unordered_map<int, TextureRole> textureRoles;
+	std::vector<Material> materials(gltf.materials.size());
+	for (size_t i = 0; i < gltf.materials.size(); i++)
+		fillMaterialFromGltf(gltf.materials[i], materials[i], 0, textureRoles);
+
+	parseSceneNodes(state, gltf, source.buffers, &model, extractBaseDir(sourcePath));
+	parseAnimations(gltf, source.buffers, &model);
+	parseSkins(gltf, source.buffers, &model);
+
+	std::vector<Node*> nodes;
+	std::vector<int32_t> parents;
+	flattenNodes(model.rootNode, -1, nodes, parents);
+
+	// Textures, one per gltf.textures entry: RGBA8 with the full mip chain
+	// built on the CPU, or transcoded from KTX2 for this device
+	std::vector<TextureLevels> textures(gltf.textures.size());
+	std::vector<TextureRole> roles(gltf.textures.size());
+
+	// Decode and mip each texture independently; the encoded bytes are read
+	// from the mapping
+	parallelFor(state->jobs, gltf.textures.size(), [&](size_t i) {
+		auto role = textureRoles.find((int)i);
+		roles[i] = role != textureRoles.end() ? role->second : TextureRole::BaseColor;
+
+		int image = gltfTextureImage(gltf, (int)i);
+		if (image < 0 || image >= (int)source.images.size())
+			throw std::runtime_error("runepakCook: texture " + std::to_string(i) + " has no image");
+		decodeTextureLevels(state, source.images[image], roles[i], textures[i]);
+	});
+
+	// External files, hashed while still mapped
+	std::vector<std::string> dependencyPaths(source.paths.begin() + std::min<size_t>(1, source.paths.size()), source.paths.end());
+	std::vector<uint64_t> dependencyHashes;
+	for (size_t i = 1; i < source.files.size(); i++)
+		dependencyHashes.push_back(hashBytes(source.files[i].data, source.files[i].size));
+	gltfSourceClose(source);
+
+	// ─────────────────────────────────────────────
+	// Layout: header, tables, names, then page-aligned blobs
+	// ─────────────────────────────────────────────
+	std::vector<RunePakNode> nodeRecords(nodes.size());
+	std::vector<RunePakMesh> meshRecords;
+	std::vector<const Mesh*> meshes;
+	std::unordered_map<const Mesh*, uint32_t> meshIndices;
+	std::vector<uint32_t> meshRefs;
+	std::vector<float> morphWeights;
+	std::string names;
+
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const Node* node = nodes[i];
+		RunePakNode& r = nodeRecords[i];
+		r.parent = parents[i];
+		r.firstMesh = (uint32_t)meshRefs.size();
+		r.meshCount = (uint32_t)node->meshes.size();
+		r.firstInstance = node->firstInstance;
+		r.instanceCount = node->instanceCount;
+		r.skin = node->skin;
+		r.firstMorphWeight = (uint32_t)morphWeights.size();
+		r.morphWeightCount = (uint32_t)node->morphWeights.size();
+		morphWeights.insert(morphWeights.end(), node->morphWeights.begin(), node->morphWeights.end());
+		r.nameOffset = (uint32_t)names.size();
+		r.nameLength = (uint32_t)node->name.size();
+		names += node->name;
+
+		memcpy(r.matrix, glm::value_ptr(node->matrix), sizeof(r.matrix));
+		memcpy(r.translation, glm::value_ptr(node->translation), sizeof(r.translation));
+		r.rotation[0] = node->rotation.x;
+		r.rotation[1] = node->rotation.y;
+		r.rotation[2] = node->rotation.z;
+		r.rotation[3] = node->rotation.w;
+		memcpy(r.scale, glm::value_ptr(node->scale), sizeof(r.scale));
+
+		// Each shared mesh is stored once
+		for (const Mesh* mesh : node->meshes) {
+			auto [it, inserted] = meshIndices.try_emplace(mesh, (uint32_t)meshes.size());
+			if (inserted)
+				meshes.push_back(mesh);
+			meshRefs.push_back(it->second);
+		}
+	}
+
+	// Animations, tracks re-pointed at pre-order node indices
+	std::unordered_map<const Node*, uint32_t> nodeIndices;
+	for (size_t i = 0; i < nodes.size(); i++)
+		nodeIndices[nodes[i]] = (uint32_t)i;
+
+	std::vector<RunePakAnimation> animationRecords(model.animations.size());
+	std::vector<RunePakTrack> trackRecords;
+	std::vector<uint16_t> keys;
+	std::vector<uint16_t> keyValues;
+	for (size_t i = 0; i < model.animations.size(); i++) {
+		const Animation& animation = model.animations[i];
+		RunePakAnimation& r = animationRecords[i];
+		r.nameOffset = (uint32_t)names.size();
+		r.nameLength = (uint32_t)animation.name.size();
+		names += animation.name;
+		r.firstTrack = (uint32_t)trackRecords.size();
+		r.trackCount = (uint32_t)animation.tracks.size();
+		r.firstKey = (uint32_t)keys.size();
+		r.keyCount = (uint32_t)animation.times.size();
+		r.firstValue = (uint32_t)keyValues.size();
+		r.valueCount = (uint32_t)animation.values.size();
+		r.start = animation.start;
+		r.end = animation.end;
+
+		for (const AnimationTrack& track : animation.tracks) {
+			trackRecords.push_back(RunePakTrack{
+				.node = nodeIndices.at(track.node),
+				.path = (uint32_t)track.path,
+				.interpolation = (uint32_t)track.interpolation,
+				.firstKey = track.firstKey,
+				.keyCount = track.keyCount,
+				.firstValue = track.firstValue,
+				.firstWeight = track.firstWeight,
+				.rangeMin = track.rangeMin,
+				.rangeExtent = track.rangeExtent,
+			});
+		}
+		keys.insert(keys.end(), animation.times.begin(), animation.times.end());
+		keyValues.insert(keyValues.end(), animation.values.begin(), animation.values.end());
+	}
+
+	// Skins, joints as pre-order node indices
+	std::vector<RunePakSkin> skinRecords(model.skins.size());
+	std::vector<int32_t> joints;
+	std::vector<glm::mat4> inverseBinds;
+	for (size_t i = 0; i < model.skins.size(); i++) {
+		const Skin& skin = model.skins[i];
+		RunePakSkin& r = skinRecords[i];
+		r.nameOffset = (uint32_t)names.size();
+		r.nameLength = (uint32_t)skin.name.size();
+		names += skin.name;
+		r.firstJoint = (uint32_t)joints.size();
+		r.jointCount = (uint32_t)skin.joints.size();
+		for (const Node* joint : skin.joints)
+			joints.push_back(joint ? (int32_t)nodeIndices.at(joint) : -1);
+		inverseBinds.insert(inverseBinds.end(), skin.inverseBindMatrices.begin(), skin.inverseBindMatrices.end());
+	}
+
+	std::vector<RunePakDependency> dependencies(dependencyPaths.size());
+	for (size_t i = 0; i < dependencies.size(); i++) {
+		dependencies[i] = { (uint32_t)names.size(), (uint32_t)dependencyPaths[i].size(), dependencyHashes[i] };
+		names += dependencyPaths[i];
+	}
+
+	RunePakHeader header{};
+	memcpy(header.magic, RUNEPAK_MAGIC, sizeof(header.magic));
+	header.version = RUNEPAK_VERSION;
+	VertexLayout vertexLayout = state->config->vertexLayout;
+	header.vertexSize = vertexStride(vertexLayout);
+	header.materialSize = sizeof(RunePakMaterial);
+	header.nodeSize = sizeof(RunePakNode);
+	header.features = runepakFeatures(state);
+	header.sourceHash = sourceHash;
+	header.nodeCount = (uint32_t)nodeRecords.size();
+	header.meshCount = (uint32_t)meshes.size();
+	header.materialCount = (uint32_t)materials.size();
+	header.textureCount = (uint32_t)textures.size();
+	header.meshRefCount = (uint32_t)meshRefs.size();
+	header.instanceCount = (uint32_t)model.instances.size();
+	header.animationCount = (uint32_t)animationRecords.size();
+	header.trackCount = (uint32_t)trackRecords.size();
+	header.keyCount = (uint32_t)keys.size();
+	header.keyValueCount = (uint32_t)keyValues.size();
+	header.skinCount = (uint32_t)skinRecords.size();
+	header.jointCount = (uint32_t)joints.size();
+	header.morphWeightCount = (uint32_t)morphWeights.size();
+	header.dependencyCount = (uint32_t)dependencies.size();
+
+	uint64_t offset = sizeof(RunePakHeader);
+	header.nodeOffset = offset = alignUp(offset, 16);
+	offset += nodeRecords.size() * sizeof(RunePakNode);
+	header.meshOffset = offset = alignUp(offset, 16);
+	offset += meshes.size() * sizeof(RunePakMesh);
+	header.meshRefOffset = offset = alignUp(offset, 16);
+	offset += meshRefs.size() * sizeof(uint32_t);
+	header.instanceOffset = offset = alignUp(offset, 16);
+	offset += model.instances.size() * sizeof(glm::mat4);
+	header.animationOffset = offset = alignUp(offset, 16);
+	offset += animationRecords.size() * sizeof(RunePakAnimation);
+	header.trackOffset = offset = alignUp(offset, 16);
+	offset += trackRecords.size() * sizeof(RunePakTrack);
+	header.keyOffset = offset = alignUp(offset, 16);
+	offset += keys.size() * sizeof(uint16_t);
+	header.keyValueOffset = offset = alignUp(offset, 16);
+	offset += keyValues.size() * sizeof(uint16_t);
+	header.skinOffset = offset = alignUp(offset, 16);
+	offset += skinRecords.size() * sizeof(RunePakSkin);
+	header.jointOffset = offset = alignUp(offset, 16);
+	offset += joints.size() * sizeof(int32_t);
+	header.inverseBindOffset = offset = alignUp(offset, 16);
+	offset += inverseBinds.size() * sizeof(glm::mat4);
+	header.morphWeightOffset = offset = alignUp(offset, 16);
+	offset += morphWeights.size() * sizeof(float);
+	header.dependencyOffset = offset = alignUp(offset, 16);
+	offset += dependencies.size() * sizeof(RunePakDependency);
+	header.materialOffset = offset = alignUp(offset, 16);
+	offset += materials.size() * sizeof(RunePakMaterial);
+	header.textureOffset = offset = alignUp(offset, 16);
+	offset += textures.size() * sizeof(RunePakTexture);
+	header.stringOffset = offset;
+	header.stringSize = names.size();
+	offset += names.size();
+
+	meshRecords.resize(meshes.size());
+	std::vector<std::vector<unsigned char>> vertexBlobs(meshes.size());
+	std::vector<std::vector<unsigned char>> indexBlobs(meshes.size());
+	std::vector<std::vector<unsigned char>> morphBlobs(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++) {
+		const Mesh* mesh = meshes[i];
+		RunePakMesh& r = meshRecords[i];
+		r.vertexCount = (uint32_t)mesh->vertices.size();
+		r.indexCount = (uint32_t)mesh->indices.size();
+		r.materialIndex = mesh->materialIndex;
+		memcpy(r.minBounds, glm::value_ptr(mesh->minBounds), sizeof(r.minBounds));
+		memcpy(r.maxBounds, glm::value_ptr(mesh->maxBounds), sizeof(r.maxBounds));
+		memcpy(r.center, glm::value_ptr(mesh->center), sizeof(r.center));
+
+		vertexBlobs[i] = packVertices(vertexLayout, mesh->vertices, mesh->minBounds, mesh->maxBounds);
+		indexBlobs[i] = packIndices(mesh->indices, meshIndexType(r.vertexCount));
+
+		r.vertexOffset = offset = alignUp(offset, RUNEPAK_ALIGNMENT);
+		offset += vertexBlobs[i].size();
+		r.indexOffset = offset = alignUp(offset, RUNEPAK_ALIGNMENT);
+		offset += indexBlobs[i].size();
+		if (mesh->skinned) {
+			r.skinOffset = offset = alignUp(offset, RUNEPAK_ALIGNMENT);
+			offset += mesh->skinVertices.size() * sizeof(SkinVertex);
+		}
+		r.morphTargetCount = mesh->morphTargetCount;
+		r.morphVertexCount = (uint32_t)mesh->morphVertices.size();
+		r.morphDeltaCount = (uint32_t)mesh->morphDeltas.size();
+		if (r.morphVertexCount) {
+			morphBlobs[i] = packMorphTargets(mesh->morphVertices, mesh->morphDeltas);
+			r.morphOffset = offset = alignUp(offset, RUNEPAK_ALIGNMENT);
+			offset += morphBlobs[i].size();
+		}
+
+		r.contentHash = hashBytes(vertexBlobs[i].data(), vertexBlobs[i].size());
+		r.contentHash = hashBytes(indexBlobs[i].data(), indexBlobs[i].size(), r.contentHash);
+		r.contentHash = hashBytes(mesh->skinVertices.data(), mesh->skinVertices.size() * sizeof(SkinVertex), r.contentHash);
+		r.contentHash = hashBytes(morphBlobs[i].data(), morphBlobs[i].size(), r.contentHash);
+	}
+
+	std::vector<RunePakTexture> textureRecords(textures.size());
+	for (size_t i = 0; i < textures.size(); i++) {
+		RunePakTexture& r = textureRecords[i];
+		r.width = textures[i].width;
+		r.height = textures[i].height;
+		r.mipLevels = (uint32_t)textures[i].levels.size();
+		r.role = (uint32_t)roles[i];
+		r.format = (uint32_t)textures[i].format;
+		r.dataOffset = offset = alignUp(offset, RUNEPAK_ALIGNMENT);
+		r.dataSize = textures[i].data.size();
+		r.contentHash = hashCombine(hashBytes(textures[i].data.data(), r.dataSize), ((uint64_t)r.width << 32 | r.height) ^ r.format);
+		offset += r.dataSize;
+	}
+	header.fileSize = offset;
+
+	std::vector<RunePakMaterial> materialRecords(materials.size());
+	for (size_t i = 0; i < materials.size(); i++)
+		materialRecords[i] = packMaterial(materials[i]);
+
+	// ─────────────────────────────────────────────
+	// Write to a temp file and rename, so a crash never leaves a torn package
+	// ─────────────────────────────────────────────
+	std::string tempPath = pakPath + ".tmp";
+	bool ok = false;
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (out) {
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			writePadding(out, header.nodeOffset);
+			out.write(reinterpret_cast<const char*>(nodeRecords.data()), nodeRecords.size() * sizeof(RunePakNode));
+			writePadding(out, header.meshOffset);
+			out.write(reinterpret_cast<const char*>(meshRecords.data()), meshRecords.size() * sizeof(RunePakMesh));
+			writePadding(out, header.meshRefOffset);
+			out.write(reinterpret_cast<const char*>(meshRefs.data()), meshRefs.size() * sizeof(uint32_t));
+			writePadding(out, header.instanceOffset);
+			out.write(reinterpret_cast<const char*>(model.instances.data()), model.instances.size() * sizeof(glm::mat4));
+			writePadding(out, header.animationOffset);
+			out.write(reinterpret_cast<const char*>(animationRecords.data()), animationRecords.size() * sizeof(RunePakAnimation));
+			writePadding(out, header.trackOffset);
+			out.write(reinterpret_cast<const char*>(trackRecords.data()), trackRecords.size() * sizeof(RunePakTrack));
+			writePadding(out, header.keyOffset);
+			out.write(reinterpret_cast<const char*>(keys.data()), keys.size() * sizeof(uint16_t));
+			writePadding(out, header.keyValueOffset);
+			out.write(reinterpret_cast<const char*>(keyValues.data()), keyValues.size() * sizeof(uint16_t));
+			writePadding(out, header.skinOffset);
+			out.write(reinterpret_cast<const char*>(skinRecords.data()), skinRecords.size() * sizeof(RunePakSkin));
+			writePadding(out, header.jointOffset);
+			out.write(reinterpret_cast<const char*>(joints.data()), joints.size() * sizeof(int32_t));
+			writePadding(out, header.inverseBindOffset);
+			out.write(reinterpret_cast<const char*>(inverseBinds.data()), inverseBinds.size() * sizeof(glm::mat4));
+			writePadding(out, header.morphWeightOffset);
+			out.write(reinterpret_cast<const char*>(morphWeights.data()), morphWeights.size() * sizeof(float));
+			writePadding(out, header.dependencyOffset);
+			out.write(reinterpret_cast<const char*>(dependencies.data()), dependencies.size() * sizeof(RunePakDependency));
+			writePadding(out, header.materialOffset);
+			out.write(reinterpret_cast<const char*>(materialRecords.data()), materialRecords.size() * sizeof(RunePakMaterial));
+			writePadding(out, header.textureOffset);
+			out.write(reinterpret_cast<const char*>(textureRecords.data()), textureRecords.size() * sizeof(RunePakTexture));
+			out.write(names.data(), names.size());
+
+			for (size_t i = 0; i < meshes.size(); i++) {
+				writePadding(out, meshRecords[i].vertexOffset);
+				out.write(reinterpret_cast<const char*>(vertexBlobs[i].data()), vertexBlobs[i].size());
+				writePadding(out, meshRecords[i].indexOffset);
+				out.write(reinterpret_cast<const char*>(indexBlobs[i].data()), indexBlobs[i].size());
+				if (meshRecords[i].skinOffset) {
+					writePadding(out, meshRecords[i].skinOffset);
+					out.write(reinterpret_cast<const char*>(meshes[i]->skinVertices.data()), runepakSkinBytes(meshRecords[i]));
+				}
+				if (meshRecords[i].morphOffset) {
+					writePadding(out, meshRecords[i].morphOffset);
+					out.write(reinterpret_cast<const char*>(morphBlobs[i].data()), morphBlobs[i].size());
+				}
+			}
+			for (size_t i = 0; i < textures.size(); i++) {
+				writePadding(out, textureRecords[i].dataOffset);
+				out.write(reinterpret_cast<const char*>(textures[i].data.data()), textures[i].data.size());
+			}
+			ok = (bool)out;
+		}
+	}
+
+	nodeTreeDestroy(state, model.rootNode);
+	model.rootNode = nullptr;
+
+	// Streamed textures may still map the previous package
+	std::error_code ec;
+	fileRetiredRemove(pakPath);
+	if (ok)
+		ok = fileReplace(tempPath, pakPath);
+	if (!ok) {
+		std::filesystem::remove(tempPath, ec);
+		printf("runepakCook: failed to write %s\n", pakPath.c_str());
+		return false;
+	}
+
+	printf("runepakCook: %s -> %s (%llu bytes)\n", sourcePath.c_str(), pakPath.c_str(), (unsigned long long)header.fileSize);
+	return true;
+}
+
+// ─────────────────────────────────────────────
+// Load
+// ─────────────────────────────────────────────
+static bool inFile(const MappedFile& file, uint64_t offset, uint64_t size) {
+	return offset <= file.size && size <= file.size - offset;
+}
+
+uint32_t runepakFeatures(State* state) {
+	uint32_t features = 0;
+	if (state->context->textureCompressionBC)
+		features |= RUNEPAK_FEATURE_BC_TEXTURES;
+	if (state->config->meshOptimization)
+		features |= RUNEPAK_FEATURE_OPTIMIZED_MESHES;
+	if (state->config->vertexLayout == VertexLayout::Compact)
+		features |= RUNEPAK_FEATURE_COMPACT_VERTICES;
+	if (state->config->vertexLayout == VertexLayout::CompactQuantized)
+		features |= RUNEPAK_FEATURE_COMPACT_VERTICES | RUNEPAK_FEATURE_QUANTIZED_POSITIONS;
+	return features;
+}
+
+static VertexLayout featureVertexLayout(uint32_t features) {
+	if (features & RUNEPAK_FEATURE_QUANTIZED_POSITIONS)
+		return VertexLayout::CompactQuantized;
+	if (features & RUNEPAK_FEATURE_COMPACT_VERTICES)
+		return VertexLayout::Compact;
+	return VertexLayout::Float;
+}
+
+uint64_t runepakVertexBytes(const RunePakHeader& header, const RunePakMesh& mesh) {
+	return (uint64_t)mesh.vertexCount * header.vertexSize;
+}
+
+uint64_t runepakIndexBytes(const RunePakMesh& mesh) {
+	return (uint64_t)mesh.indexCount * indexTypeSize(meshIndexType(mesh.vertexCount));
+}
+
+uint64_t runepakSkinBytes(const RunePakMesh& mesh) {
+	return mesh.skinOffset ? (uint64_t)mesh.vertexCount * sizeof(SkinVertex) : 0;
+}
+
+uint64_t runepakMorphBytes(const RunePakMesh& mesh) {
+	return mesh.morphOffset
+		? (uint64_t)mesh.morphVertexCount * sizeof(MorphVertex) + (uint64_t)mesh.morphDeltaCount * sizeof(MorphDelta)
+		: 0;
+}
+
+static bool validatePackage(const MappedFile& file, uint64_t sourceHash, uint32_t features) {
+	if (file.size < sizeof(RunePakHeader))
+		return false;
+
+	const RunePakHeader* header = reinterpret_cast<const RunePakHeader*>(file.data);
+	if (memcmp(header->magic, RUNEPAK_MAGIC, sizeof(RUNEPAK_MAGIC)) != 0 ||
+		header->version != RUNEPAK_VERSION ||
+		header->vertexSize != vertexStride(featureVertexLayout(features)) ||
+		header->materialSize != sizeof(RunePakMaterial) ||
+		header->nodeSize != sizeof(RunePakNode) ||
+		header->features != features ||
+		header->sourceHash != sourceHash ||
+		header->fileSize != file.size)
+		return false;
+
+	if (header->nodeCount == 0 ||
+		!inFile(file, header->nodeOffset, (uint64_t)header->nodeCount * sizeof(RunePakNode)) ||
+		!inFile(file, header->meshOffset, (uint64_t)header->meshCount * sizeof(RunePakMesh)) ||
+		!inFile(file, header->meshRefOffset, (uint64_t)header->meshRefCount * sizeof(uint32_t)) ||
+		!inFile(file, header->instanceOffset, (uint64_t)header->instanceCount * sizeof(glm::mat4)) ||
+		header->instanceOffset % alignof(glm::mat4) != 0 ||
+		!inFile(file, header->animationOffset, (uint64_t)header->animationCount * sizeof(RunePakAnimation)) ||
+		!inFile(file, header->trackOffset, (uint64_t)header->trackCount * sizeof(RunePakTrack)) ||
+		!inFile(file, header->keyOffset, (uint64_t)header->keyCount * sizeof(uint16_t)) ||
+		!inFile(file, header->keyValueOffset, (uint64_t)header->keyValueCount * sizeof(uint16_t)) ||
+		header->animationOffset % alignof(RunePakAnimation) != 0 ||
+		header->trackOffset % alignof(RunePakTrack) != 0 ||
+		header->keyOffset % alignof(uint16_t) != 0 ||
+		header->keyValueOffset % alignof(uint16_t) != 0 ||
+		!inFile(file, header->skinOffset, (uint64_t)header->skinCount * sizeof(RunePakSkin)) ||
+		!inFile(file, header->jointOffset, (uint64_t)header->jointCount * sizeof(int32_t)) ||
+		!inFile(file, header->inverseBindOffset, (uint64_t)header->jointCount * sizeof(glm::mat4)) ||
+		header->jointOffset % alignof(int32_t) != 0 ||
+		header->inverseBindOffset % alignof(glm::mat4) != 0 ||
+		!inFile(file, header->morphWeightOffset, (uint64_t)header->morphWeightCount * sizeof(float)) ||
+		header->morphWeightOffset % alignof(float) != 0 ||
+		!inFile(file, header->dependencyOffset, (uint64_t)header->dependencyCount * sizeof(RunePakDependency)) ||
+		header->dependencyOffset % alignof(RunePakDependency) != 0 ||
+		!inFile(file, header->materialOffset, (uint64_t)header->materialCount * sizeof(RunePakMaterial)) ||
+		!inFile(file, header->textureOffset, (uint64_t)header->textureCount * sizeof(RunePakTexture)) ||
+		!inFile(file, header->stringOffset, header->stringSize))
+		return false;
+
+	const RunePakDependency* dependencies = reinterpret_cast<const RunePakDependency*>(file.data + header->dependencyOffset);
+	for (uint32_t i = 0; i < header->dependencyCount; i++) {
+		if ((uint64_t)dependencies[i].nameOffset + dependencies[i].nameLength > header->stringSize)
+			return false;
+	}
+
+	const RunePakNode* nodes = reinterpret_cast<const RunePakNode*>(file.data + header->nodeOffset);
+	for (uint32_t i = 0; i < header->nodeCount; i++) {
+		const RunePakNode& n = nodes[i];
+		if (n.parent >= (int32_t)i || (i > 0 && n.parent < 0) ||
+			(uint64_t)n.firstMesh + n.meshCount > header->meshRefCount ||
+			(uint64_t)n.firstInstance + n.instanceCount > header->instanceCount ||
+			n.skin >= (int32_t)header->skinCount ||
+			(uint64_t)n.firstMorphWeight + n.morphWeightCount > header->morphWeightCount ||
+			(uint64_t)n.nameOffset + n.nameLength > header->stringSize)
+			return false;
+	}
+
+	const uint32_t* meshRefs = reinterpret_cast<const uint32_t*>(file.data + header->meshRefOffset);
+	for (uint32_t i = 0; i < header->meshRefCount; i++) {
+		if (meshRefs[i] >= header->meshCount)
+			return false;
+	}
+
+	const RunePakMesh* meshes = reinterpret_cast<const RunePakMesh*>(file.data + header->meshOffset);
+	for (uint32_t i = 0; i < header->meshCount; i++) {
+		const RunePakMesh& m = meshes[i];
+		if (!inFile(file, m.vertexOffset, runepakVertexBytes(*header, m)) ||
+			!inFile(file, m.indexOffset, runepakIndexBytes(m)) ||
+			(m.skinOffset && (m.skinOffset % alignof(SkinVertex) != 0 || !inFile(file, m.skinOffset, runepakSkinBytes(m)))) ||
+			(m.morphOffset && (m.morphOffset % alignof(MorphDelta) != 0 || !inFile(file, m.morphOffset, runepakMorphBytes(m)))) ||
+			(m.morphOffset == 0) != (m.morphVertexCount == 0) ||
+			m.materialIndex >= (int32_t)header->materialCount)
+			return false;
+
+		// The morph pass indexes vertices and weights straight from these
+		if (m.morphOffset) {
+			const MorphVertex* morphVertices = reinterpret_cast<const MorphVertex*>(file.data + m.morphOffset);
+			const MorphDelta* morphDeltas = reinterpret_cast<const MorphDelta*>(morphVertices + m.morphVertexCount);
+			for (uint32_t v = 0; v < m.morphVertexCount; v++) {
+				if (morphVertices[v].vertex >= m.vertexCount ||
+					(uint64_t)morphVertices[v].firstDelta + morphVertices[v].deltaCount > m.morphDeltaCount)
+					return false;
+			}
+			for (uint32_t d = 0; d < m.morphDeltaCount; d++) {
+				if (morphDeltas[d].target >= m.morphTargetCount)
+					return false;
+			}
+		}
+	}
+
+	const RunePakAnimation* animations = reinterpret_cast<const RunePakAnimation*>(file.data + header->animationOffset);
+	const RunePakTrack* tracks = reinterpret_cast<const RunePakTrack*>(file.data + header->trackOffset);
+	for (uint32_t i = 0; i < header->animationCount; i++) {
+		const RunePakAnimation& a = animations[i];
+		if ((uint64_t)a.nameOffset + a.nameLength > header->stringSize ||
+			(uint64_t)a.firstTrack + a.trackCount > header->trackCount ||
+			(uint64_t)a.firstKey + a.keyCount > header->keyCount ||
+			(uint64_t)a.firstValue + a.valueCount > header->keyValueCount)
+			return false;
+		for (uint32_t j = 0; j < a.trackCount; j++) {
+			const RunePakTrack& t = tracks[a.firstTrack + j];
+			if (t.node >= header->nodeCount ||
+				t.path > AnimationTrack::WEIGHTS ||
+				t.interpolation > AnimationTrack::CUBICSPLINE)
+				return false;
+			uint64_t words = (uint64_t)t.keyCount * (t.interpolation == AnimationTrack::CUBICSPLINE ? 3 : 1) *
+				animationValueWords((AnimationTrack::Path)t.path, (AnimationTrack::Interpolation)t.interpolation);
+			if (t.keyCount == 0 ||
+				(uint64_t)t.firstKey + t.keyCount > a.keyCount ||
+				(uint64_t)t.firstValue + words > a.valueCount)
+				return false;
+		}
+	}
+
+	const RunePakSkin* skins = reinterpret_cast<const RunePakSkin*>(file.data + header->skinOffset);
+	const int32_t* joints = reinterpret_cast<const int32_t*>(file.data + header->jointOffset);
+	for (uint32_t i = 0; i < header->skinCount; i++) {
+		const RunePakSkin& s = skins[i];
+		if ((uint64_t)s.nameOffset + s.nameLength > header->stringSize ||
+			(uint64_t)s.firstJoint + s.jointCount > header->jointCount)
+			return false;
+	}
+	for (uint32_t i = 0; i < header->jointCount; i++) {
+		if (joints[i] >= (int32_t)header->nodeCount)
+			return false;
+	}
+
+	const RunePakTexture* textures = reinterpret_cast<const RunePakTexture*>(file.data + header->textureOffset);
+	for (uint32_t i = 0; i < header->textureCount; i++) {
+		const RunePakTexture& t = textures[i];
+		std::vector<MipLevel> levels = textureChainLayout((VkFormat)t.format, t.width, t.height, t.mipLevels);
+		if (levels.empty() ||
+			t.dataSize < levels.back().offset + levels.back().size ||
+			!inFile(file, t.dataOffset, t.dataSize))
+			return false;
+	}
+	return true;
+}
+
+bool runepakOpen(const std::string& pakPath, uint64_t sourceHash, uint32_t features, RunePakContents& out)
+{
+	out = RunePakContents{};
+	if (!fileMapOpen(pakPath, out.file))
+		return false;
+
+	if (!validatePackage(out.file, sourceHash, features)) {
+		fileMapClose(out.file);
+		return false;
+	}
+
+	const unsigned char* data = out.file.data;
+	const RunePakHeader* header = reinterpret_cast<const RunePakHeader*>(data);
+	const char* names = reinterpret_cast<const char*>(data + header->stringOffset);
+
+	// A changed .bin or image makes the package as stale as a changed source
+	const RunePakDependency* dependencies = reinterpret_cast<const RunePakDependency*>(data + header->dependencyOffset);
+	for (uint32_t i = 0; i < header->dependencyCount; i++) {
+		std::string path(names + dependencies[i].nameOffset, dependencies[i].nameLength);
+		uint64_t hash = 0;
+		if (!fileContentHash(path, hash) || hash != dependencies[i].contentHash) {
+			fileMapClose(out.file);
+			return false;
+		}
+		out.dependencies.push_back(std::move(path));
+	}
+
+	const RunePakNode* nodeRecords = reinterpret_cast<const RunePakNode*>(data + header->nodeOffset);
+	const RunePakMaterial* materialRecords = reinterpret_cast<const RunePakMaterial*>(data + header->materialOffset);
+	const uint32_t* meshRefs = reinterpret_cast<const uint32_t*>(data + header->meshRefOffset);
+	const float* morphWeights = reinterpret_cast<const float*>(data + header->morphWeightOffset);
+	out.header = header;
+	out.meshRecords = reinterpret_cast<const RunePakMesh*>(data + header->meshOffset);
+	out.textureRecords = reinterpret_cast<const RunePakTexture*>(data + header->textureOffset);
+	out.instances = reinterpret_cast<const glm::mat4*>(data + header->instanceOffset);
+
+	// Materials
+	out.materials.resize(header->materialCount);
+	for (uint32_t i = 0; i < header->materialCount; i++) {
+		out.materials[i] = new Material{};
+		unpackMaterial(materialRecords[i], 0, *out.materials[i]);
+	}
+
+	// Meshes, CPU side only; the vertex and index blobs stay in the mapping
+	out.meshes.resize(header->meshCount);
+	for (uint32_t i = 0; i < header->meshCount; i++) {
+		const RunePakMesh& r = out.meshRecords[i];
+		Mesh* mesh = new Mesh;
+		mesh->vertexCount = r.vertexCount;
+		mesh->indexCount = r.indexCount;
+		mesh->indexType = meshIndexType(r.vertexCount);
+		mesh->materialIndex = r.materialIndex;
+		mesh->minBounds = glm::make_vec3(r.minBounds);
+		mesh->maxBounds = glm::make_vec3(r.maxBounds);
+		mesh->center = glm::make_vec3(r.center);
+		mesh->skinned = r.skinOffset != 0;
+		mesh->morphTargetCount = r.morphTargetCount;
+		mesh->morphVertexCount = r.morphVertexCount;
+		mesh->morphDeltaCount = r.morphDeltaCount;
+		mesh->contentHash = r.contentHash;
+		out.meshes[i] = mesh;
+	}
+
+	// Nodes (pre-order, so parents always exist before their children)
+	std::vector<Node*> nodes(header->nodeCount);
+	for (uint32_t i = 0; i < header->nodeCount; i++) {
+		const RunePakNode& r = nodeRecords[i];
+		Node* node = new Node();
+		node->name.assign(names + r.nameOffset, r.nameLength);
+		node->matrix = glm::make_mat4(r.matrix);
+		node->translation = glm::make_vec3(r.translation);
+		node->rotation = glm::quat(r.rotation[3], r.rotation[0], r.rotation[1], r.rotation[2]);
+		node->scale = glm::make_vec3(r.scale);
+		node->firstInstance = r.firstInstance;
+		node->instanceCount = r.instanceCount;
+		node->skin = r.skin;
+		node->morphWeights.assign(morphWeights + r.firstMorphWeight, morphWeights + r.firstMorphWeight + r.morphWeightCount);
+		for (uint32_t m = 0; m < r.meshCount; m++)
+			node->addMesh(out.meshes[meshRefs[r.firstMesh + m]]);
+
+		if (r.parent >= 0) {
+			node->parent = nodes[r.parent];
+			node->parent->children.push_back(node);
+		}
+		nodes[i] = node;
+	}
+	out.rootNode = nodes[0];
+
+	// Animations, copied out of the mapping
+	const RunePakAnimation* animationRecords = reinterpret_cast<const RunePakAnimation*>(data + header->animationOffset);
+	const RunePakTrack* trackRecords = reinterpret_cast<const RunePakTrack*>(data + header->trackOffset);
+	const uint16_t* keys = reinterpret_cast<const uint16_t*>(data + header->keyOffset);
+	const uint16_t* keyValues = reinterpret_cast<const uint16_t*>(data + header->keyValueOffset);
+	out.animations.resize(header->animationCount);
+	for (uint32_t i = 0; i < header->animationCount; i++) {
+		const RunePakAnimation& r = animationRecords[i];
+		Animation& animation = out.animations[i];
+		animation.name.assign(names + r.nameOffset, r.nameLength);
+		animation.times.assign(keys + r.firstKey, keys + r.firstKey + r.keyCount);
+		animation.values.assign(keyValues + r.firstValue, keyValues + r.firstValue + r.valueCount);
+		animation.start = r.start;
+		animation.end = r.end;
+		animation.tracks.resize(r.trackCount);
+		for (uint32_t j = 0; j < r.trackCount; j++) {
+			const RunePakTrack& t = trackRecords[r.firstTrack + j];
+			animation.tracks[j] = AnimationTrack{
+				.node = nodes[t.node],
+				.path = (AnimationTrack::Path)t.path,
+				.interpolation = (AnimationTrack::Interpolation)t.interpolation,
+				.firstKey = t.firstKey,
+				.keyCount = t.keyCount,
+				.firstValue = t.firstValue,
+				.firstWeight = t.firstWeight,
+				.rangeMin = t.rangeMin,
+				.rangeExtent = t.rangeExtent,
+			};
+		}
+		animationFinalize(animation);
+	}
+
+	// Skins
+	const RunePakSkin* skinRecords = reinterpret_cast<const RunePakSkin*>(data + header->skinOffset);
+	const int32_t* joints = reinterpret_cast<const int32_t*>(data + header->jointOffset);
+	const glm::mat4* inverseBinds = reinterpret_cast<const glm::mat4*>(data + header->inverseBindOffset);
+	out.skins.resize(header->skinCount);
+	for (uint32_t i = 0; i < header->skinCount; i++) {
+		const RunePakSkin& r = skinRecords[i];
+		Skin& skin = out.skins[i];
+		skin.name.assign(names + r.nameOffset, r.nameLength);
+		for (uint32_t j = 0; j < r.jointCount; j++) {
+			int32_t joint = joints[r.firstJoint + j];
+			skin.joints.push_back(joint >= 0 ? nodes[joint] : nullptr);
+		}
+		skin.inverseBindMatrices.assign(inverseBinds + r.firstJoint, inverseBinds + r.firstJoint + r.jointCount);
+	}
+	return true;
+}
+
+std::vector<Material*> runepakInternMaterials(State* state, RunePakContents& contents, Model* model)
+{
+	std::vector<Material*> added;
+	model->materialIndices.clear();
+	for (Material* mat : contents.materials) {
+		bool isNew = false;
+		model->materialIndices.push_back(sceneInternMaterial(state->scene, mat, model->textureIndices, &isNew));
+		if (isNew)
+			added.push_back(mat);
+	}
+	contents.materials.clear();
+
+	for (Mesh* mesh : contents.meshes) {
+		if (mesh->materialIndex >= 0)
+			mesh->materialIndex = (int)model->materialIndices[mesh->materialIndex];
+	}
+	return added;
+}
+
+bool runepakLoad(State* state, const std::string& pakPath, uint64_t sourceHash, Model* model)
+{
+	RunePakContents pak;
+	if (!runepakOpen(pakPath, sourceHash, runepakFeatures(state), pak))
+		return false;
+
+	const unsigned char* data = pak.file.data;
+	model->rootNode = pak.rootNode;
+	modelTransformsInit(model);
+	model->animations = std::move(pak.animations);
+	model->skins = std::move(pak.skins);
+
+	// Textures, pre-mipped; ones already resident are shared. Streamed ones
+	// start with their coarse tail and keep the package mapped for the rest.
+	if (pak.header->textureCount == 0)
+		createFallbackModelTexture(state);
+	std::shared_ptr<const MappedFile> package = textureStreamPackage(pak.file);
+	for (uint32_t i = 0; i < pak.header->textureCount; i++) {
+		const RunePakTexture& r = pak.textureRecords[i];
+		uint64_t key = textureCacheKey(r.contentHash, (TextureRole)r.role);
+		int cached = sceneAcquireTexture(state->scene, key);
+		if (cached >= 0) {
+			model->textureIndices.push_back((uint32_t)cached);
+			continue;
+		}
+		Texture* tex = new Texture{};
+		tex->role = (TextureRole)r.role;
+		tex->contentHash = r.contentHash;
+		tex->stream = textureStreamCreate(state, r, package);
+
+		size_t offset = 0;
+		std::vector<MipLevel> levels = textureChainFrom(r, tex->stream ? tex->stream->residentMip : 0, offset);
+		createTextureFromLevels(state, data + r.dataOffset + offset, (size_t)(r.dataSize - offset),
+			(VkFormat)r.format, levels[0].width, levels[0].height, (uint32_t)levels.size(), *tex);
+		model->textureIndices.push_back(sceneAddTexture(state->scene, tex, key));
+		if (tex->stream)
+			textureStreamTrack(state, tex);
+	}
+	runepakInternMaterials(state, pak, model);
+
+	// Meshes, copied from the mapping into the staging arena and uploaded
+	// together
+	auto stage = [&](uint64_t offset, VkDeviceSize bytes, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory) {
+		memcpy(stagingArenaBuffer(state, bytes, usage, buffer, memory), data + offset, (size_t)bytes);
+	};
+	for (uint32_t i = 0; i < pak.header->meshCount; i++) {
+		const RunePakMesh& r = pak.meshRecords[i];
+		Mesh* mesh = pak.meshes[i];
+		if (r.vertexCount)
+			stage(r.vertexOffset, runepakVertexBytes(*pak.header, r), meshVertexUsage(*mesh), mesh->vertexBuffer, mesh->vertexMemory);
+		if (r.indexCount)
+			stage(r.indexOffset, runepakIndexBytes(r), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mesh->indexBuffer, mesh->indexMemory);
+		if (r.skinOffset)
+			stage(r.skinOffset, runepakSkinBytes(r), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, mesh->skinBuffer, mesh->skinMemory);
+		if (r.morphOffset)
+			stage(r.morphOffset, runepakMorphBytes(r), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, mesh->morphBuffer, mesh->morphMemory);
+	}
+	stagingArenaFlush(state);
+	model->instances.assign(pak.instances, pak.instances + pak.header->instanceCount);
+	createInstanceBuffer(state, model);
+	skinningCreate(state, model);
+
+	// The mapping closes with package unless a texture streams from it
+	return true;
+}
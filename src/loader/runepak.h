@@ -0,0 +1,258 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <vector>
+#include "scene/texture.h"
+#include "core/file_map.h"
+#include "scene/animation.h"
+
+struct State;
+struct Model;
+struct Node;
+struct Mesh;
+struct Material;
+
+// Cooked, memory-mappable model package: a header of counts and offsets,
+// then fixed-size records (pre-order nodes, meshes, materials, animations
+// and tracks, skins, textures, dependencies) and the tables and blobs they
+// slice, all in final runtime layout. Vertex and index blobs match the
+// configured VertexLayout and index width, and texture blobs are complete
+// mip chains (RGBA8 or BC). Blobs start on RUNEPAK_ALIGNMENT boundaries so
+// they copy straight from the mapping into staging memory.
+//
+// A package is valid only for the sourceHash and features it was cooked
+// with; dependency records carry the content hash of every external .bin
+// and image, so editing any of them forces a recook.
+constexpr uint32_t RUNEPAK_VERSION = 10;
+constexpr uint64_t RUNEPAK_ALIGNMENT = 4096;
+
+// Device capabilities and cook options a package was built with
+constexpr uint32_t RUNEPAK_FEATURE_BC_TEXTURES = 1u << 0;
+constexpr uint32_t RUNEPAK_FEATURE_OPTIMIZED_MESHES = 1u << 1;
+constexpr uint32_t RUNEPAK_FEATURE_COMPACT_VERTICES = 1u << 2;
+constexpr uint32_t RUNEPAK_FEATURE_QUANTIZED_POSITIONS = 1u << 3;
+
+struct RunePakHeader {
+	char     magic[8];
+	uint32_t version;
+	uint32_t vertexSize;
+	uint32_t materialSize;
+	uint32_t nodeSize;
+	uint32_t features;         // RUNEPAK_FEATURE_* flags
+	uint64_t sourceHash;
+	uint64_t fileSize;
+
+	uint32_t nodeCount;
+	uint32_t meshCount;
+	uint32_t materialCount;
+	uint32_t textureCount;
+	uint32_t meshRefCount;
+	uint32_t instanceCount;
+	uint32_t animationCount;
+	uint32_t trackCount;
+	uint32_t keyCount;
+	uint32_t keyValueCount;
+	uint32_t skinCount;
+	uint32_t jointCount;
+	uint32_t morphWeightCount;
+	uint32_t dependencyCount;
+
+	uint64_t nodeOffset;
+	uint64_t meshOffset;
+	uint64_t meshRefOffset;    // uint32 mesh indices, sliced by RunePakNode
+	uint64_t instanceOffset;   // glm::mat4 instance transforms, sliced by RunePakNode
+	uint64_t animationOffset;
+	uint64_t trackOffset;
+	uint64_t keyOffset;        // uint16 quantized key times, sliced by RunePakAnimation
+	uint64_t keyValueOffset;   // uint16 quantized key values, sliced by RunePakAnimation
+	uint64_t skinOffset;
+	uint64_t jointOffset;      // int32 pre-order joint node indices (-1 outside the scene), sliced by RunePakSkin
+	uint64_t inverseBindOffset;// glm::mat4, parallel to the joint table
+	uint64_t morphWeightOffset;// float default morph weights, sliced by RunePakNode
+	uint64_t dependencyOffset; // RunePakDependency records
+	uint64_t materialOffset;
+	uint64_t textureOffset;
+	uint64_t stringOffset;
+	uint64_t stringSize;
+};
+
+struct RunePakNode {
+	int32_t  parent;
+	uint32_t firstMesh;      // into the mesh reference table
+	uint32_t meshCount;
+	uint32_t firstInstance;  // into the instance table
+	uint32_t instanceCount;  // 0 for a regular node
+	int32_t  skin;           // -1 if unskinned
+	uint32_t firstMorphWeight; // into the morph weight table
+	uint32_t morphWeightCount;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	float    matrix[16];
+	float    translation[3];
+	float    rotation[4];   // x, y, z, w
+	float    scale[3];
+};
+
+struct RunePakMesh {
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	int32_t  materialIndex;  // model-local, -1 if none
+	float    minBounds[3];
+	float    maxBounds[3];
+	float    center[3];
+	uint64_t skinOffset;     // SkinVertex blob, 0 if not skinned
+	uint64_t morphOffset;    // packMorphTargets blob, 0 if no target moves a vertex
+	uint32_t morphTargetCount;
+	uint32_t morphVertexCount;
+	uint32_t morphDeltaCount;
+	uint32_t reserved;
+	uint64_t contentHash;    // over every blob, see Mesh::contentHash
+};
+
+struct RunePakSkin {
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t firstJoint;
+	uint32_t jointCount;
+};
+
+struct RunePakAnimation {
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t firstTrack;
+	uint32_t trackCount;
+	uint32_t firstKey;
+	uint32_t keyCount;
+	uint32_t firstValue;
+	uint32_t valueCount;
+	float    start;
+	float    end;
+};
+
+// AnimationTrack with the node as a pre-order index and its key ranges
+// relative to the owning RunePakAnimation.
+struct RunePakTrack {
+	uint32_t node;
+	uint32_t path;           // AnimationTrack::Path
+	uint32_t interpolation;  // AnimationTrack::Interpolation
+	uint32_t firstKey;
+	uint32_t keyCount;
+	uint32_t firstValue;
+	uint32_t firstWeight;    // AnimationTrack::firstWeight
+	uint32_t reserved;
+	glm::vec4 rangeMin;      // AnimationTrack dequantization range
+	glm::vec4 rangeExtent;
+};
+
+struct RunePakMaterial {
+	// Model-local texture indices, -1 if unused
+	int32_t baseColorTexture;
+	int32_t metallicRoughnessTexture;
+	int32_t normalTexture;
+	int32_t occlusionTexture;
+	int32_t emissiveTexture;
+	int32_t transmissionTexture;
+	int32_t thicknessTexture;
+
+	int32_t baseColorTexCoord;
+	int32_t metallicRoughnessTexCoord;
+	int32_t normalTexCoord;
+	int32_t occlusionTexCoord;
+	int32_t emissiveTexCoord;
+	int32_t transmissionTexCoord;
+	int32_t thicknessTexCoord;
+
+	TextureTransform baseColorTransform;
+	TextureTransform metallicRoughnessTransform;
+	TextureTransform normalTransform;
+	TextureTransform occlusionTransform;
+	TextureTransform emissiveTransform;
+	TextureTransform transmissionTransform;
+
+	glm::vec4 baseColorFactor;
+	glm::vec4 attenuationColor;
+	glm::vec3 emissiveFactor;
+	float     metallicFactor;
+	float     roughnessFactor;
+	float     transmissionFactor;
+	float     thicknessFactor;
+	float     attenuationDistance;
+	float     ior;
+	float     alphaCutoff;
+	uint32_t  alphaMode;     // 0 OPAQUE, 1 MASK, 2 BLEND
+	uint32_t  doubleSided;
+};
+
+struct RunePakTexture {
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipLevels;
+	uint32_t role;
+	uint32_t format;         // VkFormat, laid out by textureChainLayout
+	uint32_t reserved;
+	uint64_t dataOffset;
+	uint64_t dataSize;
+	uint64_t contentHash;    // hashBytes of the mip chain
+};
+
+// A file the source references (glTF .bin or image), path as the loader
+// resolved it
+struct RunePakDependency {
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint64_t contentHash;
+};
+
+// Package path for a source .gltf/.glb (same directory, .runepak extension).
+std::string runepakPath(const std::string& sourcePath);
+
+// RUNEPAK_FEATURE_* flags for the current device and config.
+uint32_t runepakFeatures(State* state);
+
+// Sizes of a mesh's vertex, index, skin and morph blobs
+uint64_t runepakVertexBytes(const RunePakHeader& header, const RunePakMesh& mesh);
+uint64_t runepakIndexBytes(const RunePakMesh& mesh);
+uint64_t runepakSkinBytes(const RunePakMesh& mesh);
+uint64_t runepakMorphBytes(const RunePakMesh& mesh);
+
+// Parses sourcePath and writes the package; sourceHash is stored so a changed
+// source is detected on the next load.
+bool runepakCook(State* state, const std::string& sourcePath, const std::string& pakPath, uint64_t sourceHash);
+
+// CPU half of a package load: the validated mapping plus the node tree, meshes
+// (record order, each shared by every node referencing it), materials and
+// animation clips built from it. Material, texture and mesh
+// material indices are model-local; no GPU resources are created.
+struct RunePakContents {
+	MappedFile file;
+	const RunePakHeader* header = nullptr;
+	const RunePakMesh* meshRecords = nullptr;
+	const RunePakTexture* textureRecords = nullptr;
+	const glm::mat4* instances = nullptr;
+
+	Node* rootNode = nullptr;
+	std::vector<Mesh*> meshes;
+	std::vector<Material*> materials;
+	std::vector<Animation> animations;
+	std::vector<Skin> skins;
+	std::vector<std::string> dependencies;
+};
+
+// Safe to call from a worker thread. Returns false, building nothing, on the
+// same conditions as runepakLoad or when a dependency changed; features is
+// runepakFeatures.
+bool runepakOpen(const std::string& pakPath, uint64_t sourceHash, uint32_t features, RunePakContents& out);
+
+// Interns contents.materials against model->textureIndices (see
+// sceneInternMaterial), fills model->materialIndices and points the meshes
+// at them. Returns the materials that were new to the scene; contents no
+// longer owns any. Main thread only.
+std::vector<Material*> runepakInternMaterials(State* state, RunePakContents& contents, Model* model);
+
+// Maps the package and fills model plus the scene's materials and textures.
+// Returns false, creating nothing, if the package is missing, was cooked from
+// different source bytes, with a different runtime layout or with different
+// features (device texture formats, mesh optimization, vertex layout).
+bool runepakLoad(State* state, const std::string& pakPath, uint64_t sourceHash, Model* model);
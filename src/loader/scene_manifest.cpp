@@ -0,0 +1,70 @@
+#include "loader/scene_manifest.h"
+#include "loader/model_loader.h"
+#include "loader/gltf_textures.h"
+#include "scene/scene.h"
+#include "core/state.h"
+#include <tiny_gltf.h>	// nlohmann::json
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+static glm::vec3 readVec3(const nlohmann::json& entry, const char* key, glm::vec3 fallback) {
+	if (!entry.contains(key))
+		return fallback;
+	const nlohmann::json& value = entry[key];
+	if (value.is_number())
+		return glm::vec3(value.get<float>());
+	if (!value.is_array() || value.size() != 3 || !value[0].is_number() || !value[1].is_number() || !value[2].is_number())
+		throw std::runtime_error(std::string("\"") + key + "\" must be an array of three numbers");
+	return glm::vec3(value[0].get<float>(), value[1].get<float>(), value[2].get<float>());
+}
+
+std::vector<SceneManifestEntry> sceneManifestRead(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("cannot read scene manifest " + path);
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	nlohmann::json document = nlohmann::json::parse(text, nullptr, false);
+	if (document.is_discarded() || !document.is_object() || !document.contains("models") || !document["models"].is_array())
+		throw std::runtime_error(path + ": expected an object with a \"models\" array");
+
+	std::filesystem::path baseDir = std::filesystem::path(path).parent_path();
+	std::vector<SceneManifestEntry> entries;
+	for (const nlohmann::json& model : document["models"]) {
+		if (!model.is_object() || !model.contains("path") || !model["path"].is_string())
+			throw std::runtime_error(path + ": every model needs a \"path\" string");
+		try {
+			glm::vec3 position = readVec3(model, "position", glm::vec3(0.0f));
+			glm::vec3 rotation = readVec3(model, "rotation", glm::vec3(0.0f));
+			glm::vec3 scale = readVec3(model, "scale", glm::vec3(1.0f));
+
+			SceneManifestEntry entry;
+			entry.path = (baseDir / model["path"].get<std::string>()).lexically_normal().generic_string();
+			entry.transform = glm::translate(glm::mat4(1.0f), position) *
+				glm::mat4_cast(glm::quat(glm::radians(rotation))) *
+				glm::scale(glm::mat4(1.0f), scale);
+			entries.push_back(std::move(entry));
+		}
+		catch (const std::runtime_error& e) {
+			throw std::runtime_error(path + ": " + e.what());
+		}
+	}
+	return entries;
+}
+
+void sceneManifestLoad(State* state, const std::string& path) {
+	std::vector<SceneManifestEntry> entries = sceneManifestRead(path);
+
+	// Materials without a texture sample the scene's first; make that the
+	// fallback whatever the first model turns out to be
+	if (state->scene->textures.empty())
+		createFallbackModelTexture(state);
+
+	const ModelLoad* previous = nullptr;
+	for (const SceneManifestEntry& entry : entries)
+		previous = loadModelAsync(state, entry.path, entry.transform, previous);
+	modelLoaderFinish(state);
+	printf("sceneManifestLoad: %s, %zu models\n", path.c_str(), state->scene->models.size());
+}
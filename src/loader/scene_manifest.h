@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "core/math.h"
+
+struct State;
+
+struct SceneManifestEntry {
+	std::string path;
+	glm::mat4 transform = glm::mat4(1.0f);
+};
+
+// Reads a scene manifest:
+//   { "models": [ { "path": "../models/Kobold.glb",
+//                   "position": [x, y, z],
+//                   "rotation": [x, y, z],     euler degrees
+//                   "scale": [x, y, z] or s }, ... ] }
+// Paths are relative to the manifest; the transform fields are optional and
+// compose like Model::setTransform. Throws std::runtime_error when malformed.
+std::vector<SceneManifestEntry> sceneManifestRead(const std::string& path);
+
+// Loads every model of the manifest at once through the model loader and
+// returns when each is in Scene::models or has failed. Models are published
+// in manifest order, so their Scene::models, texture and material indices
+// do not depend on which decode finished first. Needs modelLoaderCreate.
+void sceneManifestLoad(State* state, const std::string& path);
@@ -1,6 +1,8 @@
 #include "render/command_buffers.h"
 #include "resources/buffers.h"
 #include "render/renderer.h"
+#include "render/skinning.h"
+#include "render/texture_streaming.h"
 #include "scene/camera.h"
 #include "scene/scene.h"
 #include "scene/model.h"
@@ -66,6 +68,17 @@ void commandBufferGet(State* state) {
 	PANIC(vkAllocateCommandBuffers(state->context->device, &allocInfo, state->buffers->commandBuffer), "Failed To Create Command Buffer");
 };
 
+// Instanced nodes (EXT_mesh_gpu_instancing) draw every instance of a mesh at once
+static void drawItem(State* state, VkCommandBuffer cmd, const DrawItem& item, VkPipelineLayout layout) {
+    const Node* node = item.node;
+    if (node->instanceCount > 0)
+        drawMesh(state, cmd, item.mesh, item.vertexBuffer, node->worldMatrix, item.model->transform,
+            item.model->instanceBuffer, node->firstInstance, node->instanceCount, layout);
+    else
+        drawMesh(state, cmd, item.mesh, item.vertexBuffer, node->worldMatrix, item.model->transform,
+            state->renderer->identityInstanceBuffer, 0, 1, layout);
+}
+
 void commandBufferRecord(State* state)
 {
     // 1. FRAME + IMAGE INDICES
@@ -77,6 +90,8 @@ void commandBufferRecord(State* state)
     VkCommandBufferBeginInfo beginInfo{ .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
     vkBeginCommandBuffer(cmd, &beginInfo);
 
+    skinningRecord(state, cmd);
+
     VkViewport viewport{
         .x = 0.f, .y = 0.f,
         .width = (float)state->window.swapchain.imageExtent.width,
@@ -92,8 +107,9 @@ void commandBufferRecord(State* state)
     // 2. BUILD DRAW LISTS
     std::vector<DrawItem> allItems;
     for (Model* model : state->scene->models) {
-        gatherDrawItems(model->rootNode, state->scene->camera->getPosition(), state->scene->materials, model, allItems);
+        gatherDrawItems(state->scene->camera->getPosition(), state->scene->materials, model, allItems);
     }
+    textureStreamingRequest(state, allItems);
 
     std::vector<DrawItem> opaqueItems;
     std::vector<DrawItem> transparentItems;
@@ -132,7 +148,7 @@ void commandBufferRecord(State* state)
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, state->renderer->opaquePipelineLayout, 0, 1, &state->renderer->globalSets[frameIndex], 0, nullptr);
 
     for (auto& item : opaqueItems) {
-        drawMesh(state, cmd, item.mesh, item.node->getGlobalMatrix(), item.model->transform, state->renderer->opaquePipelineLayout);
+        drawItem(state, cmd, item, state->renderer->opaquePipelineLayout);
     }
     vkCmdEndRenderPass(cmd);
 
@@ -259,7 +275,7 @@ void commandBufferRecord(State* state)
 
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, state->renderer->transparencyPipeline);
     for (auto& item : transparentItems) {
-        drawMesh(state, cmd, item.mesh, item.node->getGlobalMatrix(), item.model->transform, state->renderer->transparencyPipelineLayout);
+        drawItem(state, cmd, item, state->renderer->transparencyPipelineLayout);
     }
     vkCmdEndRenderPass(cmd);
 
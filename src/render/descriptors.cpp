@@ -60,6 +60,56 @@ void iblSetLayoutDestroy(State* state)
 {
 	vkDestroyDescriptorSetLayout(state->context->device, state->renderer->iblSetLayout, nullptr);
 }
+// Skinning compute: source vertices, skin vertices, joint palette (dynamic
+// offset per frame in flight), skinned output
+void skinSetLayoutCreate(State* state)
+{
+	std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+	VkDescriptorSetLayoutCreateInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	info.bindingCount = static_cast<uint32_t>(bindings.size());
+	info.pBindings = bindings.data();
+
+	PANIC(vkCreateDescriptorSetLayout(state->context->device, &info, nullptr, &state->renderer->skinSetLayout),
+		"Failed to create skinning set layout");
+}
+void skinSetLayoutDestroy(State* state)
+{
+	vkDestroyDescriptorSetLayout(state->context->device, state->renderer->skinSetLayout, nullptr);
+}
+// Morph compute: output vertices, morph targets, weights (dynamic offset
+// per frame in flight)
+void morphSetLayoutCreate(State* state)
+{
+	std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+	VkDescriptorSetLayoutCreateInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	info.bindingCount = static_cast<uint32_t>(bindings.size());
+	info.pBindings = bindings.data();
+
+	PANIC(vkCreateDescriptorSetLayout(state->context->device, &info, nullptr, &state->renderer->morphSetLayout),
+		"Failed to create morph set layout");
+}
+void morphSetLayoutDestroy(State* state)
+{
+	vkDestroyDescriptorSetLayout(state->context->device, state->renderer->morphSetLayout, nullptr);
+}
 void iblDescriptorPoolCreate(State* state)
 {
 	VkDevice device = state->context->device;
@@ -322,7 +372,7 @@ void globalDescriptorPoolCreate(State* state)
 
 	VkDescriptorPoolCreateInfo poolInfo{
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-		.flags = 0,
+		.flags = flags,
 		.maxSets = totalSets,
 		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
 		.pPoolSizes = poolSizes.data(),
@@ -637,11 +687,23 @@ void materialSetLayoutCreate(State* state) {
 void materialSetLayoutDestroy(State* state) {
 	vkDestroyDescriptorSetLayout(state->context->device, state->renderer->materialSetLayout, nullptr);
 }
+// Materials the model loader published already have sets from its own pools
+static uint32_t materialsWithoutSet(State* state)
+{
+	uint32_t count = 0;
+	for (Material* mat : state->scene->materials)
+		count += mat->descriptorSet == VK_NULL_HANDLE;
+	return count;
+}
 void materialDescriptorPoolCreate(State* state)
 {
-	uint32_t materialCount = state->scene->materials.size();
+	uint32_t materialCount = materialsWithoutSet(state);
 	if (materialCount == 0) return;
 
+	materialDescriptorPoolCreateFor(state, materialCount, state->renderer->materialDescriptorPool);
+}
+void materialDescriptorPoolCreateFor(State* state, uint32_t materialCount, VkDescriptorPool& outPool, VkDescriptorPoolCreateFlags flags)
+{
 	uint32_t materialImageDescriptors =
 		materialCount * 7 * state->renderer->descriptorPoolMultiplier;  // 7 textures
 
@@ -664,7 +726,7 @@ void materialDescriptorPoolCreate(State* state)
 
 	VkDescriptorPoolCreateInfo poolInfo{
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-		.flags = 0,
+		.flags = flags,
 		.maxSets = totalSets,
 		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
 		.pPoolSizes = poolSizes.data(),
@@ -675,7 +737,7 @@ void materialDescriptorPoolCreate(State* state)
 			state->context->device,
 			&poolInfo,
 			nullptr,
-			&state->renderer->materialDescriptorPool
+			&outPool
 		),
 		"Failed to create material descriptor pool!"
 	);
@@ -692,11 +754,13 @@ void materialDescriptorPoolDestroy(State* state)
 }
 void materialSetsCreate(State* state)
 {
-	uint32_t materialCount = state->scene->materials.size();
+	uint32_t materialCount = materialsWithoutSet(state);
 	if (materialCount == 0) return;
 
 	for (Material* mat : state->scene->materials)
 	{
+		if (mat->descriptorSet != VK_NULL_HANDLE)
+			continue;
 		VkDescriptorSetAllocateInfo allocInfo{
 			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
 			.descriptorPool = state->renderer->materialDescriptorPool,
@@ -707,105 +771,116 @@ void materialSetsCreate(State* state)
 		VkResult result = allocateDescriptorSetsWithResize(state, &allocInfo, &mat->descriptorSet);
 		PANIC(result, "Failed to allocate material descriptor set");
 
-		auto resolveTex = [&](int index) -> const Texture& {
-			if (index >= 0 && index < (int)state->scene->textures.size()) {
-				return *state->scene->textures[index];
-			}
-				return *state->scene->textures[state->scene->defaultTextureIndex];
-			};
-
-		const Texture& baseTex = resolveTex(mat->baseColorTextureIndex);
-		const Texture& mrTex = resolveTex(mat->metallicRoughnessTextureIndex);
-		const Texture& occTex = resolveTex(mat->occlusionTextureIndex);
-		const Texture& emisTex = resolveTex(mat->emissiveTextureIndex);
-		const Texture& normTex = resolveTex(mat->normalTextureIndex);
-		const Texture& transTex = resolveTex(mat->transmissionTextureIndex);
-		const Texture& thickTex = resolveTex(mat->thicknessTextureIndex);
-
-		
-		// MaterialGPU UBO
-		MaterialGPU gpu{};
-		gpu.baseColorTT = toGPU(mat->baseColorTransform);
-		gpu.mrTT = toGPU(mat->metallicRoughnessTransform);
-		gpu.normalTT = toGPU(mat->normalTransform);
-		gpu.occlusionTT = toGPU(mat->occlusionTransform);
-		gpu.emissiveTT = toGPU(mat->emissiveTransform);
-
-		// UV set indices (0 or 1)
-		gpu.baseColorTT.rot_center_tex.w = static_cast<float>(mat->baseColorTexCoordIndex);
-		gpu.mrTT.rot_center_tex.w = static_cast<float>(mat->metallicRoughnessTexCoordIndex);
-		gpu.normalTT.rot_center_tex.w = static_cast<float>(mat->normalTexCoordIndex);
-		gpu.occlusionTT.rot_center_tex.w = static_cast<float>(mat->occlusionTexCoordIndex);
-		gpu.emissiveTT.rot_center_tex.w = static_cast<float>(mat->emissiveTexCoordIndex);
-
-		gpu.thicknessFactor = mat->thicknessFactor;
-		gpu.attenuationDistance = mat->attenuationDistance;
-		gpu.attenuationColor = mat->attenuationColor;
-		gpu.ior = mat->ior;
-
-		createBufferForMaterial(
-			state,
-			sizeof(MaterialGPU),
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			&mat->materialBuffer,
-			&mat->materialMemory
-		);
+		materialSetWrite(state, mat);
+	}
+}
+// Scene texture a material index samples; the default texture where there is none
+static const Texture& materialTexture(State* state, int index)
+{
+	if (index >= 0 && index < (int)state->scene->textures.size()) {
+		return *state->scene->textures[index];
+	}
+	return *state->scene->textures[state->scene->defaultTextureIndex];
+}
+void materialSetWrite(State* state, Material* mat)
+{
+	const Texture& normTex = materialTexture(state, mat->normalTextureIndex);
+
+	// MaterialGPU UBO
+	MaterialGPU gpu{};
+	gpu.baseColorTT = toGPU(mat->baseColorTransform);
+	gpu.mrTT = toGPU(mat->metallicRoughnessTransform);
+	gpu.normalTT = toGPU(mat->normalTransform);
+	gpu.occlusionTT = toGPU(mat->occlusionTransform);
+	gpu.emissiveTT = toGPU(mat->emissiveTransform);
+
+	// UV set indices (0 or 1)
+	gpu.baseColorTT.rot_center_tex.w = static_cast<float>(mat->baseColorTexCoordIndex);
+	gpu.mrTT.rot_center_tex.w = static_cast<float>(mat->metallicRoughnessTexCoordIndex);
+	gpu.normalTT.rot_center_tex.w = static_cast<float>(mat->normalTexCoordIndex);
+	gpu.occlusionTT.rot_center_tex.w = static_cast<float>(mat->occlusionTexCoordIndex);
+	gpu.emissiveTT.rot_center_tex.w = static_cast<float>(mat->emissiveTexCoordIndex);
+
+	gpu.thicknessFactor = mat->thicknessFactor;
+	gpu.attenuationDistance = mat->attenuationDistance;
+	gpu.attenuationColor = mat->attenuationColor;
+	gpu.ior = mat->ior;
+	gpu.normalTwoChannel = normTex.format == VK_FORMAT_BC5_UNORM_BLOCK ? 1.0f : 0.0f;
+
+	createBufferForMaterial(
+		state,
+		sizeof(MaterialGPU),
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		&mat->materialBuffer,
+		&mat->materialMemory
+	);
 
-		void* data = nullptr;
-		vkMapMemory(state->context->device, mat->materialMemory, 0, sizeof(MaterialGPU), 0, &data);
-		memcpy(data, &gpu, sizeof(MaterialGPU));
-		vkUnmapMemory(state->context->device, mat->materialMemory);
+	void* data = nullptr;
+	vkMapMemory(state->context->device, mat->materialMemory, 0, sizeof(MaterialGPU), 0, &data);
+	memcpy(data, &gpu, sizeof(MaterialGPU));
+	vkUnmapMemory(state->context->device, mat->materialMemory);
 
-		VkDescriptorBufferInfo materialBufInfo{
-			.buffer = mat->materialBuffer,
-			.offset = 0,
-			.range = sizeof(MaterialGPU)
-		};
+	materialSetUpdate(state, mat, mat->descriptorSet);
+}
+void materialSetUpdate(State* state, const Material* mat, VkDescriptorSet set)
+{
+	const Texture& baseTex = materialTexture(state, mat->baseColorTextureIndex);
+	const Texture& mrTex = materialTexture(state, mat->metallicRoughnessTextureIndex);
+	const Texture& occTex = materialTexture(state, mat->occlusionTextureIndex);
+	const Texture& emisTex = materialTexture(state, mat->emissiveTextureIndex);
+	const Texture& normTex = materialTexture(state, mat->normalTextureIndex);
+	const Texture& transTex = materialTexture(state, mat->transmissionTextureIndex);
+	const Texture& thickTex = materialTexture(state, mat->thicknessTextureIndex);
+
+	VkDescriptorBufferInfo materialBufInfo{
+		.buffer = mat->materialBuffer,
+		.offset = 0,
+		.range = sizeof(MaterialGPU)
+	};
 
-		// 6 textures (0–4 existing, 6 = transmission)
-		std::array<VkDescriptorImageInfo, 7> infos{
-			VkDescriptorImageInfo{ baseTex.textureSampler,  baseTex.textureImageView,  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 0
-			VkDescriptorImageInfo{ mrTex.textureSampler,    mrTex.textureImageView,    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 1
-			VkDescriptorImageInfo{ occTex.textureSampler,   occTex.textureImageView,   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 2
-			VkDescriptorImageInfo{ emisTex.textureSampler,  emisTex.textureImageView,  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 3
-			VkDescriptorImageInfo{ normTex.textureSampler,  normTex.textureImageView,  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 4
-			VkDescriptorImageInfo{ transTex.textureSampler, transTex.textureImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 5
-			VkDescriptorImageInfo{ thickTex.textureSampler, thickTex.textureImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 6
+	// 6 textures (0–4 existing, 6 = transmission)
+	std::array<VkDescriptorImageInfo, 7> infos{
+		VkDescriptorImageInfo{ baseTex.textureSampler,  baseTex.textureImageView,  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 0
+		VkDescriptorImageInfo{ mrTex.textureSampler,    mrTex.textureImageView,    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 1
+		VkDescriptorImageInfo{ occTex.textureSampler,   occTex.textureImageView,   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 2
+		VkDescriptorImageInfo{ emisTex.textureSampler,  emisTex.textureImageView,  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 3
+		VkDescriptorImageInfo{ normTex.textureSampler,  normTex.textureImageView,  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 4
+		VkDescriptorImageInfo{ transTex.textureSampler, transTex.textureImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 5
+		VkDescriptorImageInfo{ thickTex.textureSampler, thickTex.textureImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, // 6
 
-		};
+	};
 
-		// 7 writes: 0–4 textures, 5 UBO, 6 transmission
-		std::array<VkWriteDescriptorSet, 8> writes{};
+	// 7 writes: 0–4 textures, 5 UBO, 6 transmission
+	std::array<VkWriteDescriptorSet, 8> writes{};
+
+	// binding 5: material UBO
+	writes[0] = {
+		.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		.dstSet = set,
+		.dstBinding = 0,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		.pBufferInfo = &materialBufInfo
+	};
 
-		// binding 5: material UBO
-		writes[0] = {
+	// bindings 0–4: existing textures
+	for (uint32_t i = 1; i <= 7; ++i) {
+		writes[i] = {
 			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-			.dstSet = mat->descriptorSet,
-			.dstBinding = 0,
+			.dstSet = set,
+			.dstBinding = i,
 			.descriptorCount = 1,
-			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-			.pBufferInfo = &materialBufInfo
+			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			.pImageInfo = &infos[i-1]
 		};
-
-		// bindings 0–4: existing textures
-		for (uint32_t i = 1; i <= 7; ++i) {
-			writes[i] = {
-				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-				.dstSet = mat->descriptorSet,
-				.dstBinding = i,
-				.descriptorCount = 1,
-				.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				.pImageInfo = &infos[i-1]
-			};
-		}
-
-		vkUpdateDescriptorSets(
-			state->context->device,
-			static_cast<uint32_t>(writes.size()),
-			writes.data(),
-			0, nullptr
-		);
 	}
+
+	vkUpdateDescriptorSets(
+		state->context->device,
+		static_cast<uint32_t>(writes.size()),
+		writes.data(),
+		0, nullptr
+	);
 }
 
 // set 2: present (sceneColor, transAccum, transReveal)
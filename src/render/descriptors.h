@@ -24,6 +24,12 @@ void iblDescriptorPoolCreate(State* state);
 void iblDescriptorPoolDestroy(State* state);
 void iblSetCreate(State* state);
 
+// Skinning and morph compute (set = 0 of their pipelines)
+void skinSetLayoutCreate(State* state);
+void skinSetLayoutDestroy(State* state);
+void morphSetLayoutCreate(State* state);
+void morphSetLayoutDestroy(State* state);
+
 void brdfLutSetLayoutCreate(State* state);
 void brdfLutDescriptorCreate(State* state);
 
@@ -38,8 +44,14 @@ void globalSetsCreate(State* state);
 void materialSetLayoutCreate(State* state);
 void materialSetLayoutDestroy(State* state);
 void materialDescriptorPoolCreate(State* state);
+// Pool sized for materialCount sets; used for models published after init.
+void materialDescriptorPoolCreateFor(State* state, uint32_t materialCount, VkDescriptorPool& outPool, VkDescriptorPoolCreateFlags flags = 0);
 void materialDescriptorPoolDestroy(State* state);
 void materialSetsCreate(State* state);
+// Creates the material UBO and writes mat->descriptorSet (already allocated).
+void materialSetWrite(State* state, Material* mat);
+// Writes mat's UBO and current texture views into set.
+void materialSetUpdate(State* state, const Material* mat, VkDescriptorSet set);
 
 // set 2: present pass (sceneColor at binding 2, sceneDepth at binding 3)
 void presentSetLayoutCreate(State* state);
@@ -19,8 +19,9 @@ struct MaterialGPU {
 	// Transmission + Volume
 	float thicknessFactor;
 	float attenuationDistance;
-	glm::vec4 attenuationColor;
+	alignas(16) glm::vec4 attenuationColor;  // std140 vec4 alignment
 	float ior;
+	float normalTwoChannel;  // 1 when the normal map is BC5 (RG only)
 };
 
 TexTransformGPU toGPU(const TextureTransform t);
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "core/context.h"
 #include "core/config.h"
 #include "core/state.h"
+#include <unordered_map>
 
 //utility
 static std::vector<char> shaderRead(const char* filePath) {
@@ -20,6 +21,75 @@ static std::vector<char> shaderRead(const char* filePath) {
 	file.close();
 	return buffer;
 };
+
+// Bitmask of the Input-storage locations a SPIR-V module declares; a stale
+// binary is missing the ones a newer shader source added. A matrix input takes
+// one location per column and an array one per element.
+static uint32_t shaderInputLocations(const std::vector<char>& code) {
+	const uint32_t* words = reinterpret_cast<const uint32_t*>(code.data());
+	size_t count = code.size() / sizeof(uint32_t);
+	std::unordered_map<uint32_t, uint32_t> locations;
+	std::unordered_map<uint32_t, uint32_t> pointees;	// pointer type -> pointee
+	std::unordered_map<uint32_t, uint32_t> matrices;	// type -> column count
+	std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> arrays;	// type -> (element, length id)
+	std::unordered_map<uint32_t, uint32_t> constants;
+	std::vector<std::pair<uint32_t, uint32_t>> inputs;	// (variable, pointer type)
+	for (size_t i = 5; i < count;) {	// past the module header
+		uint32_t wordCount = words[i] >> 16;
+		uint32_t opcode = words[i] & 0xFFFF;
+		if (wordCount == 0 || i + wordCount > count)
+			break;
+		if (opcode == 71 && wordCount >= 4 && words[i + 2] == 30)	// OpDecorate Location
+			locations[words[i + 1]] = words[i + 3];
+		else if (opcode == 59 && wordCount >= 4 && words[i + 3] == 1)	// OpVariable Input
+			inputs.push_back({ words[i + 2], words[i + 1] });
+		else if (opcode == 32 && wordCount >= 4)	// OpTypePointer
+			pointees[words[i + 1]] = words[i + 3];
+		else if (opcode == 24 && wordCount >= 4)	// OpTypeMatrix
+			matrices[words[i + 1]] = words[i + 3];
+		else if (opcode == 28 && wordCount >= 4)	// OpTypeArray
+			arrays[words[i + 1]] = { words[i + 2], words[i + 3] };
+		else if (opcode == 43 && wordCount >= 4)	// OpConstant
+			constants[words[i + 2]] = words[i + 3];
+		i += wordCount;
+	}
+	auto locationCount = [&](uint32_t type) {
+		uint32_t n = 1;
+		for (auto array = arrays.find(type); array != arrays.end(); array = arrays.find(type)) {
+			auto length = constants.find(array->second.second);
+			n *= length != constants.end() ? length->second : 1;
+			type = array->second.first;
+		}
+		auto matrix = matrices.find(type);
+		return matrix != matrices.end() ? n * matrix->second : n;
+	};
+	uint32_t mask = 0;
+	for (auto [id, pointer] : inputs) {
+		auto it = locations.find(id);
+		if (it == locations.end())
+			continue;
+		uint32_t n = locationCount(pointees[pointer]);
+		for (uint32_t location = it->second; location < it->second + n && location < 32; location++)
+			mask |= 1u << location;
+	}
+	return mask;
+}
+
+// Binding 0 per vertex in the configured layout, binding 1 the per-instance
+// transform (identity buffer for uninstanced draws)
+struct MeshVertexInput {
+	std::array<VkVertexInputBindingDescription, 2> bindings;
+	std::vector<VkVertexInputAttributeDescription> attributes;
+};
+
+static MeshVertexInput meshVertexInput(VertexLayout layout) {
+	MeshVertexInput input{ .bindings = { vertexBindingDescription(layout), instanceBindingDescription() } };
+	for (const VkVertexInputAttributeDescription& attribute : vertexAttributeDescriptions(layout))
+		input.attributes.push_back(attribute);
+	for (const VkVertexInputAttributeDescription& attribute : instanceAttributeDescriptions())
+		input.attributes.push_back(attribute);
+	return input;
+}
 //Compute Pipelines
 void iblPipelineCreate(State* state)
 {
@@ -124,6 +194,87 @@ void brdfLutPipelineCreate(State* state)
 
     vkDestroyShaderModule(state->context->device, computeShaderModule, nullptr);
 }
+// Skinning and morph passes: one storage set, three uint push constants
+// and the VERTEX_LAYOUT spec constant
+static void vertexComputePipelineCreate(State* state, const char* path, VkDescriptorSetLayout setLayout,
+	VkPipelineLayout& pipelineLayout, VkPipeline& pipeline)
+{
+	VkDevice device = state->context->device;
+
+	std::vector<char> code = shaderRead(path);
+	VkShaderModuleCreateInfo moduleInfo{
+		.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+		.codeSize = code.size(),
+		.pCode = reinterpret_cast<const uint32_t*>(code.data()),
+	};
+	VkShaderModule module;
+	PANIC(vkCreateShaderModule(device, &moduleInfo, nullptr, &module),
+		"Failed to create vertex compute shader module");
+
+	// constant_id 0 selects the vertex words rewritten for Config::vertexLayout
+	uint32_t vertexLayout = (uint32_t)state->config->vertexLayout;
+	VkSpecializationMapEntry vertexLayoutEntry{ .constantID = 0, .offset = 0, .size = sizeof(uint32_t) };
+	VkSpecializationInfo vertexSpecialization{
+		.mapEntryCount = 1,
+		.pMapEntries = &vertexLayoutEntry,
+		.dataSize = sizeof(uint32_t),
+		.pData = &vertexLayout,
+	};
+	VkPipelineShaderStageCreateInfo stage{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+		.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+		.module = module,
+		.pName = "main",
+		.pSpecializationInfo = &vertexSpecialization,
+	};
+
+	VkPushConstantRange range{
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = sizeof(uint32_t) * 3,
+	};
+	VkPipelineLayoutCreateInfo layoutInfo{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &setLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &range,
+	};
+	PANIC(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout),
+		"Failed to create vertex compute pipeline layout");
+
+	VkComputePipelineCreateInfo pipeInfo{
+		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		.stage = stage,
+		.layout = pipelineLayout,
+	};
+	PANIC(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeInfo, nullptr, &pipeline),
+		"Failed to create vertex compute pipeline");
+
+	vkDestroyShaderModule(device, module, nullptr);
+}
+// push constants: vertexCount, vertexWords, paletteBase
+void skinPipelineCreate(State* state)
+{
+	vertexComputePipelineCreate(state, "./res/shaders/skin_compute.spv", state->renderer->skinSetLayout,
+		state->renderer->skinPipelineLayout, state->renderer->skinPipeline);
+}
+void skinPipelineDestroy(State* state)
+{
+	vkDestroyPipeline(state->context->device, state->renderer->skinPipeline, nullptr);
+	vkDestroyPipelineLayout(state->context->device, state->renderer->skinPipelineLayout, nullptr);
+}
+// push constants: morphVertexCount, vertexWords, weightBase
+void morphPipelineCreate(State* state)
+{
+	vertexComputePipelineCreate(state, "./res/shaders/morph_compute.spv", state->renderer->morphSetLayout,
+		state->renderer->morphPipelineLayout, state->renderer->morphPipeline);
+}
+void morphPipelineDestroy(State* state)
+{
+	vkDestroyPipeline(state->context->device, state->renderer->morphPipeline, nullptr);
+	vkDestroyPipelineLayout(state->context->device, state->renderer->morphPipelineLayout, nullptr);
+}
 
 //Graphics Pipelines
 void skyboxPipelineCreate(State* state) {
@@ -312,11 +463,21 @@ void opaquePipelineCreate(State* state) {
 	};
 	PANIC(vkCreateShaderModule(state->context->device, &fragShaderModuleInfo, nullptr, &state->renderer->opaqueFragShaderModule), "Failed To Create Fragment Shader Module");
 	//ShaderStages
+	// constant_id 0 selects the vertex decode for Config::vertexLayout
+	uint32_t vertexLayout = (uint32_t)state->config->vertexLayout;
+	VkSpecializationMapEntry vertexLayoutEntry{ .constantID = 0, .offset = 0, .size = sizeof(uint32_t) };
+	VkSpecializationInfo vertexSpecialization{
+		.mapEntryCount = 1,
+		.pMapEntries = &vertexLayoutEntry,
+		.dataSize = sizeof(uint32_t),
+		.pData = &vertexLayout,
+	};
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
 		.stage = VK_SHADER_STAGE_VERTEX_BIT,
 		.module = state->renderer->vertShaderModule,
-		.pName = "main"
+		.pName = "main",
+		.pSpecializationInfo = &vertexSpecialization,
 	};
 	VkPipelineShaderStageCreateInfo fragShaderStageInfo{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -337,14 +498,16 @@ void opaquePipelineCreate(State* state) {
 		.pDynamicStates = dynamicStates.data(),
 	};
 	//VertexInputs
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	MeshVertexInput vertexInput = meshVertexInput(state->config->vertexLayout);
+	uint32_t vertexInputs = shaderInputLocations(vertShaderCode);
+	for (const VkVertexInputAttributeDescription& attribute : vertexInput.attributes)
+		PANIC(!(vertexInputs & (1u << attribute.location)), "vert.spv has no input at location %u, rebuild it from shader.vert", attribute.location);
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-		.vertexBindingDescriptionCount = 1,
-		.pVertexBindingDescriptions = &bindingDescription,
-		.vertexAttributeDescriptionCount = (uint32_t)attributeDescriptions.size(),
-		.pVertexAttributeDescriptions = attributeDescriptions.data(),
+		.vertexBindingDescriptionCount = (uint32_t)vertexInput.bindings.size(),
+		.pVertexBindingDescriptions = vertexInput.bindings.data(),
+		.vertexAttributeDescriptionCount = (uint32_t)vertexInput.attributes.size(),
+		.pVertexAttributeDescriptions = vertexInput.attributes.data(),
 	};
 
 	//InputAssembly
@@ -482,11 +645,20 @@ void transparencyPipelineCreate(State* state) {
 	);
 
 	// Shader stages
+	uint32_t vertexLayout = (uint32_t)state->config->vertexLayout;
+	VkSpecializationMapEntry vertexLayoutEntry{ .constantID = 0, .offset = 0, .size = sizeof(uint32_t) };
+	VkSpecializationInfo vertexSpecialization{
+		.mapEntryCount = 1,
+		.pMapEntries = &vertexLayoutEntry,
+		.dataSize = sizeof(uint32_t),
+		.pData = &vertexLayout,
+	};
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
 		.stage = VK_SHADER_STAGE_VERTEX_BIT,
 		.module = state->renderer->vertShaderModule,
-		.pName = "main"
+		.pName = "main",
+		.pSpecializationInfo = &vertexSpecialization,
 	};
 	VkPipelineShaderStageCreateInfo fragShaderStageInfo{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -508,14 +680,13 @@ void transparencyPipelineCreate(State* state) {
 	};
 
 	// Vertex input
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	MeshVertexInput vertexInput = meshVertexInput(state->config->vertexLayout);
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-		.vertexBindingDescriptionCount = 1,
-		.pVertexBindingDescriptions = &bindingDescription,
-		.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
-		.pVertexAttributeDescriptions = attributeDescriptions.data(),
+		.vertexBindingDescriptionCount = (uint32_t)vertexInput.bindings.size(),
+		.pVertexBindingDescriptions = vertexInput.bindings.data(),
+		.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexInput.attributes.size()),
+		.pVertexAttributeDescriptions = vertexInput.attributes.data(),
 	};
 
 	// Input assembly
@@ -7,6 +7,10 @@ struct State;
 //Compute Pipelines
 void iblPipelineCreate(State* state);
 void brdfLutPipelineCreate(State* state);
+void skinPipelineCreate(State* state);
+void skinPipelineDestroy(State* state);
+void morphPipelineCreate(State* state);
+void morphPipelineDestroy(State* state);
 //Graphics Pipelines
 void skyboxPipelineCreate(State* state);
 void skyboxPipelineDestroy(State * state);
@@ -10,8 +10,12 @@
 
 void drawMesh(State* state, VkCommandBuffer cmd,
 	const Mesh* mesh,
+	VkBuffer vertexBuffer,
 	const glm::mat4& nodeMatrix,
 	const glm::mat4& modelTransform,
+	VkBuffer instanceBuffer,
+	uint32_t firstInstance,
+	uint32_t instanceCount,
 	VkPipelineLayout layout)
 {
 	const Material* mat = state->scene->materials[mesh->materialIndex];
@@ -51,6 +55,13 @@ void drawMesh(State* state, VkCommandBuffer cmd,
 	pcb.thicknessTexCoordIndex = mat->thicknessTexCoordIndex;
 	pcb.attenuation = mat->attenuationColor;
 	pcb.attenuation.w = mat->attenuationDistance;
+	if (state->config->vertexLayout == VertexLayout::CompactQuantized) {
+		pcb.posOffset = glm::vec4(mesh->minBounds, 0.0f);
+		pcb.posScale = glm::vec4(mesh->maxBounds - mesh->minBounds, 0.0f);
+	}
+	else {
+		pcb.posScale = glm::vec4(1.0f);
+	}
 
 
 
@@ -63,10 +74,11 @@ void drawMesh(State* state, VkCommandBuffer cmd,
 		&pcb
 	);
 
-	// Bind vertex + index buffers
-	VkDeviceSize offsets[] = { 0 };
-	vkCmdBindVertexBuffers(cmd, 0, 1, &mesh->vertexBuffer, offsets);
-	vkCmdBindIndexBuffer(cmd, mesh->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	// Bind vertex + instance + index buffers
+	VkBuffer vertexBuffers[] = { vertexBuffer, instanceBuffer };
+	VkDeviceSize offsets[] = { 0, 0 };
+	vkCmdBindVertexBuffers(cmd, 0, 2, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(cmd, mesh->indexBuffer, 0, mesh->indexType);
 
-	vkCmdDrawIndexed(cmd, mesh->indices.size(), 1, 0, 0, 0);
+	vkCmdDrawIndexed(cmd, mesh->indexCount, instanceCount, 0, 0, firstInstance);
 }
\ No newline at end of file
@@ -35,6 +35,9 @@ struct Renderer {
 	VkDescriptorSetLayout iblSetLayout;
 	std::vector<VkDescriptorSet> iblSets;
 	
+	VkDescriptorSetLayout skinSetLayout;
+	VkDescriptorSetLayout morphSetLayout;
+
 	VkDescriptorPool lutDescriptorPool;
 	VkDescriptorSetLayout lutSetLayout;
 	VkDescriptorSet lutSet;
@@ -58,6 +61,10 @@ struct Renderer {
 	VkBuffer skyboxVbo;
 	VkDeviceMemory skyboxVboMemory;
 
+	// Single identity transform bound as the instance stream of uninstanced draws
+	VkBuffer identityInstanceBuffer;
+	VkDeviceMemory identityInstanceMemory;
+
 
 	//Shaders
 	VkShaderModule vertShaderModule;
@@ -83,6 +90,11 @@ struct Renderer {
 	VkPipeline lutPipeline;
 	VkPipelineLayout lutPipelineLayout;
 
+	VkPipeline skinPipeline;
+	VkPipelineLayout skinPipelineLayout;
+	VkPipeline morphPipeline;
+	VkPipelineLayout morphPipelineLayout;
+
 	//opaque Pipeline
 	VkPipeline opaquePipeline;
 	VkPipeline skyboxPipeline;
@@ -104,8 +116,15 @@ struct Renderer {
 
 };
 
+// instanceBuffer holds the per-instance transforms drawn as
+// [firstInstance, firstInstance + instanceCount). vertexBuffer replaces
+// mesh->vertexBuffer for skinned meshes.
 void drawMesh(State* state, VkCommandBuffer cmd,
 	const Mesh* mesh,
+	VkBuffer vertexBuffer,
 	const glm::mat4& nodeMatrix,
 	const glm::mat4& modelTransform,
+	VkBuffer instanceBuffer,
+	uint32_t firstInstance,
+	uint32_t instanceCount,
 	VkPipelineLayout layout);
\ No newline at end of file
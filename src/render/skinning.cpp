@@ -0,0 +1,305 @@
+#include "render/skinning.h"
+#include "render/renderer.h"
+#include "resources/buffers.h"
+#include "scene/model.h"
+#include "scene/scene.h"
+#include "core/context.h"
+#include "core/config.h"
+#include "core/state.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+static constexpr uint32_t GROUP_SIZE = 64;	// local_size_x of skin.comp and morph.comp
+
+struct VertexPushConstants {
+	uint32_t count;			// vertices (skin) or moved vertices (morph)
+	uint32_t vertexWords;
+	uint32_t base;			// paletteBase (skin) or weightBase (morph)
+};
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool skinsMesh(const Model* model, const Node* node, const Mesh* mesh) {
+	return node->skin >= 0 && mesh->skinned && !model->skins[node->skin].joints.empty();
+}
+
+static bool morphsMesh(const Node* node, const Mesh* mesh) {
+	return mesh->morphVertexCount > 0 && node->morphWeights.size() >= mesh->morphTargetCount;
+}
+
+// Pre-order, so draws and palettes follow the node tree
+static void collectDeformedNodes(State* state, Model* model, Node* node, ModelSkinning* skinning) {
+	bool deformed = false;
+	for (const Mesh* mesh : node->meshes)
+		deformed |= skinsMesh(model, node, mesh) || morphsMesh(node, mesh);
+
+	if (deformed) {
+		node->firstSkinnedDraw = (uint32_t)skinning->draws.size();
+		skinning->nodes.push_back(node);
+		skinning->paletteBases.push_back(skinning->jointCount);
+		skinning->weightBases.push_back(skinning->weightCount);
+
+		VkDeviceSize stride = vertexStride(state->config->vertexLayout);
+		for (const Mesh* mesh : node->meshes) {
+			SkinnedDraw draw{ .node = node, .mesh = mesh, .paletteBase = skinning->jointCount, .weightBase = skinning->weightCount };
+			if (skinsMesh(model, node, mesh) || morphsMesh(node, mesh)) {
+				createBuffer(state, mesh->vertexCount * stride,
+					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, draw.output, draw.outputMemory);
+			}
+			skinning->draws.push_back(draw);
+		}
+		if (node->skin >= 0)
+			skinning->jointCount += (uint32_t)model->skins[node->skin].joints.size();
+		skinning->weightCount += (uint32_t)node->morphWeights.size();
+	}
+	for (Node* child : node->children)
+		collectDeformedNodes(state, model, child, skinning);
+}
+
+static VkDescriptorSet allocateSet(State* state, ModelSkinning* skinning, VkDescriptorSetLayout layout) {
+	VkDescriptorSetAllocateInfo allocInfo{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		.descriptorPool = skinning->pool,
+		.descriptorSetCount = 1,
+		.pSetLayouts = &layout,
+	};
+	VkDescriptorSet set;
+	PANIC(vkAllocateDescriptorSets(state->context->device, &allocInfo, &set), "Failed to allocate skinning descriptor set");
+	return set;
+}
+
+// Every binding is a storage buffer except dynamicBinding, the frame slot
+template<size_t N>
+static void writeSet(State* state, VkDescriptorSet set, const std::array<VkDescriptorBufferInfo, N>& buffers, uint32_t dynamicBinding) {
+	std::array<VkWriteDescriptorSet, N> writes{};
+	for (uint32_t i = 0; i < N; i++) {
+		writes[i] = {
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = set,
+			.dstBinding = i,
+			.descriptorCount = 1,
+			.descriptorType = i == dynamicBinding ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.pBufferInfo = &buffers[i],
+		};
+	}
+	vkUpdateDescriptorSets(state->context->device, (uint32_t)N, writes.data(), 0, nullptr);
+}
+
+static void writeDescriptorSets(State* state, const Model* model, ModelSkinning* skinning, SkinnedDraw& draw) {
+	bool morph = morphsMesh(draw.node, draw.mesh);
+	if (morph) {
+		draw.morphSet = allocateSet(state, skinning, state->renderer->morphSetLayout);
+		writeSet<3>(state, draw.morphSet, { {
+			{ draw.output, 0, VK_WHOLE_SIZE },
+			{ draw.mesh->morphBuffer, 0, VK_WHOLE_SIZE },
+			{ skinning->palette, skinning->weightsOffset, skinning->weightCount * sizeof(float) },
+		} }, 2);
+	}
+	if (skinsMesh(model, draw.node, draw.mesh)) {
+		// Morphed meshes are skinned in place, after the morph pass
+		draw.set = allocateSet(state, skinning, state->renderer->skinSetLayout);
+		writeSet<4>(state, draw.set, { {
+			{ morph ? draw.output : draw.mesh->vertexBuffer, 0, VK_WHOLE_SIZE },
+			{ draw.mesh->skinBuffer, 0, VK_WHOLE_SIZE },
+			{ skinning->palette, 0, skinning->jointCount * sizeof(glm::mat4) },
+			{ draw.output, 0, VK_WHOLE_SIZE },
+		} }, 2);
+	}
+}
+
+void skinningCreate(State* state, Model* model) {
+	if (model->skinning || !model->rootNode)
+		return;
+
+	ModelSkinning* skinning = new ModelSkinning{};
+	collectDeformedNodes(state, model, model->rootNode, skinning);
+
+	uint32_t skinSets = 0;
+	uint32_t morphSets = 0;
+	for (const SkinnedDraw& draw : skinning->draws) {
+		skinSets += draw.output && skinsMesh(model, draw.node, draw.mesh);
+		morphSets += draw.output && morphsMesh(draw.node, draw.mesh);
+	}
+	model->skinning = skinning;
+	if (skinSets + morphSets == 0) {
+		skinningDestroy(state, model);
+		return;
+	}
+	if (state->config->vertexLayout == VertexLayout::CompactQuantized) {
+		// Positions are quantized over the bind-pose bounds; deformed
+		// vertices can leave them, so these meshes keep drawing in bind pose
+		printf("skinning: %s drawn in bind pose, quantized vertices are not deformed\n", model->name.c_str());
+		skinningDestroy(state, model);
+		return;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(state->context->physicalDevice, &properties);
+	VkDeviceSize alignment = properties.limits.minStorageBufferOffsetAlignment;
+	skinning->weightsOffset = alignUp((VkDeviceSize)skinning->jointCount * sizeof(glm::mat4), alignment);
+	skinning->frameStride = alignUp(skinning->weightsOffset + skinning->weightCount * sizeof(float), alignment);
+
+	createBuffer(state, skinning->frameStride * state->config->swapchainBuffering, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		skinning->palette, skinning->paletteMemory);
+	vkMapMemory(state->context->device, skinning->paletteMemory, 0, VK_WHOLE_SIZE, 0, &skinning->paletteMapped);
+
+	std::array<VkDescriptorPoolSize, 2> poolSizes{ {
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, skinSets * 3 + morphSets * 2 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, skinSets + morphSets },
+	} };
+	VkDescriptorPoolCreateInfo poolInfo{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		.maxSets = skinSets + morphSets,
+		.poolSizeCount = (uint32_t)poolSizes.size(),
+		.pPoolSizes = poolSizes.data(),
+	};
+	PANIC(vkCreateDescriptorPool(state->context->device, &poolInfo, nullptr, &skinning->pool),
+		"Failed to create skinning descriptor pool");
+
+	for (SkinnedDraw& draw : skinning->draws)
+		if (draw.output)
+			writeDescriptorSets(state, model, skinning, draw);
+}
+
+void skinningDestroy(State* state, Model* model) {
+	ModelSkinning* skinning = model->skinning;
+	if (!skinning)
+		return;
+	VkDevice device = state->context->device;
+	for (const SkinnedDraw& draw : skinning->draws) {
+		if (draw.output) vkDestroyBuffer(device, draw.output, nullptr);
+		if (draw.outputMemory) vkFreeMemory(device, draw.outputMemory, nullptr);
+	}
+	if (skinning->pool) vkDestroyDescriptorPool(device, skinning->pool, nullptr);
+	if (skinning->palette) vkDestroyBuffer(device, skinning->palette, nullptr);
+	if (skinning->paletteMemory) vkFreeMemory(device, skinning->paletteMemory, nullptr);
+	delete skinning;
+	model->skinning = nullptr;
+}
+
+// ─────────────────────────────────────────────
+// Per frame
+// ─────────────────────────────────────────────
+
+// glTF skinned vertices are placed by their joints alone, but shader.vert
+// still applies the node matrix, so the palette cancels it up front.
+static void writeFrameSlot(const Model* model, const ModelSkinning* skinning, unsigned char* slot) {
+	glm::mat4* palette = reinterpret_cast<glm::mat4*>(slot);
+	float* weights = reinterpret_cast<float*>(slot + skinning->weightsOffset);
+	for (size_t n = 0; n < skinning->nodes.size(); n++) {
+		const Node* node = skinning->nodes[n];
+		if (!node->morphWeights.empty())
+			memcpy(weights + skinning->weightBases[n], node->morphWeights.data(), node->morphWeights.size() * sizeof(float));
+		if (node->skin < 0)
+			continue;
+
+		const Skin& skin = model->skins[node->skin];
+		glm::mat4 inverseNode = glm::inverse(node->worldMatrix);
+		glm::mat4* out = palette + skinning->paletteBases[n];
+		for (size_t j = 0; j < skin.joints.size(); j++) {
+			out[j] = skin.joints[j]
+				? inverseNode * skin.joints[j]->worldMatrix * skin.inverseBindMatrices[j]
+				: glm::mat4(1.0f);
+		}
+	}
+}
+
+static void memoryBarrier(VkCommandBuffer cmd, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+	VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+	VkMemoryBarrier barrier{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = srcAccess,
+		.dstAccessMask = dstAccess,
+	};
+	vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+// Three phases over every model, one barrier between each: morphed meshes
+// copy their bind pose into the output, the morph pass adds the weighted
+// deltas of the moved vertices only, then skinning poses the result.
+void skinningRecord(State* state, VkCommandBuffer cmd) {
+	uint32_t frameIndex = state->renderer->frameIndex;
+	uint32_t vertexWords = vertexStride(state->config->vertexLayout) / sizeof(uint32_t);
+	const Renderer* renderer = state->renderer;
+
+	bool any = false;
+	for (const Model* model : state->scene->models) {
+		if (!model->skinning)
+			continue;
+		// This frame's slot was last read by the submission the in-flight
+		// fence just retired
+		const ModelSkinning* skinning = model->skinning;
+		writeFrameSlot(model, skinning, (unsigned char*)skinning->paletteMapped + frameIndex * skinning->frameStride);
+		any = true;
+	}
+	if (!any)
+		return;
+
+	// Last frame's draws may still read the outputs being overwritten
+	memoryBarrier(cmd, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
+
+	for (const Model* model : state->scene->models) {
+		if (!model->skinning)
+			continue;
+		for (const SkinnedDraw& draw : model->skinning->draws) {
+			if (!draw.morphSet)
+				continue;
+			VkBufferCopy copy{ 0, 0, (VkDeviceSize)draw.mesh->vertexCount * vertexWords * sizeof(uint32_t) };
+			vkCmdCopyBuffer(cmd, draw.mesh->vertexBuffer, draw.output, 1, &copy);
+		}
+	}
+	memoryBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, renderer->morphPipeline);
+	for (const Model* model : state->scene->models) {
+		if (!model->skinning)
+			continue;
+		uint32_t slotOffset = (uint32_t)(frameIndex * model->skinning->frameStride);
+		for (const SkinnedDraw& draw : model->skinning->draws) {
+			if (!draw.morphSet)
+				continue;
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, renderer->morphPipelineLayout,
+				0, 1, &draw.morphSet, 1, &slotOffset);
+			VertexPushConstants push{ draw.mesh->morphVertexCount, vertexWords, draw.weightBase };
+			vkCmdPushConstants(cmd, renderer->morphPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+			vkCmdDispatch(cmd, (draw.mesh->morphVertexCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+		}
+	}
+	memoryBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, renderer->skinPipeline);
+	for (const Model* model : state->scene->models) {
+		if (!model->skinning)
+			continue;
+		uint32_t slotOffset = (uint32_t)(frameIndex * model->skinning->frameStride);
+		for (const SkinnedDraw& draw : model->skinning->draws) {
+			if (!draw.set)
+				continue;
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, renderer->skinPipelineLayout,
+				0, 1, &draw.set, 1, &slotOffset);
+			VertexPushConstants push{ draw.mesh->vertexCount, vertexWords, draw.paletteBase };
+			vkCmdPushConstants(cmd, renderer->skinPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+			vkCmdDispatch(cmd, (draw.mesh->vertexCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+		}
+	}
+	memoryBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+}
+
+VkBuffer skinnedVertexBuffer(const Model* model, const Node* node, uint32_t meshIndex) {
+	const Mesh* mesh = node->meshes[meshIndex];
+	if (!model->skinning || model->skinning->nodes.empty())
+		return mesh->vertexBuffer;
+	const SkinnedDraw* draw = nullptr;
+	if (node->firstSkinnedDraw + meshIndex < model->skinning->draws.size())
+		draw = &model->skinning->draws[node->firstSkinnedDraw + meshIndex];
+	return draw && draw->node == node && draw->output ? draw->output : mesh->vertexBuffer;
+}
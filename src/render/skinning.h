@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.h>
+struct State;
+struct Model;
+struct Node;
+struct Mesh;
+
+// One mesh of a skinned or morphed node. Deformed meshes get their own
+// output vertex buffer, so two nodes sharing a mesh under different poses
+// both draw correctly; output stays VK_NULL_HANDLE for meshes the node
+// leaves undeformed.
+struct SkinnedDraw {
+	const Node* node = nullptr;
+	const Mesh* mesh = nullptr;
+	uint32_t paletteBase = 0;	// first joint of the node's palette
+	uint32_t weightBase = 0;	// first morph weight of the node
+	VkBuffer output = VK_NULL_HANDLE;
+	VkDeviceMemory outputMemory = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;		// skinning pass, null if not skinned
+	VkDescriptorSet morphSet = VK_NULL_HANDLE;	// morph pass, null if not morphed
+};
+
+// GPU side of a model's skins and morph targets. Every deformed node owns
+// jointCount matrices of the palette and its morph weights; each frame in
+// flight has its own slot holding all palettes, then all weights.
+struct ModelSkinning {
+	std::vector<SkinnedDraw> draws;		// Node::firstSkinnedDraw indexes this
+	std::vector<const Node*> nodes;
+	std::vector<uint32_t> paletteBases;
+	std::vector<uint32_t> weightBases;
+	uint32_t jointCount = 0;
+	uint32_t weightCount = 0;
+	VkDeviceSize weightsOffset = 0;		// within a frame slot, offset-aligned
+	VkDeviceSize frameStride = 0;		// frame slot bytes, offset-aligned
+	VkBuffer palette = VK_NULL_HANDLE;
+	VkDeviceMemory paletteMemory = VK_NULL_HANDLE;
+	void* paletteMapped = nullptr;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+};
+
+// Builds model->skinning once the mesh buffers exist; no-op for models
+// without skinned or morphed nodes.
+void skinningCreate(State* state, Model* model);
+void skinningDestroy(State* state, Model* model);
+
+// Writes this frame's joint palettes and morph weights and records the
+// morph and skinning dispatches of every model; call before the first
+// render pass of the frame.
+void skinningRecord(State* state, VkCommandBuffer cmd);
+
+// Vertex buffer to draw meshes[meshIndex] of node from: the deformed output
+// where there is one, the mesh's own buffer otherwise.
+VkBuffer skinnedVertexBuffer(const Model* model, const Node* node, uint32_t meshIndex);
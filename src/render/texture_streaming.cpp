@@ -0,0 +1,491 @@
+#include "render/texture_streaming.h"
+#include "render/descriptors.h"
+#include "render/renderer.h"
+#include "loader/gltf_textures.h"
+#include "loader/runepak.h"
+#include "resources/buffers.h"
+#include "scene/camera.h"
+#include "scene/gather.h"
+#include "scene/materials.h"
+#include "scene/mesh.h"
+#include "scene/scene.h"
+#include "scene/texture.h"
+#include "core/config.h"
+#include "core/context.h"
+#include "core/state.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// Largest level textures start resident with, and stay down to when evicted
+static constexpr uint32_t TAIL_SIZE = 64;
+// Sample one level coarser than the projected size asks for; the estimate
+// assumes a mesh maps its texture once
+static constexpr float MIP_BIAS = 1.0f;
+static constexpr uint32_t MAX_TRANSITIONS = 4;
+// Upload bytes started per update, so a camera cut spreads over frames
+static constexpr VkDeviceSize UPDATE_UPLOAD_BYTES = 16ull << 20;
+static constexpr uint32_t SETS_PER_POOL = 64;
+
+// Bytes of levels [mip, mipLevels)
+static VkDeviceSize chainBytes(const TextureStream* stream, uint32_t mip) {
+	const MipLevel& last = stream->levels.back();
+	return last.offset + last.size - stream->levels[mip].offset;
+}
+
+static void retireTransition(State* state, StreamTransition& t) {
+	VkDevice device = state->context->device;
+	vkFreeCommandBuffers(device, state->renderer->commandPool, 1, &t.cmd);
+	vkDestroyFence(device, t.fence, nullptr);
+	if (t.staging) vkDestroyBuffer(device, t.staging, nullptr);
+	if (t.stagingMemory) vkFreeMemory(device, t.stagingMemory, nullptr);
+}
+
+static void destroyTransitionImage(VkDevice device, StreamTransition& t) {
+	vkDestroySampler(device, t.sampler, nullptr);
+	vkDestroyImageView(device, t.view, nullptr);
+	vkDestroyImage(device, t.image, nullptr);
+	vkFreeMemory(device, t.memory, nullptr);
+}
+
+static void destroyRetired(State* state, StreamRetired& r) {
+	VkDevice device = state->context->device;
+	if (r.sampler) vkDestroySampler(device, r.sampler, nullptr);
+	if (r.view) vkDestroyImageView(device, r.view, nullptr);
+	if (r.image) vkDestroyImage(device, r.image, nullptr);
+	if (r.memory) vkFreeMemory(device, r.memory, nullptr);
+	if (r.set && r.pool) vkFreeDescriptorSets(device, r.pool, 1, &r.set);
+}
+
+void textureStreamerCreate(State* state) {
+	state->streamer = new TextureStreamer{};
+}
+
+void textureStreamerDestroy(State* state) {
+	TextureStreamer* streamer = state->streamer;
+	VkDevice device = state->context->device;
+
+	for (StreamTransition& t : streamer->inFlight) {
+		destroyTransitionImage(device, t);
+		retireTransition(state, t);
+	}
+	for (StreamRetired& r : streamer->retired)
+		destroyRetired(state, r);
+	// Sets still bound to materials go with their pools
+	for (VkDescriptorPool pool : streamer->setPools)
+		vkDestroyDescriptorPool(device, pool, nullptr);
+	for (TextureStream* stream : streamer->streams) {
+		stream->texture->stream = nullptr;
+		delete stream;
+	}
+
+	delete streamer;
+	state->streamer = nullptr;
+}
+
+// ─────────────────────────────────────────────
+// Loading
+// ─────────────────────────────────────────────
+TextureStream* textureStreamCreate(State* state, const RunePakTexture& record, std::shared_ptr<const MappedFile> package) {
+	if (state->config->textureBudget == 0)
+		return nullptr;
+
+	std::vector<MipLevel> levels = textureChainLayout((VkFormat)record.format, record.width, record.height, record.mipLevels);
+	uint32_t tail = 0;
+	while (tail + 1 < levels.size() && std::max(levels[tail].width, levels[tail].height) > TAIL_SIZE)
+		tail++;
+	if (tail == 0)
+		return nullptr;
+
+	TextureStream* stream = new TextureStream{};
+	stream->package = std::move(package);
+	stream->dataOffset = record.dataOffset;
+	stream->levels = std::move(levels);
+	stream->tailMip = tail;
+	stream->residentMip = tail;
+	return stream;
+}
+
+std::shared_ptr<const MappedFile> textureStreamPackage(MappedFile& file) {
+	std::shared_ptr<const MappedFile> package(new MappedFile(file), [](const MappedFile* mapped) {
+		MappedFile owned = *mapped;
+		fileMapClose(owned);
+		delete mapped;
+	});
+	file = MappedFile{};
+	return package;
+}
+
+std::vector<MipLevel> textureChainFrom(const RunePakTexture& record, uint32_t first, size_t& firstOffset) {
+	std::vector<MipLevel> levels = textureChainLayout((VkFormat)record.format, record.width, record.height, record.mipLevels);
+	firstOffset = levels[first].offset;
+	levels.erase(levels.begin(), levels.begin() + first);
+	for (MipLevel& level : levels)
+		level.offset -= firstOffset;
+	return levels;
+}
+
+void textureStreamTrack(State* state, Texture* tex) {
+	TextureStreamer* streamer = state->streamer;
+	tex->stream->texture = tex;
+	tex->stream->lastUsed = streamer->frame;
+	streamer->streams.push_back(tex->stream);
+	streamer->residentBytes += chainBytes(tex->stream, tex->stream->residentMip);
+}
+
+void textureStreamRelease(State* state, Texture* tex) {
+	TextureStream* stream = tex->stream;
+	if (!stream)
+		return;
+	tex->stream = nullptr;
+
+	// Untracked streams belong to uploads that never reached the scene,
+	// possibly discarded on a worker
+	TextureStreamer* streamer = state->streamer;
+	if (!streamer || !stream->texture) {
+		delete stream;
+		return;
+	}
+
+	auto tracked = std::find(streamer->streams.begin(), streamer->streams.end(), stream);
+	if (tracked != streamer->streams.end()) {
+		streamer->streams.erase(tracked);
+		uint32_t mip = stream->residentMip;
+		for (size_t i = 0; i < streamer->inFlight.size(); i++) {
+			StreamTransition& t = streamer->inFlight[i];
+			if (t.stream != stream)
+				continue;
+			vkWaitForFences(state->context->device, 1, &t.fence, VK_TRUE, UINT64_MAX);
+			mip = t.targetMip;
+			destroyTransitionImage(state->context->device, t);
+			retireTransition(state, t);
+			streamer->inFlight.erase(streamer->inFlight.begin() + i);
+			break;
+		}
+		streamer->residentBytes -= chainBytes(stream, mip);
+	}
+	delete stream;
+}
+
+// ─────────────────────────────────────────────
+// Feedback
+// ─────────────────────────────────────────────
+static void requestLevel(State* state, int textureIndex, float pixels) {
+	if (textureIndex < 0 || textureIndex >= (int)state->scene->textures.size())
+		return;
+	TextureStream* stream = state->scene->textures[textureIndex]->stream;
+	if (!stream)
+		return;
+
+	const MipLevel& top = stream->levels[0];
+	float texels = (float)std::max(top.width, top.height);
+	float level = std::floor(std::log2(std::max(texels / std::max(pixels, 1.0f), 1.0f)) + MIP_BIAS);
+	uint32_t mip = std::min((uint32_t)level, (uint32_t)stream->levels.size() - 1);
+	stream->wantedMip = std::min(stream->wantedMip, mip);
+	stream->lastUsed = state->streamer->frame;
+}
+
+void textureStreamingRequest(State* state, const std::vector<DrawItem>& items) {
+	if (!state->streamer || state->streamer->streams.empty())
+		return;
+
+	float tanHalfFov = std::tan(glm::radians(state->scene->camera->getZoom()) * 0.5f);
+	float height = (float)state->window.swapchain.imageExtent.height;
+	for (const DrawItem& item : items) {
+		// Diameter on screen; a camera inside the bounds gets the finest level
+		float pixels = item.distanceToCamera > item.boundingRadius
+			? item.boundingRadius / (item.distanceToCamera * tanHalfFov) * height
+			: std::numeric_limits<float>::max();
+
+		const Material* mat = state->scene->materials[item.mesh->materialIndex];
+		for (int index : { mat->baseColorTextureIndex, mat->metallicRoughnessTextureIndex, mat->normalTextureIndex,
+			mat->occlusionTextureIndex, mat->emissiveTextureIndex, mat->transmissionTextureIndex, mat->thicknessTextureIndex })
+			requestLevel(state, index, pixels);
+	}
+}
+
+// ─────────────────────────────────────────────
+// Residency changes
+// ─────────────────────────────────────────────
+static VkDescriptorSet allocateMaterialSet(State* state, VkDescriptorPool& outPool) {
+	TextureStreamer* streamer = state->streamer;
+	VkDescriptorSetAllocateInfo allocInfo{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		.descriptorSetCount = 1,
+		.pSetLayouts = &state->renderer->materialSetLayout,
+	};
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	for (VkDescriptorPool pool : streamer->setPools) {
+		allocInfo.descriptorPool = pool;
+		if (vkAllocateDescriptorSets(state->context->device, &allocInfo, &set) == VK_SUCCESS) {
+			outPool = pool;
+			return set;
+		}
+	}
+
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	materialDescriptorPoolCreateFor(state, SETS_PER_POOL, pool, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+	streamer->setPools.push_back(pool);
+	allocInfo.descriptorPool = pool;
+	PANIC(vkAllocateDescriptorSets(state->context->device, &allocInfo, &set), "Failed to allocate streamed material descriptor set");
+	outPool = pool;
+	return set;
+}
+
+// Points every material sampling tex at its current image through a new set
+static void rebindMaterials(State* state, const Texture* tex) {
+	TextureStreamer* streamer = state->streamer;
+	Scene* scene = state->scene;
+	int index = (int)(std::find(scene->textures.begin(), scene->textures.end(), tex) - scene->textures.begin());
+
+	for (Material* mat : scene->materials) {
+		if (!mat->descriptorSet ||
+			(mat->baseColorTextureIndex != index && mat->metallicRoughnessTextureIndex != index &&
+			mat->normalTextureIndex != index && mat->occlusionTextureIndex != index &&
+			mat->emissiveTextureIndex != index && mat->transmissionTextureIndex != index &&
+			mat->thicknessTextureIndex != index))
+			continue;
+
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		VkDescriptorSet set = allocateMaterialSet(state, pool);
+		materialSetUpdate(state, mat, set);
+
+		// Sets from the loader's pools cannot be freed one by one
+		StreamRetired old{ .set = mat->descriptorSet, .updates = state->config->swapchainBuffering + 1 };
+		auto owned = streamer->ownedSets.find(mat->descriptorSet);
+		if (owned != streamer->ownedSets.end()) {
+			old.pool = owned->second;
+			streamer->ownedSets.erase(owned);
+		}
+		streamer->retired.push_back(old);
+		streamer->ownedSets[set] = pool;
+		mat->descriptorSet = set;
+	}
+}
+
+// Copies the levels both images hold on the GPU and uploads the finer ones
+// from the package, on the graphics queue so the old image needs no
+// ownership transfer.
+static void startTransition(State* state, TextureStream* stream, uint32_t target) {
+	TextureStreamer* streamer = state->streamer;
+	VkDevice device = state->context->device;
+	Texture* tex = stream->texture;
+	uint32_t mipLevels = (uint32_t)stream->levels.size();
+	const MipLevel& top = stream->levels[target];
+
+	Texture fresh{};
+	createTextureForLevels(state, tex->format, top.width, top.height, mipLevels - target, fresh);
+	StreamTransition t{
+		.stream = stream,
+		.targetMip = target,
+		.image = fresh.textureImage,
+		.memory = fresh.textureImageMemory,
+		.view = fresh.textureImageView,
+		.sampler = fresh.textureSampler,
+	};
+
+	if (target < stream->residentMip) {
+		VkDeviceSize bytes = stream->levels[stream->residentMip].offset - top.offset;
+		createBuffer(state, bytes,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			t.staging, t.stagingMemory);
+		void* mapped = nullptr;
+		vkMapMemory(device, t.stagingMemory, 0, bytes, 0, &mapped);
+		memcpy(mapped, stream->package->data + stream->dataOffset + top.offset, (size_t)bytes);
+		vkUnmapMemory(device, t.stagingMemory);
+	}
+
+	VkCommandBufferAllocateInfo allocInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		.commandPool = state->renderer->commandPool,
+		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		.commandBufferCount = 1,
+	};
+	PANIC(vkAllocateCommandBuffers(device, &allocInfo, &t.cmd), "Failed To Allocate Streaming Command Buffer");
+	VkCommandBufferBeginInfo beginInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+	};
+	vkBeginCommandBuffer(t.cmd, &beginInfo);
+
+	// Frames submitted earlier may still sample the old image
+	std::array<VkImageMemoryBarrier, 2> toTransfer{
+		VkImageMemoryBarrier{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = 0,
+			.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = t.image,
+			.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels - target, 0, 1 },
+		},
+		VkImageMemoryBarrier{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+			.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+			.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = tex->textureImage,
+			.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, tex->mipLevels, 0, 1 },
+		},
+	};
+	vkCmdPipelineBarrier(t.cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, (uint32_t)toTransfer.size(), toTransfer.data());
+
+	std::vector<VkImageCopy> copies;
+	for (uint32_t level = std::max(target, stream->residentMip); level < mipLevels; level++) {
+		copies.push_back(VkImageCopy{
+			.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - stream->residentMip, 0, 1 },
+			.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - target, 0, 1 },
+			.extent = { stream->levels[level].width, stream->levels[level].height, 1 },
+		});
+	}
+	vkCmdCopyImage(t.cmd, tex->textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		t.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)copies.size(), copies.data());
+
+	if (t.staging) {
+		std::vector<MipLevel> upload(stream->levels.begin() + target, stream->levels.begin() + stream->residentMip);
+		for (MipLevel& level : upload)
+			level.offset -= top.offset;
+		std::vector<VkBufferImageCopy> regions = mipCopyRegions(upload, 0);
+		vkCmdCopyBufferToImage(t.cmd, t.staging, t.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			(uint32_t)regions.size(), regions.data());
+	}
+
+	std::array<VkImageMemoryBarrier, 2> toShader = toTransfer;
+	for (VkImageMemoryBarrier& b : toShader) {
+		b.srcAccessMask = b.dstAccessMask;
+		b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		b.oldLayout = b.newLayout;
+		b.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
+	vkCmdPipelineBarrier(t.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, (uint32_t)toShader.size(), toShader.data());
+	PANIC(vkEndCommandBuffer(t.cmd), "Failed To Record Streaming Command Buffer");
+
+	VkFenceCreateInfo fenceInfo{ .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	PANIC(vkCreateFence(device, &fenceInfo, nullptr, &t.fence), "Failed To Create Streaming Fence");
+	VkSubmitInfo submitInfo{
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.commandBufferCount = 1,
+		.pCommandBuffers = &t.cmd,
+	};
+	PANIC(vkQueueSubmit(state->context->queue, 1, &submitInfo, t.fence), "Failed To Submit Streaming Commands");
+
+	streamer->residentBytes += chainBytes(stream, target);
+	streamer->residentBytes -= chainBytes(stream, stream->residentMip);
+	stream->busy = true;
+	streamer->inFlight.push_back(t);
+}
+
+static void finishTransitions(State* state) {
+	TextureStreamer* streamer = state->streamer;
+	for (size_t i = 0; i < streamer->inFlight.size(); ) {
+		StreamTransition& t = streamer->inFlight[i];
+		if (vkGetFenceStatus(state->context->device, t.fence) != VK_SUCCESS) {
+			i++;
+			continue;
+		}
+
+		TextureStream* stream = t.stream;
+		Texture* tex = stream->texture;
+		streamer->retired.push_back(StreamRetired{
+			.image = tex->textureImage,
+			.memory = tex->textureImageMemory,
+			.view = tex->textureImageView,
+			.sampler = tex->textureSampler,
+			.updates = state->config->swapchainBuffering + 1,
+		});
+		tex->textureImage = t.image;
+		tex->textureImageMemory = t.memory;
+		tex->textureImageView = t.view;
+		tex->textureSampler = t.sampler;
+		tex->mipLevels = (uint32_t)stream->levels.size() - t.targetMip;
+		stream->residentMip = t.targetMip;
+		stream->busy = false;
+		rebindMaterials(state, tex);
+
+		retireTransition(state, t);
+		streamer->inFlight.erase(streamer->inFlight.begin() + i);
+	}
+
+	for (size_t i = 0; i < streamer->retired.size(); ) {
+		if (--streamer->retired[i].updates > 0) {
+			i++;
+			continue;
+		}
+		destroyRetired(state, streamer->retired[i]);
+		streamer->retired.erase(streamer->retired.begin() + i);
+	}
+}
+
+// Drops the least recently drawn textures to their tail, and drawn ones to
+// what they were last drawn at, until bytes more fit. Never touches keep.
+static bool makeRoom(State* state, VkDeviceSize bytes, const TextureStream* keep) {
+	TextureStreamer* streamer = state->streamer;
+	VkDeviceSize budget = state->config->textureBudget;
+	if (streamer->residentBytes + bytes <= budget)
+		return true;
+
+	std::vector<TextureStream*> candidates;
+	for (TextureStream* stream : streamer->streams) {
+		if (stream != keep && !stream->busy && stream->residentMip < stream->tailMip &&
+			(stream->lastUsed < streamer->frame || stream->wantedMip > stream->residentMip))
+			candidates.push_back(stream);
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const TextureStream* a, const TextureStream* b) {
+		return a->lastUsed < b->lastUsed;
+	});
+
+	for (TextureStream* stream : candidates) {
+		uint32_t target = stream->lastUsed < streamer->frame ? stream->tailMip : std::min(stream->wantedMip, stream->tailMip);
+		startTransition(state, stream, target);
+		if (streamer->residentBytes + bytes <= budget)
+			return true;
+	}
+	return false;
+}
+
+void textureStreamingUpdate(State* state) {
+	TextureStreamer* streamer = state->streamer;
+	if (!streamer)
+		return;
+	finishTransitions(state);
+
+	// Biggest shortfall first
+	std::vector<TextureStream*> wanted;
+	for (TextureStream* stream : streamer->streams) {
+		if (!stream->busy && stream->lastUsed == streamer->frame && stream->wantedMip < stream->residentMip)
+			wanted.push_back(stream);
+	}
+	std::sort(wanted.begin(), wanted.end(), [](const TextureStream* a, const TextureStream* b) {
+		return a->residentMip - a->wantedMip > b->residentMip - b->wantedMip;
+	});
+
+	VkDeviceSize uploaded = 0;
+	for (TextureStream* stream : wanted) {
+		if (streamer->inFlight.size() >= MAX_TRANSITIONS || uploaded >= UPDATE_UPLOAD_BYTES)
+			break;
+		// The finest level that fits, if not the one asked for
+		for (uint32_t target = stream->wantedMip; target < stream->residentMip; target++) {
+			VkDeviceSize growth = chainBytes(stream, target) - chainBytes(stream, stream->residentMip);
+			if (!makeRoom(state, growth, stream))
+				continue;
+			startTransition(state, stream, target);
+			uploaded += growth;
+			break;
+		}
+	}
+
+	// Feedback from the frame recorded next
+	for (TextureStream* stream : streamer->streams)
+		stream->wantedMip = UINT32_MAX;
+	streamer->frame++;
+}
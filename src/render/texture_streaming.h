@@ -0,0 +1,97 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+#include "core/file_map.h"
+#include "resources/mipmaps.h"
+struct State;
+struct Texture;
+struct DrawItem;
+struct RunePakTexture;
+
+// Mip residency of a packaged texture. Its image holds only levels
+// [residentMip, mipLevels) of the full chain; finer levels are read back
+// from the package mapping when draws need them, and dropped again when
+// the budget needs the memory.
+struct TextureStream {
+	Texture* texture = nullptr;
+	std::shared_ptr<const MappedFile> package;	// kept mapped; a recook replaces the file, see fileReplace
+	uint64_t dataOffset = 0;		// of level 0 in the package
+	std::vector<MipLevel> levels;	// full chain, textureChainLayout
+	uint32_t tailMip = 0;			// coarsest residency, never evicted
+	uint32_t residentMip = 0;
+	uint32_t wantedMip = UINT32_MAX;	// finest level drawn since the last update
+	uint64_t lastUsed = 0;			// update that last saw it drawn
+	bool busy = false;				// a residency change is in flight
+};
+
+// A residency change: the image that replaces the texture's once the
+// commands filling it have run.
+struct StreamTransition {
+	TextureStream* stream = nullptr;
+	uint32_t targetMip = 0;
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkImageView view = VK_NULL_HANDLE;
+	VkSampler sampler = VK_NULL_HANDLE;
+	VkBuffer staging = VK_NULL_HANDLE;
+	VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+	VkCommandBuffer cmd = VK_NULL_HANDLE;
+	VkFence fence = VK_NULL_HANDLE;
+};
+
+// Replaced images and material sets, kept until no frame in flight uses them
+struct StreamRetired {
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkImageView view = VK_NULL_HANDLE;
+	VkSampler sampler = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;	// set's, when the streamer allocated it
+	uint32_t updates = 0;	// left before destruction
+};
+
+struct TextureStreamer {
+	std::vector<TextureStream*> streams;
+	std::vector<StreamTransition> inFlight;
+	std::vector<StreamRetired> retired;
+	// Material sets are reallocated, not rewritten, when a texture changes;
+	// frames in flight may still be bound to the old one
+	std::vector<VkDescriptorPool> setPools;
+	std::unordered_map<VkDescriptorSet, VkDescriptorPool> ownedSets;
+	VkDeviceSize residentBytes = 0;	// of every stream once in-flight changes land
+	uint64_t frame = 0;
+};
+
+void textureStreamerCreate(State* state);
+// Call after vkDeviceWaitIdle and before the scene's textures are destroyed.
+void textureStreamerDestroy(State* state);
+
+// Residency for a texture about to be created from a package record, or
+// null when it is loaded whole (streaming disabled, or a chain no larger
+// than the initial tail). Thread-safe; the stream is not tracked yet.
+TextureStream* textureStreamCreate(State* state, const RunePakTexture& record, std::shared_ptr<const MappedFile> package);
+// Takes over a package mapping for the streams of its textures; file is
+// left closed.
+std::shared_ptr<const MappedFile> textureStreamPackage(MappedFile& file);
+// Layout of levels [first, mipLevels) of a packaged chain relative to
+// level first, which starts firstOffset bytes into the chain.
+std::vector<MipLevel> textureChainFrom(const RunePakTexture& record, uint32_t first, size_t& firstOffset);
+
+// Starts managing tex->stream once tex is in the scene. Main thread.
+void textureStreamTrack(State* state, Texture* tex);
+// Before tex is destroyed; waits for a residency change still reading its
+// image. No-op for textures that do not stream.
+void textureStreamRelease(State* state, Texture* tex);
+
+// CPU feedback from the frame's draw list: the finest level each streamed
+// texture is sampled at, from the projected size of the meshes using it.
+void textureStreamingRequest(State* state, const std::vector<DrawItem>& items);
+
+// Frame-boundary step on the main thread: swaps in finished images and
+// their material sets, then starts uploads of requested levels, evicting
+// the least recently drawn textures down to their tail when the budget is
+// full. Never blocks on the GPU.
+void textureStreamingUpdate(State* state);
@@ -0,0 +1,189 @@
+#include "resources/animation_pack.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+// Longest run of keys one kept segment may replace. Checking a segment is
+// quadratic in its length; constant tracks are collapsed separately.
+static constexpr uint32_t MAX_SEGMENT_KEYS = 256;
+
+static float pathTolerance(AnimationTrack::Path path, const AnimationTolerance& tolerance) {
+	switch (path) {
+	case AnimationTrack::TRANSLATION: return tolerance.translation;
+	case AnimationTrack::ROTATION: return tolerance.rotation;
+	case AnimationTrack::SCALE: return tolerance.scale;
+	default: return tolerance.weight;
+	}
+}
+
+// Angle between rotations, distance between anything else
+static float keyError(AnimationTrack::Path path, const glm::vec4& a, const glm::vec4& b) {
+	if (path == AnimationTrack::ROTATION) {
+		float d = std::min(1.0f, std::abs(glm::dot(glm::normalize(a), glm::normalize(b))));
+		return 2.0f * std::acos(d);
+	}
+	return glm::length(a - b);
+}
+
+// What evaluation reconstructs between two kept keys
+static glm::vec4 interpolate(AnimationTrack::Path path, const glm::vec4& a, const glm::vec4& b, float t) {
+	if (path == AnimationTrack::ROTATION) {
+		glm::vec4 to = glm::dot(a, b) < 0.0f ? -b : b;
+		return glm::normalize(a + (to - a) * t);
+	}
+	return a + (b - a) * t;
+}
+
+static bool segmentFits(const RawAnimationTrack& raw, uint32_t a, uint32_t b, float tolerance) {
+	float span = raw.times[b] - raw.times[a];
+	if (span <= 0.0f)
+		return false;
+	for (uint32_t i = a + 1; i < b; i++) {
+		float t = (raw.times[i] - raw.times[a]) / span;
+		if (keyError(raw.track.path, interpolate(raw.track.path, raw.values[a], raw.values[b], t), raw.values[i]) > tolerance)
+			return false;
+	}
+	return true;
+}
+
+// Indices of the keys that survive reduction. CUBICSPLINE tangents depend
+// on the key spans, so those tracks keep every key.
+static std::vector<uint32_t> keptKeys(const RawAnimationTrack& raw, float tolerance) {
+	uint32_t count = (uint32_t)raw.times.size();
+	std::vector<uint32_t> kept;
+	if (raw.track.interpolation == AnimationTrack::CUBICSPLINE || count <= 2 || tolerance <= 0.0f) {
+		for (uint32_t i = 0; i < count; i++)
+			kept.push_back(i);
+		return kept;
+	}
+
+	kept.push_back(0);
+	bool constant = std::all_of(raw.values.begin(), raw.values.end(),
+		[&](const glm::vec4& v) { return keyError(raw.track.path, raw.values[0], v) <= tolerance; });
+	if (constant)
+		return kept;
+
+	if (raw.track.interpolation == AnimationTrack::STEP) {
+		// A step key is redundant when it holds the value already held
+		for (uint32_t i = 1; i < count; i++) {
+			if (keyError(raw.track.path, raw.values[kept.back()], raw.values[i]) > tolerance)
+				kept.push_back(i);
+		}
+		return kept;
+	}
+
+	// Greedy: extend each segment while every key it skips stays in tolerance
+	uint32_t a = 0;
+	while (a + 1 < count) {
+		uint32_t b = a + 1;
+		while (b + 1 < count && b + 1 - a <= MAX_SEGMENT_KEYS && segmentFits(raw, a, b + 1, tolerance))
+			b++;
+		kept.push_back(b);
+		a = b;
+	}
+	return kept;
+}
+
+void packQuaternion(glm::vec4 q, uint16_t* words) {
+	float length = glm::length(q);
+	q = length > 0.0f ? q / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	int largest = 0;
+	for (int c = 1; c < 4; c++) {
+		if (std::abs(q[c]) > std::abs(q[largest]))
+			largest = c;
+	}
+	// q and -q are the same rotation; a positive largest needs no sign bit
+	if (q[largest] < 0.0f)
+		q = -q;
+
+	for (int c = 0, s = 0; c < 4; c++) {
+		if (c == largest)
+			continue;
+		float v = std::clamp(q[c], -0.70710678f, 0.70710678f) + 0.70710678f;
+		words[s++] = (uint16_t)std::lround(v * (32767.0f / 1.41421356f));
+	}
+	words[0] |= (uint16_t)((largest & 1) << 15);
+	words[1] |= (uint16_t)((largest >> 1) << 15);
+}
+
+static void packRange(AnimationTrack& track, const std::vector<glm::vec4>& values, uint32_t components, std::vector<uint16_t>& out) {
+	glm::vec4 minValue(std::numeric_limits<float>::max());
+	glm::vec4 maxValue(std::numeric_limits<float>::lowest());
+	for (const glm::vec4& v : values) {
+		minValue = glm::min(minValue, v);
+		maxValue = glm::max(maxValue, v);
+	}
+	track.rangeMin = glm::vec4(0.0f);
+	track.rangeExtent = glm::vec4(0.0f);
+	for (uint32_t c = 0; c < components; c++) {
+		track.rangeMin[(int)c] = minValue[(int)c];
+		track.rangeExtent[(int)c] = maxValue[(int)c] - minValue[(int)c];
+	}
+
+	for (const glm::vec4& v : values) {
+		for (uint32_t c = 0; c < components; c++) {
+			float extent = track.rangeExtent[(int)c];
+			float unit = extent > 0.0f ? std::clamp((v[(int)c] - track.rangeMin[(int)c]) / extent, 0.0f, 1.0f) : 0.0f;
+			out.push_back((uint16_t)std::lround(unit * 65535.0f));
+		}
+	}
+}
+
+void packAnimation(Animation& animation, const std::vector<RawAnimationTrack>& tracks, const AnimationTolerance& tolerance) {
+	animation.tracks.clear();
+	animation.times.clear();
+	animation.values.clear();
+	for (const RawAnimationTrack& raw : tracks) {
+		if (raw.times.empty())
+			continue;
+		animation.start = std::min(animation.start, raw.times.front());
+		animation.end = std::max(animation.end, raw.times.back());
+	}
+	float length = animation.end - animation.start;
+	float timeScale = length > 0.0f ? 65535.0f / length : 0.0f;
+
+	// Channels sharing a glTF input often reduce to the same key times;
+	// each distinct list is stored once
+	std::map<std::vector<uint16_t>, uint32_t> timeLists;
+
+	for (const RawAnimationTrack& raw : tracks) {
+		if (raw.times.empty())
+			continue;
+		AnimationTrack track = raw.track;
+		std::vector<uint32_t> keys = keptKeys(raw, pathTolerance(track.path, tolerance));
+		track.keyCount = (uint32_t)keys.size();
+
+		std::vector<uint16_t> times;
+		times.reserve(keys.size());
+		for (uint32_t k : keys) {
+			float unit = std::clamp((raw.times[k] - animation.start) * timeScale, 0.0f, 65535.0f);
+			times.push_back((uint16_t)std::lround(unit));
+		}
+		auto [list, inserted] = timeLists.try_emplace(times, (uint32_t)animation.times.size());
+		if (inserted)
+			animation.times.insert(animation.times.end(), times.begin(), times.end());
+		track.firstKey = list->second;
+
+		uint32_t valuesPerKey = track.interpolation == AnimationTrack::CUBICSPLINE ? 3 : 1;
+		std::vector<glm::vec4> values;
+		values.reserve(keys.size() * valuesPerKey);
+		for (uint32_t k : keys) {
+			for (uint32_t v = 0; v < valuesPerKey; v++)
+				values.push_back(raw.values[k * valuesPerKey + v]);
+		}
+
+		track.firstValue = (uint32_t)animation.values.size();
+		if (track.path == AnimationTrack::ROTATION && track.interpolation != AnimationTrack::CUBICSPLINE) {
+			animation.values.resize(animation.values.size() + values.size() * 3);
+			for (size_t v = 0; v < values.size(); v++)
+				packQuaternion(values[v], animation.values.data() + track.firstValue + v * 3);
+		}
+		else {
+			packRange(track, values, animationValueWords(track.path, track.interpolation), animation.values);
+		}
+		animation.tracks.push_back(track);
+	}
+
+	animationFinalize(animation);
+}
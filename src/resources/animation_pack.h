@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "core/math.h"
+#include "scene/animation.h"
+
+// One track as imported, before compression: key times in seconds and vec4
+// values (in-tangent, value, out-tangent per key for CUBICSPLINE).
+struct RawAnimationTrack {
+	AnimationTrack track;   // node, path, interpolation and firstWeight
+	std::vector<float> times;
+	std::vector<glm::vec4> values;
+};
+
+// Largest error key reduction may introduce, per path: model units for
+// translations, scale factor for scales, radians for rotations and weight
+// for morph weights. Quantization adds about 1e-5 of each track's range.
+struct AnimationTolerance {
+	float translation = 1e-4f;
+	float rotation = 1e-4f;
+	float scale = 1e-5f;
+	float weight = 1e-4f;
+};
+
+// Compresses the raw tracks into animation: drops keys that linear (or
+// step) interpolation of their neighbours reproduces within tolerance,
+// quantizes times and values to 16 bits and shares identical time lists.
+// Sets start and end and finalizes the clip.
+void packAnimation(Animation& animation, const std::vector<RawAnimationTrack>& tracks, const AnimationTolerance& tolerance = {});
+
+// Smallest-three encoding decoded by animation evaluation (see
+// animationValueWords)
+void packQuaternion(glm::vec4 q, uint16_t* words);
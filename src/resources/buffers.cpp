@@ -3,6 +3,7 @@
 #include "render/renderer.h"
 #include "core/context.h"
 #include "core/state.h"
+#include "core/load_stats.h"
 #include "scene/skybox.h"
 #include "scene/mesh.h"
 #include <stdexcept>
@@ -73,11 +74,7 @@ void createBufferForMaterial(
 		*outMemory
 	);
 }
-void vertexBufferCreateForMesh(State* state, const std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VkDeviceMemory& vertexMemory) {
-
-	if (vertices.empty()) return;
-
-	VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+void deviceBufferCreateFromMemory(State* state, const void* src, VkDeviceSize bufferSize, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory) {
 
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMemory;
@@ -88,20 +85,29 @@ void vertexBufferCreateForMesh(State* state, const std::vector<Vertex>& vertices
 
 	void* data;
 	vkMapMemory(state->context->device, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, vertices.data(), (size_t)bufferSize);
+	memcpy(data, src, (size_t)bufferSize);
 	vkUnmapMemory(state->context->device, stagingBufferMemory);
+	loadStatsAddUploaded(state, bufferSize);
 
 	createBuffer(state, bufferSize,
-		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		vertexBuffer, vertexMemory);
+		buffer, memory);
 
-	copyBuffer(state, stagingBuffer, vertexBuffer, bufferSize);
+	copyBuffer(state, stagingBuffer, buffer, bufferSize);
 
 	vkDestroyBuffer(state->context->device, stagingBuffer, nullptr);
 	vkFreeMemory(state->context->device, stagingBufferMemory, nullptr);
 }
 
+void vertexBufferCreateForMesh(State* state, const std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VkDeviceMemory& vertexMemory) {
+
+	if (vertices.empty()) return;
+
+	deviceBufferCreateFromMemory(state, vertices.data(), sizeof(vertices[0]) * vertices.size(),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexMemory);
+}
+
 void vertexBufferDestroy(State* state) {
 	vkDestroyBuffer(state->context->device, state->buffers->vertexBuffer, nullptr);
 	vkFreeMemory(state->context->device, state->buffers->vertexBufferMemory, nullptr);
@@ -111,29 +117,8 @@ void indexBufferCreateForMesh(State* state, const std::vector<uint32_t>& indices
 
 	if (indices.empty()) return;
 
-	VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(state, bufferSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer, stagingBufferMemory);
-
-	void* data;
-	vkMapMemory(state->context->device, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, indices.data(), (size_t)bufferSize);
-	vkUnmapMemory(state->context->device, stagingBufferMemory);
-
-	createBuffer(state, bufferSize,
-		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		indexBuffer, indexMemory);
-
-	copyBuffer(state, stagingBuffer, indexBuffer, bufferSize);
-
-	vkDestroyBuffer(state->context->device, stagingBuffer, nullptr);
-	vkFreeMemory(state->context->device, stagingBufferMemory, nullptr);
+	deviceBufferCreateFromMemory(state, indices.data(), sizeof(indices[0]) * indices.size(),
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexMemory);
 }
 
 void indexBufferDestroy(State* state) {
@@ -185,4 +170,17 @@ void destroySkyboxVbo(State* state)
 {
 	vkDestroyBuffer(state->context->device, state->renderer->skyboxVbo, nullptr);
 	vkFreeMemory(state->context->device, state->renderer->skyboxVboMemory, nullptr);
-}
\ No newline at end of file
+}
+
+void identityInstanceBufferCreate(State* state)
+{
+	glm::mat4 identity(1.0f);
+	deviceBufferCreateFromMemory(state, &identity, sizeof(identity), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		state->renderer->identityInstanceBuffer, state->renderer->identityInstanceMemory);
+}
+
+void identityInstanceBufferDestroy(State* state)
+{
+	vkDestroyBuffer(state->context->device, state->renderer->identityInstanceBuffer, nullptr);
+	vkFreeMemory(state->context->device, state->renderer->identityInstanceMemory, nullptr);
+}
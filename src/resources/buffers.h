@@ -28,6 +28,8 @@ uint32_t findMemoryType(State* state, VkMemoryRequirements memRequirements, VkMe
 void createBuffer(State* state, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
 void createBufferForMaterial(State* state, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer* outBuffer, VkDeviceMemory* outMemory);
 void copyBuffer(State* state, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+// Device-local buffer filled from host memory through a temporary staging buffer.
+void deviceBufferCreateFromMemory(State* state, const void* src, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory);
 
 void vertexBufferCreateForMesh(State* state, const std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VkDeviceMemory& vertexMemory);
 
@@ -38,4 +40,7 @@ void indexBufferCreateForMesh(State* state, const std::vector<uint32_t>& indices
 void indexBufferDestroy(State* state);
 
 void createSkyboxVbo(State* state);
-void destroySkyboxVbo(State* state);
\ No newline at end of file
+void destroySkyboxVbo(State* state);
+
+void identityInstanceBufferCreate(State* state);
+void identityInstanceBufferDestroy(State* state);
\ No newline at end of file
@@ -74,12 +74,13 @@ void imageCreate(State* state, uint32_t width, uint32_t height, VkFormat format,
     vkBindImageMemory(state->context->device, image, imageMemory, 0);
 }
 
-VkImageView imageViewCreate(State* state, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
+VkImageView imageViewCreate(State* state, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkComponentMapping components) {
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image;
     viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
     viewInfo.format = format;
+    viewInfo.components = components;
     viewInfo.subresourceRange.aspectMask = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = mipLevels;
@@ -11,7 +11,7 @@ bool hasStencilComponent(VkFormat format);
 
 //Textures
 void imageCreate(State* state, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t mipLevels, VkSampleCountFlagBits numSamples);
-VkImageView imageViewCreate(State* state, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
+VkImageView imageViewCreate(State* state, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkComponentMapping components = {});
 
 void transitionImageLayout(State* state, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, uint32_t layerCount);
 void transitionSwapchainImagesToPresent(State* state);
@@ -0,0 +1,313 @@
+#include "resources/mesh_optimize.h"
+#include "scene/mesh.h"
+#include <algorithm>
+#include <numeric>
+#include <cstdio>
+
+// Clusters may cost up to this much ACMR to give overdraw sorting more freedom
+static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+// FIFO cache simulation shared by the analysis and the overdraw pass. A
+// vertex is resident while fewer than `size` misses happened since its own.
+struct FifoCache {
+	std::vector<uint32_t> stamps;
+	uint32_t size;
+	uint32_t time;
+
+	FifoCache(size_t vertexCount, uint32_t cacheSize) : stamps(vertexCount, 0), size(cacheSize), time(cacheSize + 1) {}
+
+	uint32_t access(uint32_t v) {
+		if (time - stamps[v] > size) {
+			stamps[v] = time++;
+			return 1;
+		}
+		return 0;
+	}
+	uint32_t triangle(const uint32_t* tri) { return access(tri[0]) + access(tri[1]) + access(tri[2]); }
+	void flush() { time += size + 1; }
+};
+
+VertexCacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+	VertexCacheStats stats;
+	FifoCache cache(vertexCount, cacheSize);
+	std::vector<bool> seen(vertexCount, false);
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		stats.transformed += cache.triangle(&indices[i]);
+	for (uint32_t v : indices) {
+		if (!seen[v]) {
+			seen[v] = true;
+			stats.vertices++;
+		}
+	}
+	stats.triangles = indices.size() / 3;
+	return stats;
+}
+
+// ─────────────────────────────────────────────
+// Weld
+// ─────────────────────────────────────────────
+// Returns the vertices left, unique ones first in their original order
+static size_t weldVertices(std::span<Vertex> vertices, std::span<uint32_t> indices) {
+	size_t capacity = 1;
+	while (capacity < vertices.size() * 2)
+		capacity <<= 1;
+
+	// Open addressing over indices into `unique`
+	std::vector<uint32_t> table(capacity, UINT32_MAX);
+	std::vector<uint32_t> remap(vertices.size());
+	std::vector<Vertex> unique;
+	unique.reserve(vertices.size());
+	std::hash<Vertex> hasher;
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		size_t slot = hasher(vertices[i]) & (capacity - 1);
+		while (table[slot] != UINT32_MAX && !(unique[table[slot]] == vertices[i]))
+			slot = (slot + 1) & (capacity - 1);
+
+		if (table[slot] == UINT32_MAX) {
+			table[slot] = (uint32_t)unique.size();
+			unique.push_back(vertices[i]);
+		}
+		remap[i] = table[slot];
+	}
+
+	for (uint32_t& index : indices)
+		index = remap[index];
+	std::copy(unique.begin(), unique.end(), vertices.begin());
+	return unique.size();
+}
+
+// ─────────────────────────────────────────────
+// Post-transform cache: Tipsify (Sander, Nehab, Barczak 2007)
+// ─────────────────────────────────────────────
+static void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+
+	// Vertex -> triangle adjacency
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (uint32_t v : indices)
+		offsets[v + 1]++;
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++)
+		adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+
+	std::vector<uint32_t> live(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		live[v] = offsets[v + 1] - offsets[v];
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	deadEnd.reserve(indices.size());
+	result.reserve(indices.size());
+
+	uint32_t time = cacheSize + 1;
+	size_t cursor = 0;
+
+	auto nextFan = [&]() -> int64_t {
+		// Prefer a candidate whose remaining triangles still fit in the cache,
+		// the oldest such one first
+		int64_t best = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t v : candidates) {
+			if (live[v] == 0)
+				continue;
+			int64_t priority = 0;
+			if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+				priority = time - cacheTime[v];
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				best = v;
+			}
+		}
+		if (best >= 0)
+			return best;
+
+		while (!deadEnd.empty()) {
+			uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[v] > 0)
+				return v;
+		}
+		for (; cursor < vertexCount; cursor++) {
+			if (live[cursor] > 0)
+				return (int64_t)cursor;
+		}
+		return -1;
+	};
+
+	int64_t fan = nextFan();
+	while (fan >= 0) {
+		candidates.clear();
+		for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; a++) {
+			uint32_t t = adjacency[a];
+			if (emitted[t])
+				continue;
+			emitted[t] = true;
+
+			for (int c = 0; c < 3; c++) {
+				uint32_t v = indices[t * 3 + c];
+				result.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+		}
+		fan = nextFan();
+	}
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+// ─────────────────────────────────────────────
+// Overdraw: clusters of the cache-optimized order, sorted so triangles
+// facing away from the centre (likely occluders) are drawn first
+// ─────────────────────────────────────────────
+static void optimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, const glm::vec3& center, uint32_t cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+	FifoCache cache(vertices.size(), cacheSize);
+
+	// Hard boundaries: a triangle missing on all three vertices starts a new run
+	std::vector<size_t> hard;
+	for (size_t t = 0; t < triangleCount; t++) {
+		uint32_t misses = cache.triangle(&indices[t * 3]);
+		if (t == 0 || misses == 3)
+			hard.push_back(t);
+	}
+	hard.push_back(triangleCount);
+
+	// Soft boundaries: split runs wherever the prefix is already within the
+	// threshold of the whole run's ACMR
+	std::vector<size_t> starts;
+	for (size_t h = 0; h + 1 < hard.size(); h++) {
+		size_t begin = hard[h], end = hard[h + 1];
+
+		cache.flush();
+		uint32_t runMisses = 0;
+		for (size_t t = begin; t < end; t++)
+			runMisses += cache.triangle(&indices[t * 3]);
+		float runThreshold = OVERDRAW_THRESHOLD * runMisses / float(end - begin);
+
+		starts.push_back(begin);
+		cache.flush();
+		uint32_t misses = 0, faces = 0;
+		for (size_t t = begin; t < end; t++) {
+			misses += cache.triangle(&indices[t * 3]);
+			faces++;
+			if (t + 1 < end && float(misses) / faces <= runThreshold) {
+				starts.push_back(t + 1);
+				cache.flush();
+				misses = faces = 0;
+			}
+		}
+	}
+	starts.push_back(triangleCount);
+
+	// Area-weighted centroid and normal per cluster
+	size_t clusterCount = starts.size() - 1;
+	std::vector<float> keys(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++) {
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = starts[c]; t < starts[c + 1]; t++) {
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].pos;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float a = glm::length(n);
+			centroid += (p0 + p1 + p2) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+		if (area > 0.0f)
+			centroid /= area;
+		float length = glm::length(normal);
+		if (length > 0.0f)
+			normal /= length;
+		keys[c] = glm::dot(centroid - center, normal);
+	}
+
+	std::vector<size_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (size_t c : order)
+		result.insert(result.end(), indices.begin() + starts[c] * 3, indices.begin() + starts[c + 1] * 3);
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+// ─────────────────────────────────────────────
+// Vertex fetch: vertices in first-use order, unreferenced ones dropped
+// ─────────────────────────────────────────────
+static size_t optimizeVertexFetch(std::span<Vertex> vertices, std::span<uint32_t> indices) {
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	std::vector<Vertex> ordered;
+	ordered.reserve(vertices.size());
+
+	for (uint32_t& index : indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = (uint32_t)ordered.size();
+			ordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	std::copy(ordered.begin(), ordered.end(), vertices.begin());
+	return ordered.size();
+}
+
+MeshOptimizeStats optimizeMesh(std::span<Vertex> vertices, std::span<uint32_t> indices, const glm::vec3& center) {
+	MeshOptimizeStats stats;
+	stats.verticesBefore = stats.verticesAfter = vertices.size();
+
+	if (indices.empty() || indices.size() % 3 != 0 || vertices.size() >= UINT32_MAX)
+		return stats;
+	for (uint32_t index : indices) {
+		if (index >= vertices.size())
+			return stats;
+	}
+
+	stats.before = analyzeVertexCache(indices, vertices.size());
+
+	vertices = vertices.first(weldVertices(vertices, indices));
+	optimizeVertexCache(indices, vertices.size(), VERTEX_CACHE_SIZE);
+	optimizeOverdraw(indices, vertices, center, VERTEX_CACHE_SIZE);
+	vertices = vertices.first(optimizeVertexFetch(vertices, indices));
+
+	stats.verticesAfter = vertices.size();
+	stats.after = analyzeVertexCache(indices, vertices.size());
+	return stats;
+}
+
+MeshOptimizeStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const glm::vec3& center) {
+	MeshOptimizeStats stats = optimizeMesh(std::span<Vertex>(vertices), std::span<uint32_t>(indices), center);
+	vertices.resize(stats.verticesAfter);
+	return stats;
+}
+
+void meshOptimizeReport(const std::vector<MeshOptimizeStats>& stats) {
+	if (stats.empty())
+		return;
+	MeshOptimizeStats total;
+	for (const MeshOptimizeStats& s : stats) {
+		total.verticesBefore += s.verticesBefore;
+		total.verticesAfter += s.verticesAfter;
+		total.before.transformed += s.before.transformed;
+		total.before.triangles += s.before.triangles;
+		total.before.vertices += s.before.vertices;
+		total.after.transformed += s.after.transformed;
+		total.after.triangles += s.after.triangles;
+		total.after.vertices += s.after.vertices;
+	}
+	printf("meshOptimize: %zu meshes, vertices %zu -> %zu, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+		stats.size(), total.verticesBefore, total.verticesAfter,
+		total.before.acmr(), total.after.acmr(), total.before.atvr(), total.after.atvr());
+}
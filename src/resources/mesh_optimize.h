@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include "core/math.h"
+
+struct Vertex;
+
+constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+// Post-transform cache behaviour of an index buffer on a FIFO cache.
+struct VertexCacheStats {
+	size_t transformed = 0;  // vertex shader invocations
+	size_t triangles = 0;
+	size_t vertices = 0;     // distinct vertices referenced
+
+	float acmr() const { return triangles ? (float)transformed / triangles : 0.0f; }
+	float atvr() const { return vertices ? (float)transformed / vertices : 0.0f; }
+};
+
+VertexCacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+struct MeshOptimizeStats {
+	size_t verticesBefore = 0;
+	size_t verticesAfter = 0;
+	VertexCacheStats before;
+	VertexCacheStats after;
+};
+
+// Welds bitwise-identical vertices, orders triangles for the post-transform
+// cache (Tipsify), splits that order into clusters sorted front to back
+// around center for overdraw, then orders vertices by first use. Triangle
+// lists only; anything else (or out-of-range indices) is left untouched.
+MeshOptimizeStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const glm::vec3& center);
+// In place over decoded arrays that cannot shrink, staging memory say; the
+// first verticesAfter vertices are the ones left
+MeshOptimizeStats optimizeMesh(std::span<Vertex> vertices, std::span<uint32_t> indices, const glm::vec3& center);
+// One line of totals over a load's meshes
+void meshOptimizeReport(const std::vector<MeshOptimizeStats>& stats);
@@ -0,0 +1,95 @@
+#include "resources/mipmaps.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+uint32_t mipLevelCount(uint32_t width, uint32_t height) {
+	return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+std::vector<MipLevel> mipChainLayout(uint32_t width, uint32_t height, uint32_t bytesPerPixel) {
+	std::vector<MipLevel> levels(mipLevelCount(width, height));
+	size_t offset = 0;
+
+	for (MipLevel& level : levels) {
+		level.width = width;
+		level.height = height;
+		level.offset = offset;
+		level.size = static_cast<size_t>(width) * height * bytesPerPixel;
+		offset += level.size;
+
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+	return levels;
+}
+
+void expandToRGBA8(const unsigned char* pixels, uint32_t width, uint32_t height, int channels, unsigned char* out) {
+	size_t count = static_cast<size_t>(width) * height;
+
+	for (size_t i = 0; i < count; ++i) {
+		const unsigned char* s = pixels + i * channels;
+		unsigned char* d = out + i * 4;
+		switch (channels) {
+		case 1: d[0] = d[1] = d[2] = s[0]; d[3] = 255; break;
+		case 2: d[0] = d[1] = d[2] = s[0]; d[3] = s[1]; break;
+		case 3: d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = 255; break;
+		default: d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[3]; break;
+		}
+	}
+}
+
+static const std::array<float, 256>& srgbToLinearTable() {
+	static const std::array<float, 256> table = [] {
+		std::array<float, 256> t{};
+		for (int i = 0; i < 256; ++i) {
+			float c = i / 255.0f;
+			t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		return t;
+	}();
+	return table;
+}
+
+static unsigned char linearToSrgb8(float c) {
+	c = std::clamp(c, 0.0f, 1.0f);
+	float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+	return static_cast<unsigned char>(s * 255.0f + 0.5f);
+}
+
+static void downsample(const unsigned char* src, const MipLevel& from, unsigned char* dst, const MipLevel& to, bool srgb) {
+	const std::array<float, 256>& toLinear = srgbToLinearTable();
+
+	for (uint32_t y = 0; y < to.height; ++y) {
+		uint32_t y0 = std::min(y * 2, from.height - 1);
+		uint32_t y1 = std::min(y * 2 + 1, from.height - 1);
+
+		for (uint32_t x = 0; x < to.width; ++x) {
+			uint32_t x0 = std::min(x * 2, from.width - 1);
+			uint32_t x1 = std::min(x * 2 + 1, from.width - 1);
+
+			const unsigned char* taps[4] = {
+				src + (static_cast<size_t>(y0) * from.width + x0) * 4,
+				src + (static_cast<size_t>(y0) * from.width + x1) * 4,
+				src + (static_cast<size_t>(y1) * from.width + x0) * 4,
+				src + (static_cast<size_t>(y1) * from.width + x1) * 4,
+			};
+			unsigned char* d = dst + (static_cast<size_t>(y) * to.width + x) * 4;
+
+			for (int c = 0; c < 4; ++c) {
+				if (srgb && c < 3) {
+					float sum = toLinear[taps[0][c]] + toLinear[taps[1][c]] + toLinear[taps[2][c]] + toLinear[taps[3][c]];
+					d[c] = linearToSrgb8(sum * 0.25f);
+				}
+				else {
+					d[c] = static_cast<unsigned char>((taps[0][c] + taps[1][c] + taps[2][c] + taps[3][c] + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+void buildMipChainRGBA8(unsigned char* chain, const std::vector<MipLevel>& levels, bool srgb) {
+	for (size_t i = 1; i < levels.size(); ++i)
+		downsample(chain + levels[i - 1].offset, levels[i - 1], chain + levels[i].offset, levels[i], srgb);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct MipLevel {
+	uint32_t width;
+	uint32_t height;
+	size_t offset;
+	size_t size;
+};
+
+uint32_t mipLevelCount(uint32_t width, uint32_t height);
+
+// Tightly packed level layout for a full chain, level 0 first.
+std::vector<MipLevel> mipChainLayout(uint32_t width, uint32_t height, uint32_t bytesPerPixel);
+
+// Expands 1-4 channel 8-bit pixels to RGBA8 (alpha 255, grey replicated).
+void expandToRGBA8(const unsigned char* pixels, uint32_t width, uint32_t height, int channels, unsigned char* out);
+
+// Box-filters RGBA8 level 0 in `chain` (laid out by mipChainLayout) down to
+// every smaller level. sRGB colour channels are averaged in linear space.
+void buildMipChainRGBA8(unsigned char* chain, const std::vector<MipLevel>& levels, bool srgb);
@@ -0,0 +1,122 @@
+#include "resources/staging_arena.h"
+#include "resources/buffers.h"
+#include "render/command_buffers.h"
+#include "render/renderer.h"
+#include "core/context.h"
+#include "core/load_stats.h"
+#include "core/state.h"
+#include <algorithm>
+
+// Large enough for most models' geometry in one submission; a bigger
+// buffer grows the arena to fit rather than going through a one-off copy.
+static constexpr VkDeviceSize ARENA_CAPACITY = 64ull << 20;
+static constexpr VkDeviceSize ARENA_ALIGNMENT = 16;
+
+static void arenaRelease(State* state, StagingArena* arena) {
+	if (arena->mapped)
+		vkUnmapMemory(state->context->device, arena->memory);
+	if (arena->buffer)
+		vkDestroyBuffer(state->context->device, arena->buffer, nullptr);
+	if (arena->memory)
+		vkFreeMemory(state->context->device, arena->memory, nullptr);
+	arena->buffer = VK_NULL_HANDLE;
+	arena->memory = VK_NULL_HANDLE;
+	arena->mapped = nullptr;
+	arena->capacity = 0;
+}
+
+// The glTF decoder reads its output back (bounds, optimizer, packing in
+// place), which uncached write-combined memory makes very slow
+static VkMemoryPropertyFlags arenaMemoryProperties(State* state) {
+	const VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	VkPhysicalDeviceMemoryProperties memProperties;
+	vkGetPhysicalDeviceMemoryProperties(state->context->physicalDevice, &memProperties);
+	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+		if ((memProperties.memoryTypes[i].propertyFlags & cached) == cached)
+			return cached;
+	}
+	return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+static void arenaReserve(State* state, StagingArena* arena, VkDeviceSize capacity) {
+	arenaRelease(state, arena);
+	createBuffer(state, capacity,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		arenaMemoryProperties(state),
+		arena->buffer, arena->memory);
+	vkMapMemory(state->context->device, arena->memory, 0, capacity, 0, reinterpret_cast<void**>(&arena->mapped));
+	arena->capacity = capacity;
+}
+
+// Copies everything written so far and waits, leaving the memory reserved
+// and all of it free again
+static void arenaSubmit(State* state, StagingArena* arena) {
+	if (!arena->copies.empty()) {
+		VkCommandBuffer cmd = beginSingleTimeCommands(state, state->renderer->commandPool);
+		for (const StagingCopy& copy : arena->copies) {
+			VkBufferCopy region{ .srcOffset = copy.srcOffset, .dstOffset = 0, .size = copy.size };
+			vkCmdCopyBuffer(cmd, arena->buffer, copy.dst, 1, &region);
+		}
+		endSingleTimeCommands(state, cmd);
+	}
+
+	arena->copies.clear();
+	arena->used = 0;
+}
+
+static StagingArena* arenaGet(State* state) {
+	if (!state->staging)
+		state->staging = new StagingArena{};
+	return state->staging;
+}
+
+static VkDeviceSize arenaAlign(VkDeviceSize value) {
+	return (value + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+unsigned char* stagingArenaReserve(State* state, VkDeviceSize size, VkDeviceSize& offset) {
+	StagingArena* arena = arenaGet(state);
+	offset = arenaAlign(arena->used);
+	if (offset + size > arena->capacity) {
+		if (arena->used > 0)
+			return nullptr;
+		arenaReserve(state, arena, std::max(size, std::max(arena->capacity * 2, ARENA_CAPACITY)));
+		offset = 0;
+	}
+	arena->used = offset + size;
+	return arena->mapped + offset;
+}
+
+void stagingArenaCopy(State* state, VkDeviceSize offset, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory) {
+	createBuffer(state, size,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		buffer, memory);
+	state->staging->copies.push_back({ offset, buffer, size });
+	loadStatsAddUploaded(state, size);
+}
+
+unsigned char* stagingArenaBuffer(State* state, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory) {
+	VkDeviceSize offset = 0;
+	unsigned char* dst = stagingArenaReserve(state, size, offset);
+	if (!dst) {
+		arenaSubmit(state, state->staging);
+		dst = stagingArenaReserve(state, size, offset);
+	}
+	stagingArenaCopy(state, offset, size, usage, buffer, memory);
+	return dst;
+}
+
+void stagingArenaFlush(State* state) {
+	if (state->staging)
+		arenaSubmit(state, state->staging);
+}
+
+void stagingArenaDestroy(State* state) {
+	if (!state->staging)
+		return;
+	arenaRelease(state, state->staging);
+	delete state->staging;
+	state->staging = nullptr;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <vulkan/vulkan.h>
+
+struct State;
+
+struct StagingCopy {
+	VkDeviceSize srcOffset;
+	VkBuffer dst;
+	VkDeviceSize size;
+};
+
+// Mapped upload memory for the synchronous loaders: they decode or pack
+// vertex, index, skin and morph data into it in the GPU layout, and one
+// submission copies all of it to device-local buffers, instead of a staging
+// buffer, map, copy and queue wait per buffer. Created on first use and kept
+// mapped until stagingArenaDestroy, growing when a buffer does not fit. The
+// async loader stages on its workers into a buffer per load instead; this
+// one is main thread only.
+struct StagingArena {
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	unsigned char* mapped = nullptr;
+	VkDeviceSize capacity = 0;
+	VkDeviceSize used = 0;
+	std::vector<StagingCopy> copies;  // waiting for stagingArenaFlush
+};
+
+// Creates the device-local buffer and returns size bytes of arena to fill
+// it with; the contents are copied over by the next stagingArenaFlush. The
+// arena flushes or grows when full.
+unsigned char* stagingArenaBuffer(State* state, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory);
+// size bytes of arena at offset for the caller to fill before handing parts
+// of them to stagingArenaCopy. Never flushes, so earlier reservations stay
+// valid: returns null when size does not fit behind them, and the caller
+// stages what it has, flushes and asks again. An empty arena grows to fit.
+unsigned char* stagingArenaReserve(State* state, VkDeviceSize size, VkDeviceSize& offset);
+// Creates the device-local buffer and queues a copy of size bytes of
+// reserved arena at offset into it
+void stagingArenaCopy(State* state, VkDeviceSize offset, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory);
+// Copies everything written since the last flush and waits for it; call
+// once a load has staged all its buffers. The arena stays mapped.
+void stagingArenaFlush(State* state);
+void stagingArenaDestroy(State* state);
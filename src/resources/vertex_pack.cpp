@@ -0,0 +1,134 @@
+#include "resources/vertex_pack.h"
+#include "scene/mesh.h"
+#include <glm/gtc/packing.hpp>
+#include <cmath>
+
+VkIndexType meshIndexType(uint32_t vertexCount) {
+	return vertexCount <= 0xFFFF ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+uint32_t indexTypeSize(VkIndexType type) {
+	return type == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+}
+
+static glm::vec2 signNotZero(glm::vec2 v) {
+	return { v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f };
+}
+
+uint32_t octEncode(glm::vec3 n) {
+	float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	if (l1 == 0.0f)
+		return glm::packSnorm2x16(glm::vec2(0.0f));
+
+	glm::vec2 p = glm::vec2(n.x, n.y) / l1;
+	// Fold the lower hemisphere over the diagonals
+	if (n.z < 0.0f)
+		p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * signNotZero(p);
+	return glm::packSnorm2x16(p);
+}
+
+glm::vec3 octDecode(uint32_t packed) {
+	glm::vec2 e = glm::unpackSnorm2x16(packed);
+	glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+template<typename V>
+static void packAttributes(const Vertex& v, V& out) {
+	out.color = glm::packUnorm4x8(glm::vec4(v.color, v.tangent.w < 0.0f ? 0.0f : 1.0f));
+	out.texCoord0 = glm::packHalf2x16(v.texCoord0);
+	out.texCoord1 = glm::packHalf2x16(v.texCoord1);
+	out.normal = octEncode(v.normal);
+	out.tangent = octEncode(glm::vec3(v.tangent));
+}
+
+// Each vertex is read whole before its packed form is written, and packed
+// vertices are never larger, so out may be the vertices' own memory. memcpy
+// keeps that aliasing well defined.
+void packVerticesTo(VertexLayout layout, const Vertex* vertices, size_t count, const glm::vec3& minBounds, const glm::vec3& maxBounds, unsigned char* out) {
+	const unsigned char* src = reinterpret_cast<const unsigned char*>(vertices);
+	switch (layout) {
+	case VertexLayout::Compact: {
+		for (size_t i = 0; i < count; ++i) {
+			Vertex v;
+			memcpy(&v, src + i * sizeof(Vertex), sizeof(Vertex));
+			CompactVertex packed;
+			packed.pos = v.pos;
+			packAttributes(v, packed);
+			memcpy(out + i * sizeof(CompactVertex), &packed, sizeof(packed));
+		}
+		break;
+	}
+	case VertexLayout::CompactQuantized: {
+		glm::vec3 extent = maxBounds - minBounds;
+		glm::vec3 invExtent(
+			extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+			extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+			extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+		for (size_t i = 0; i < count; ++i) {
+			Vertex v;
+			memcpy(&v, src + i * sizeof(Vertex), sizeof(Vertex));
+			QuantizedVertex packed;
+			glm::vec3 q = glm::clamp((v.pos - minBounds) * invExtent, 0.0f, 1.0f);
+			uint64_t pos = glm::packUnorm4x16(glm::vec4(q, 0.0f));
+			memcpy(packed.pos, &pos, sizeof(packed.pos));
+			packAttributes(v, packed);
+			memcpy(out + i * sizeof(QuantizedVertex), &packed, sizeof(packed));
+		}
+		break;
+	}
+	default:
+		if (count && out != src)
+			memcpy(out, src, (size_t)vertexStride(layout) * count);
+		break;
+	}
+}
+
+void packIndicesTo(const uint32_t* indices, size_t count, VkIndexType type, unsigned char* out) {
+	const unsigned char* src = reinterpret_cast<const unsigned char*>(indices);
+	if (type == VK_INDEX_TYPE_UINT16) {
+		for (size_t i = 0; i < count; ++i) {
+			uint32_t index;
+			memcpy(&index, src + i * sizeof(uint32_t), sizeof(index));
+			uint16_t narrow = (uint16_t)index;
+			memcpy(out + i * sizeof(uint16_t), &narrow, sizeof(narrow));
+		}
+	}
+	else if (count && out != src) {
+		memcpy(out, src, count * sizeof(uint32_t));
+	}
+}
+
+size_t morphTargetsBytes(const std::vector<MorphVertex>& vertices, const std::vector<MorphDelta>& deltas) {
+	return vertices.size() * sizeof(MorphVertex) + deltas.size() * sizeof(MorphDelta);
+}
+
+void packMorphTargetsTo(const std::vector<MorphVertex>& vertices, const std::vector<MorphDelta>& deltas, unsigned char* out) {
+	size_t vertexBytes = vertices.size() * sizeof(MorphVertex);
+	if (!vertices.empty())
+		memcpy(out, vertices.data(), vertexBytes);
+	if (!deltas.empty())
+		memcpy(out + vertexBytes, deltas.data(), deltas.size() * sizeof(MorphDelta));
+}
+
+std::vector<unsigned char> packVertices(VertexLayout layout, const std::vector<Vertex>& vertices, const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+	std::vector<unsigned char> out((size_t)vertexStride(layout) * vertices.size());
+	packVerticesTo(layout, vertices.data(), vertices.size(), minBounds, maxBounds, out.data());
+	return out;
+}
+
+std::vector<unsigned char> packIndices(const std::vector<uint32_t>& indices, VkIndexType type) {
+	std::vector<unsigned char> out((size_t)indexTypeSize(type) * indices.size());
+	packIndicesTo(indices.data(), indices.size(), type, out.data());
+	return out;
+}
+
+std::vector<unsigned char> packMorphTargets(const std::vector<MorphVertex>& vertices, const std::vector<MorphDelta>& deltas) {
+	std::vector<unsigned char> out(morphTargetsBytes(vertices, deltas));
+	packMorphTargetsTo(vertices, deltas, out.data());
+	return out;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include "core/math.h"
+
+struct Vertex;
+struct MorphVertex;
+struct MorphDelta;
+enum class VertexLayout : uint32_t;
+
+// 16-bit indices whenever every vertex is addressable by one
+VkIndexType meshIndexType(uint32_t vertexCount);
+uint32_t indexTypeSize(VkIndexType type);
+
+// Vertices in the GPU layout (vertexStride(layout) bytes each); positions are
+// quantized against minBounds/maxBounds for VertexLayout::CompactQuantized.
+std::vector<unsigned char> packVertices(VertexLayout layout, const std::vector<Vertex>& vertices, const glm::vec3& minBounds, const glm::vec3& maxBounds);
+std::vector<unsigned char> packIndices(const std::vector<uint32_t>& indices, VkIndexType type);
+// Morph storage buffer contents: the MorphVertex records, then the deltas
+std::vector<unsigned char> packMorphTargets(const std::vector<MorphVertex>& vertices, const std::vector<MorphDelta>& deltas);
+size_t morphTargetsBytes(const std::vector<MorphVertex>& vertices, const std::vector<MorphDelta>& deltas);
+
+// As above, written to dst (mapped staging memory, say) instead of a new
+// vector; dst holds vertexStride(layout) * count, indexTypeSize(type) * count
+// and morphTargetsBytes bytes. Vertices and indices may be packed over
+// themselves, dst pointing at their own memory.
+void packVerticesTo(VertexLayout layout, const Vertex* vertices, size_t count, const glm::vec3& minBounds, const glm::vec3& maxBounds, unsigned char* dst);
+void packIndicesTo(const uint32_t* indices, size_t count, VkIndexType type, unsigned char* dst);
+void packMorphTargetsTo(const std::vector<MorphVertex>& vertices, const std::vector<MorphDelta>& deltas, unsigned char* dst);
+
+// Octahedral unit vector encoding, snorm16x2 packed like R16G16_SNORM
+uint32_t octEncode(glm::vec3 n);
+glm::vec3 octDecode(uint32_t packed);
@@ -1,2 +1,436 @@
 #include "scene/animation.h"
 #include "scene/node.h"
+#include "scene/model.h"
+#include "scene/scene.h"
+#include "scene/mesh.h"
+#include "scene/camera.h"
+#include "core/jobs.h"
+#include "core/state.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define RUNE_ANIMATION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static uint16_t nodeDepth(const Node* node) {
+	uint16_t depth = 0;
+	for (const Node* parent = node->parent; parent; parent = parent->parent)
+		depth++;
+	return depth;
+}
+
+void animationFinalize(Animation& animation) {
+	size_t count = animation.tracks.size();
+	std::vector<std::pair<uint16_t, AnimationTrack>> sorted(count);
+	for (size_t i = 0; i < count; i++)
+		sorted[i] = { nodeDepth(animation.tracks[i].node), animation.tracks[i] };
+	// Within a path, shallow nodes first: a level of detail's tracks are a
+	// prefix of every path range
+	std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+		return a.second.path != b.second.path ? a.second.path < b.second.path : a.first < b.first;
+	});
+	animation.depths.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		animation.depths[i] = sorted[i].first;
+		animation.tracks[i] = sorted[i].second;
+	}
+
+	auto firstOf = [&](AnimationTrack::Path path) {
+		return (uint32_t)(std::ranges::lower_bound(animation.tracks, path, {}, &AnimationTrack::path) - animation.tracks.begin());
+	};
+	animation.firstRotation = firstOf(AnimationTrack::ROTATION);
+	animation.firstScale = firstOf(AnimationTrack::SCALE);
+	animation.firstWeights = firstOf(AnimationTrack::WEIGHTS);
+
+	animation.cursors.assign(count, 0);
+	animation.from.resize(count);
+	animation.to.resize(count);
+	animation.weights.resize(count);
+	animation.pose.resize(count);
+	animation.previous.resize(count);
+	animation.target.resize(count);
+	animation.sampled = false;
+}
+
+// ─────────────────────────────────────────────
+// Sampling
+// ─────────────────────────────────────────────
+
+// Index of the last key at or before time, in quantized key units. Playback
+// moves forward a key or two per frame, so walking from last frame's key is
+// O(1) amortized; a backwards jump (loop wrap) or a long skip falls back to
+// a binary search.
+static uint32_t seekKey(const uint16_t* times, uint32_t count, uint32_t& cursor, float time) {
+	uint32_t k = cursor;
+	if (k >= count || times[k] > time) {
+		k = 0;
+	}
+	else {
+		for (int steps = 0; steps < 4 && k + 1 < count && times[k + 1] <= time; steps++)
+			k++;
+	}
+	if (k + 1 < count && times[k + 1] <= time) {
+		k = (uint32_t)(std::upper_bound(times + k, times + count, time) - times) - 1;
+	}
+	cursor = k;
+	return k;
+}
+
+static glm::vec4 unpackQuaternion(const uint16_t* words) {
+	constexpr float scale = 1.41421356f / 32767.0f;   // [0, 32767] to [-1/sqrt(2), 1/sqrt(2)]
+	uint32_t largest = (words[0] >> 15) | ((words[1] >> 15) << 1);
+	glm::vec3 small(
+		(float)(words[0] & 0x7FFF) * scale - 0.70710678f,
+		(float)(words[1] & 0x7FFF) * scale - 0.70710678f,
+		(float)(words[2] & 0x7FFF) * scale - 0.70710678f);
+	glm::vec4 q;
+	for (uint32_t c = 0, s = 0; c < 4; c++)
+		q[(int)c] = c == largest ? std::sqrt(std::max(0.0f, 1.0f - glm::dot(small, small))) : small[(int)s++];
+	return q;
+}
+
+static glm::vec4 decodeValue(const AnimationTrack& track, const uint16_t* words) {
+	if (track.path == AnimationTrack::ROTATION && track.interpolation != AnimationTrack::CUBICSPLINE)
+		return unpackQuaternion(words);
+	glm::vec4 value = track.rangeMin;
+	uint32_t components = animationValueWords(track.path, track.interpolation);
+	for (uint32_t c = 0; c < components; c++)
+		value[(int)c] += track.rangeExtent[(int)c] * ((float)words[c] * (1.0f / 65535.0f));
+	return value;
+}
+
+// Reduces one track at time (in key units, timeScale per second) to a
+// (from, to, weight) segment for the batched kernels. STEP, clamped and
+// CUBICSPLINE tracks are resolved here and passed through with weight 0.
+static void sampleTrack(Animation& animation, size_t i, float time, float timeScale) {
+	const AnimationTrack& track = animation.tracks[i];
+	const uint16_t* times = animation.times.data() + track.firstKey;
+	const uint16_t* values = animation.values.data() + track.firstValue;
+	uint32_t words = animationValueWords(track.path, track.interpolation);
+	auto value = [&](uint32_t index) { return decodeValue(track, values + index * words); };
+	bool cubic = track.interpolation == AnimationTrack::CUBICSPLINE;
+	uint32_t k = seekKey(times, track.keyCount, animation.cursors[i], time);
+
+	if (k + 1 >= track.keyCount || time <= times[k] || track.interpolation == AnimationTrack::STEP) {
+		animation.from[i] = animation.to[i] = value(cubic ? k * 3 + 1 : k);
+		animation.weights[i] = 0.0f;
+		return;
+	}
+
+	float span = (float)(times[k + 1] - times[k]);
+	float t = (time - times[k]) / span;
+	if (!cubic) {
+		animation.from[i] = value(k);
+		animation.to[i] = value(k + 1);
+		animation.weights[i] = t;
+		return;
+	}
+
+	// glTF cubic Hermite spline; tangents are scaled by the key span in seconds
+	span /= timeScale;
+	float t2 = t * t;
+	float t3 = t2 * t;
+	glm::vec4 v0 = value(k * 3 + 1);
+	glm::vec4 b0 = value(k * 3 + 2);
+	glm::vec4 a1 = value((k + 1) * 3 + 0);
+	glm::vec4 v1 = value((k + 1) * 3 + 1);
+	glm::vec4 result = (2.0f * t3 - 3.0f * t2 + 1.0f) * v0 + (t3 - 2.0f * t2 + t) * span * b0 +
+		(-2.0f * t3 + 3.0f * t2) * v1 + (t3 - t2) * span * a1;
+	animation.from[i] = animation.to[i] = result;
+	animation.weights[i] = 0.0f;
+}
+
+// ─────────────────────────────────────────────
+// Batched kernels, one vec4 per SSE register
+// ─────────────────────────────────────────────
+#ifdef RUNE_ANIMATION_SSE2
+static inline __m128 dot4(__m128 a, __m128 b) {
+	__m128 m = _mm_mul_ps(a, b);
+	m = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+#endif
+
+// out = from + (to - from) * weight
+static void lerpBatch(const glm::vec4* from, const glm::vec4* to, const float* weights, glm::vec4* out, size_t count) {
+#ifdef RUNE_ANIMATION_SSE2
+	for (size_t i = 0; i < count; i++) {
+		__m128 a = _mm_loadu_ps(&from[i].x);
+		__m128 b = _mm_loadu_ps(&to[i].x);
+		__m128 w = _mm_set1_ps(weights[i]);
+		_mm_storeu_ps(&out[i].x, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), w)));
+	}
+#else
+	for (size_t i = 0; i < count; i++)
+		out[i] = from[i] + (to[i] - from[i]) * weights[i];
+#endif
+}
+
+// Normalized lerp along the shorter arc. Within one keyframe span this is
+// close enough to slerp and needs no trigonometry.
+static void nlerpBatch(const glm::vec4* from, const glm::vec4* to, const float* weights, glm::vec4* out, size_t count) {
+#ifdef RUNE_ANIMATION_SSE2
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	for (size_t i = 0; i < count; i++) {
+		__m128 a = _mm_loadu_ps(&from[i].x);
+		__m128 b = _mm_loadu_ps(&to[i].x);
+		__m128 w = _mm_set1_ps(weights[i]);
+		b = _mm_xor_ps(b, _mm_and_ps(_mm_cmplt_ps(dot4(a, b), zero), signBit));
+		__m128 q = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), w));
+		_mm_storeu_ps(&out[i].x, _mm_div_ps(q, _mm_sqrt_ps(dot4(q, q))));
+	}
+#else
+	for (size_t i = 0; i < count; i++) {
+		glm::vec4 b = glm::dot(from[i], to[i]) < 0.0f ? -to[i] : to[i];
+		out[i] = glm::normalize(from[i] + (b - from[i]) * weights[i]);
+	}
+#endif
+}
+
+// ─────────────────────────────────────────────
+// Evaluation
+// ─────────────────────────────────────────────
+
+static uint32_t pathBegin(const Animation& animation, uint32_t path) {
+	const uint32_t begins[4] = { 0, animation.firstRotation, animation.firstScale, animation.firstWeights };
+	return begins[path];
+}
+
+// End of the tracks lod evaluates in each path range; path p covers
+// [pathBegin(p), ends[p]).
+static void selectTracks(const Animation& animation, const AnimationLod& lod, uint32_t ends[4]) {
+	const uint16_t* depths = animation.depths.data();
+	for (uint32_t path = 0; path < 4; path++) {
+		uint32_t begin = pathBegin(animation, path);
+		uint32_t end = path < 3 ? pathBegin(animation, path + 1) : (uint32_t)animation.tracks.size();
+		if (lod.maxDepth < UINT16_MAX)
+			end = (uint32_t)(std::upper_bound(depths + begin, depths + end, (uint16_t)lod.maxDepth) - depths);
+		ends[path] = path == AnimationTrack::WEIGHTS && !lod.morphWeights ? begin : end;
+	}
+}
+
+// out = the per-track lerp (nlerp for rotations) of from and to by weights
+static void blendTracks(const Animation& animation, const uint32_t ends[4],
+	const glm::vec4* from, const glm::vec4* to, const float* weights, glm::vec4* out) {
+	for (uint32_t path = 0; path < 4; path++) {
+		uint32_t begin = pathBegin(animation, path);
+		if (path == AnimationTrack::ROTATION)
+			nlerpBatch(from + begin, to + begin, weights + begin, out + begin, ends[path] - begin);
+		else
+			lerpBatch(from + begin, to + begin, weights + begin, out + begin, ends[path] - begin);
+	}
+}
+
+static float wrapTime(const Animation& animation, float time) {
+	if (time <= animation.end)
+		return time;
+	float length = animation.end - animation.start;
+	return length > 0.0f ? animation.start + std::fmod(time - animation.start, length) : animation.start;
+}
+
+// Samples the selected tracks at time into out
+static void samplePose(Animation& animation, float time, const uint32_t ends[4], glm::vec4* out) {
+	float length = animation.end - animation.start;
+	float timeScale = length > 0.0f ? 65535.0f / length : 0.0f;
+	float keyTime = (time - animation.start) * timeScale;
+
+	for (uint32_t path = 0; path < 4; path++) {
+		for (uint32_t i = pathBegin(animation, path); i < ends[path]; i++)
+			sampleTrack(animation, i, keyTime, timeScale);
+	}
+	blendTracks(animation, ends, animation.from.data(), animation.to.data(), animation.weights.data(), out);
+}
+
+// Returns whether any node's TRS changed
+static bool applyPose(Animation& animation, const uint32_t ends[4]) {
+	const glm::vec4* pose = animation.pose.data();
+	for (uint32_t i = 0; i < ends[AnimationTrack::TRANSLATION]; i++) {
+		Node* node = animation.tracks[i].node;
+		node->translation = glm::vec3(pose[i]);
+		node->dirty = true;
+	}
+	for (uint32_t i = animation.firstRotation; i < ends[AnimationTrack::ROTATION]; i++) {
+		Node* node = animation.tracks[i].node;
+		node->rotation = glm::quat(pose[i].w, pose[i].x, pose[i].y, pose[i].z);
+		node->dirty = true;
+	}
+	for (uint32_t i = animation.firstScale; i < ends[AnimationTrack::SCALE]; i++) {
+		Node* node = animation.tracks[i].node;
+		node->scale = glm::vec3(pose[i]);
+		node->dirty = true;
+	}
+	for (uint32_t i = animation.firstWeights; i < ends[AnimationTrack::WEIGHTS]; i++) {
+		const AnimationTrack& track = animation.tracks[i];
+		std::vector<float>& weights = track.node->morphWeights;
+		for (uint32_t c = 0; c < 4 && track.firstWeight + c < weights.size(); c++)
+			weights[track.firstWeight + c] = pose[i][c];
+	}
+	return ends[AnimationTrack::TRANSLATION] > 0 || ends[AnimationTrack::ROTATION] > animation.firstRotation
+		|| ends[AnimationTrack::SCALE] > animation.firstScale;
+}
+
+bool animationEvaluate(Animation& animation, float deltaTime, const AnimationLod& lod) {
+	if (animation.tracks.empty())
+		return false;
+
+	animation.currentTime = wrapTime(animation, animation.currentTime + deltaTime);
+	if (!lod.visible) {
+		animation.sampled = false;
+		return false;
+	}
+
+	uint32_t ends[4];
+	selectTracks(animation, lod, ends);
+	if (lod.period <= 0.0f) {
+		samplePose(animation, animation.currentTime, ends, animation.pose.data());
+		animation.sampled = false;
+		return applyPose(animation, ends);
+	}
+
+	// Sparse updates: sample where the pose will be one period from now and
+	// blend towards it, so slow levels move smoothly instead of stepping
+	if (std::memcmp(ends, animation.sampledEnds, sizeof(ends)) != 0)
+		animation.sampled = false;
+	animation.sinceSample += deltaTime;
+	if (!animation.sampled) {
+		samplePose(animation, animation.currentTime, ends, animation.target.data());
+		animation.sinceSample = animation.samplePeriod;
+	}
+	if (animation.sinceSample >= animation.samplePeriod) {
+		std::swap(animation.previous, animation.target);
+		animation.samplePeriod = lod.period;
+		samplePose(animation, wrapTime(animation, animation.currentTime + lod.period), ends, animation.target.data());
+		std::memcpy(animation.sampledEnds, ends, sizeof(ends));
+		animation.sinceSample = 0.0f;
+		animation.sampled = true;
+	}
+
+	float t = animation.sinceSample / animation.samplePeriod;
+	std::fill(animation.weights.begin(), animation.weights.end(), t);
+	blendTracks(animation, ends, animation.previous.data(), animation.target.data(), animation.weights.data(), animation.pose.data());
+	return applyPose(animation, ends);
+}
+
+// ─────────────────────────────────────────────
+// Level of detail
+// ─────────────────────────────────────────────
+
+// Picked by projected height, the bounding sphere's diameter over the
+// viewport height
+struct AnimationLodLevel {
+	float minScreenSize;
+	float period;
+	uint32_t maxDepth;
+	bool morphWeights;
+};
+
+static constexpr AnimationLodLevel ANIMATION_LOD_LEVELS[] = {
+	{ 0.25f, 0.0f,         UINT32_MAX, true },
+	{ 0.10f, 1.0f / 30.0f, UINT32_MAX, true },
+	{ 0.03f, 1.0f / 15.0f, 8,          false },
+	{ 0.0f,  1.0f / 5.0f,  4,          false },
+};
+
+// Animated poses can leave the bind pose bounds; the sphere is padded
+static constexpr float BOUNDS_PADDING = 1.25f;
+
+static void computeBounds(Model* model) {
+	glm::vec3 minBounds(std::numeric_limits<float>::max());
+	glm::vec3 maxBounds(std::numeric_limits<float>::lowest());
+	for (const Node* node : model->linearNodes) {
+		if (node->meshes.empty())
+			continue;
+		const glm::mat4& global = node->worldMatrix;
+		for (const Mesh* mesh : node->meshes) {
+			for (int corner = 0; corner < 8; corner++) {
+				glm::vec3 p(corner & 1 ? mesh->maxBounds.x : mesh->minBounds.x,
+					corner & 2 ? mesh->maxBounds.y : mesh->minBounds.y,
+					corner & 4 ? mesh->maxBounds.z : mesh->minBounds.z);
+				p = glm::vec3(global * glm::vec4(p, 1.0f));
+				minBounds = glm::min(minBounds, p);
+				maxBounds = glm::max(maxBounds, p);
+			}
+		}
+	}
+	if (minBounds.x > maxBounds.x) {
+		model->boundsCenter = glm::vec3(0.0f);
+		model->boundsRadius = 0.0f;
+		return;
+	}
+	model->boundsCenter = 0.5f * (minBounds + maxBounds);
+	model->boundsRadius = 0.5f * glm::length(maxBounds - minBounds) * BOUNDS_PADDING;
+}
+
+struct AnimationView {
+	glm::vec4 planes[6];
+	glm::vec3 position;
+	float tanHalfFov;
+};
+
+static AnimationView animationView(State* state) {
+	const Camera* camera = state->scene->camera;
+	VkExtent2D extent = state->window.swapchain.imageExtent;
+	float aspect = extent.height > 0 ? (float)extent.width / (float)extent.height : 1.0f;
+	// Same projection as uniformBuffersUpdate
+	glm::mat4 viewProj = camera->getProjectionMatrix(aspect, 0.001f, 2000.0f) * camera->getViewMatrix();
+
+	// Gribb-Hartmann planes, normals pointing inwards
+	AnimationView view{ .position = camera->getPosition(), .tanHalfFov = std::tan(glm::radians(camera->getZoom()) * 0.5f) };
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; r++)
+		rows[r] = glm::vec4(viewProj[0][r], viewProj[1][r], viewProj[2][r], viewProj[3][r]);
+	view.planes[0] = rows[3] + rows[0];
+	view.planes[1] = rows[3] - rows[0];
+	view.planes[2] = rows[3] + rows[1];
+	view.planes[3] = rows[3] - rows[1];
+	view.planes[4] = rows[3] + rows[2];
+	view.planes[5] = rows[3] - rows[2];
+	for (glm::vec4& plane : view.planes)
+		plane /= glm::length(glm::vec3(plane));
+	return view;
+}
+
+static AnimationLod animationLodSelect(Model* model, const AnimationView& view) {
+	if (model->boundsRadius < 0.0f)
+		computeBounds(model);
+
+	const glm::mat4& transform = model->transform;
+	glm::vec3 center = glm::vec3(transform * glm::vec4(model->boundsCenter, 1.0f));
+	float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+	float radius = model->boundsRadius * scale;
+
+	AnimationLod lod;
+	for (const glm::vec4& plane : view.planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			lod.visible = false;
+			return lod;
+		}
+	}
+
+	float distance = glm::length(center - view.position);
+	float screenSize = distance > radius ? radius / (distance * view.tanHalfFov) : 1.0f;
+	for (const AnimationLodLevel& level : ANIMATION_LOD_LEVELS) {
+		if (screenSize >= level.minScreenSize) {
+			lod.period = level.period;
+			lod.maxDepth = level.maxDepth;
+			lod.morphWeights = level.morphWeights;
+			break;
+		}
+	}
+	return lod;
+}
+
+void animationsUpdate(State* state, float deltaTime) {
+	std::vector<Model*>& models = state->scene->models;
+	AnimationView view = animationView(state);
+	parallelFor(state->jobs, models.size(), [&](size_t i) {
+		Model* model = models[i];
+		if (model->activeAnimation >= 0 && model->activeAnimation < (int32_t)model->animations.size()
+			&& animationEvaluate(model->animations[model->activeAnimation], deltaTime, animationLodSelect(model, view)))
+			model->transformsDirty = true;
+	});
+}
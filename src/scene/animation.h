@@ -1,34 +1,101 @@
 #pragma once
-#pragma once
 
 #include <vector>
 #include <string>
 #include <limits>
+#include <cstdint>
 #include "core/math.h"
 struct Node;
-// Structure for animation keyframes
-struct AnimationChannel {
-	enum PathType { TRANSLATION, ROTATION, SCALE };
-	PathType path;
+struct Model;
+struct State;
+
+// One animated node property (a glTF channel plus its sampler). Keyframes are
+// slices of the owning Animation's compressed arrays: keyCount times from
+// firstKey, and keyCount values (3 * keyCount for CUBICSPLINE, stored
+// in-tangent, value, out-tangent per key as in glTF) of
+// animationValueWords() words each from firstValue. A glTF weights channel
+// becomes one WEIGHTS track per four morph targets.
+//
+// Values are 16-bit: linear and step rotations as smallest-three unit
+// quaternions (see animationValueWords), everything else range-quantized
+// per component as rangeMin + rangeExtent * word / 65535.
+struct AnimationTrack {
+	enum Path : uint32_t { TRANSLATION, ROTATION, SCALE, WEIGHTS };
+	enum Interpolation : uint32_t { LINEAR, STEP, CUBICSPLINE };
+
 	Node* node = nullptr;
-	uint32_t samplerIndex;
+	Path path = TRANSLATION;
+	Interpolation interpolation = LINEAR;
+	uint32_t firstKey = 0;
+	uint32_t keyCount = 0;
+	uint32_t firstValue = 0;
+	uint32_t firstWeight = 0;   // WEIGHTS: Node::morphWeights index of the value's x
+	glm::vec4 rangeMin{ 0.0f };
+	glm::vec4 rangeExtent{ 0.0f };
 };
 
-// Structure for animation interpolation
-struct AnimationSampler {
-	enum InterpolationType { LINEAR, STEP, CUBICSPLINE };
-	InterpolationType interpolation;
-	std::vector<float> inputs;  // Key frame timestamps
-	std::vector<glm::vec4> outputsVec4;  // Key frame values (for rotations)
-	std::vector<glm::vec3> outputsVec3;  // Key frame values (for translations and scales)
-};
+// Words per key value. Smallest-three rotations drop the largest component
+// (rebuilt from the unit length) and keep the other three as 15-bit
+// fractions of [-1/sqrt(2), 1/sqrt(2)]; the top bits of words 0 and 1 hold
+// the dropped component's index. CUBICSPLINE rotations carry non-unit
+// tangents, so they are range-quantized like the other paths.
+inline uint32_t animationValueWords(AnimationTrack::Path path, AnimationTrack::Interpolation interpolation) {
+	if (path == AnimationTrack::WEIGHTS || (path == AnimationTrack::ROTATION && interpolation == AnimationTrack::CUBICSPLINE))
+		return 4;
+	return 3;
+}
 
-// Structure for animation
+// Structure-of-arrays clip: every track's times and values are contiguous,
+// and tracks are sorted by path so each kernel runs over one range. Key
+// times are quantized to 16 bits over [start, end].
 struct Animation {
 	std::string name;
-	std::vector<AnimationSampler> samplers;
-	std::vector<AnimationChannel> channels;
+	std::vector<AnimationTrack> tracks;
+	std::vector<uint16_t> times;
+	std::vector<uint16_t> values;    // quantized key values, see AnimationTrack
+	uint32_t firstRotation = 0;      // tracks [firstRotation, firstScale) are rotations
+	uint32_t firstScale = 0;         // [firstScale, firstWeights) scales, then weights
+	uint32_t firstWeights = 0;
 	float start = std::numeric_limits<float>::max();
-	float end = std::numeric_limits<float>::min();
+	float end = std::numeric_limits<float>::lowest();
 	float currentTime = 0.0f;
-};
\ No newline at end of file
+
+	// Per-track evaluation state, sized by animationFinalize
+	std::vector<uint16_t> depths;    // animated node's depth in the hierarchy
+	std::vector<uint32_t> cursors;   // key found last frame
+	std::vector<glm::vec4> from;     // segment endpoints and weights
+	std::vector<glm::vec4> to;
+	std::vector<float> weights;
+	std::vector<glm::vec4> pose;
+
+	// Throttled evaluation: poses sampled samplePeriod apart and blended
+	// every frame in between
+	std::vector<glm::vec4> previous;
+	std::vector<glm::vec4> target;
+	uint32_t sampledEnds[4] = {};    // track ranges previous/target cover
+	float sinceSample = 0.0f;
+	float samplePeriod = 0.0f;
+	bool sampled = false;
+};
+
+// How much of an animation to evaluate this frame, chosen per model from
+// its projected size by animationsUpdate.
+struct AnimationLod {
+	float period = 0.0f;                 // seconds between sampled poses, 0 samples every frame
+	uint32_t maxDepth = UINT32_MAX;      // tracks on deeper nodes keep their last pose
+	bool morphWeights = true;
+	bool visible = true;                 // culled models only advance currentTime
+};
+
+// Sorts tracks by path, then node depth, and sizes the evaluation state;
+// call once the tracks and key arrays are filled.
+void animationFinalize(Animation& animation);
+
+// Advances currentTime by deltaTime (looping over [start, end]) and writes
+// the sampled TRS and morph weights into the animated nodes, marking them
+// dirty. Returns whether any node's TRS was written.
+bool animationEvaluate(Animation& animation, float deltaTime, const AnimationLod& lod = {});
+
+// Evaluates every model's active animation at the level of detail its
+// on-screen size calls for, models spread across the job system.
+void animationsUpdate(State* state, float deltaTime);
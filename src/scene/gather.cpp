@@ -5,49 +5,61 @@
 #include "scene/mesh.h"
 #include "scene/camera.h"
 #include "scene/scene.h"
+#include "scene/transforms.h"
+#include "render/skinning.h"
 #include "core/state.h"
+#include <algorithm>
 void gatherDrawItems(
-    const Node* node,
     const glm::vec3& camPos,
     const std::vector<Material*>& materials,
     Model* model,
     std::vector<DrawItem>& outItems)
 {
-    // World matrix for this node
-    glm::mat4 nodeWorld = model->transform * node->getGlobalMatrix();
+    // Flattened tree, parents first as the recursive walk visited it
+    for (const Node* node : model->linearNodes) {
+        if (node->meshes.empty())
+            continue;
 
-    // For each mesh on this node
-    for (const Mesh* mesh : node->meshes) {
-        const Material* mat = materials[mesh->materialIndex];
+        // World matrix for this node
+        glm::mat4 nodeWorld;
+        mat4Multiply(model->transform, node->worldMatrix, nodeWorld);
 
-        // World-space center of the mesh
-        glm::vec3 centerWorld =
-            glm::vec3(nodeWorld * glm::vec4(mesh->center, 1.0f));
+        // For each mesh on this node
+        for (uint32_t i = 0; i < node->meshes.size(); i++) {
+            const Mesh* mesh = node->meshes[i];
+            const Material* mat = materials[mesh->materialIndex];
 
-        // World-space distance to camera
-        float dist = glm::length(centerWorld - camPos);
+            // World-space center of the mesh
+            glm::vec3 centerWorld =
+                glm::vec3(nodeWorld * glm::vec4(mesh->center, 1.0f));
 
-        // Transparent if glTF alphaMode == "BLEND" or has transmission
-        bool hasTransmission =
-            (mat->transmissionFactor > 0.0f) ||
-            (mat->transmissionTextureIndex >= 0);
+            // World-space distance to camera
+            float dist = glm::length(centerWorld - camPos);
 
-        bool isTransparent =
-            (mat->alphaMode == "BLEND") ||
-            hasTransmission;
+            // Bounds radius under the node's largest scale
+            float scale = std::max({ glm::length(glm::vec3(nodeWorld[0])),
+                glm::length(glm::vec3(nodeWorld[1])), glm::length(glm::vec3(nodeWorld[2])) });
+            float radius = 0.5f * glm::length(mesh->maxBounds - mesh->minBounds) * scale;
 
-        DrawItem item{};
-        item.model = model;
-        item.node = node;
-        item.mesh = mesh;
-        item.distanceToCamera = dist;
-        item.transparent = isTransparent;
+            // Transparent if glTF alphaMode == "BLEND" or has transmission
+            bool hasTransmission =
+                (mat->transmissionFactor > 0.0f) ||
+                (mat->transmissionTextureIndex >= 0);
 
-        outItems.push_back(item);
-    }
+            bool isTransparent =
+                (mat->alphaMode == "BLEND") ||
+                hasTransmission;
+
+            DrawItem item{};
+            item.model = model;
+            item.node = node;
+            item.mesh = mesh;
+            item.vertexBuffer = skinnedVertexBuffer(model, node, i);
+            item.distanceToCamera = dist;
+            item.boundingRadius = radius;
+            item.transparent = isTransparent;
 
-    // Recurse children
-    for (const Node* child : node->children) {
-        gatherDrawItems(child, camPos, materials, model, outItems);
+            outItems.push_back(item);
+        }
     }
 }
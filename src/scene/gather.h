@@ -1,5 +1,6 @@
 #pragma once
 #include "core/math.h"
+#include <vulkan/vulkan.h>
 struct State;
 struct Node;
 struct Mesh;
@@ -10,12 +11,13 @@ struct DrawItem {
 	const Node* node;
 	const Mesh* mesh;
 	const Model* model;
+	VkBuffer vertexBuffer;	// skinned output or mesh->vertexBuffer
 	float distanceToCamera;
+	float boundingRadius;	// world space
 	bool transparent;
 };
 
 void gatherDrawItems(
-	const Node* node,
 	const glm::vec3& camPos,
 	const std::vector<Material*>& materials,
 	Model* model,
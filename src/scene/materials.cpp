@@ -1 +1,29 @@
-#include "materials.h"
\ No newline at end of file
+#include "scene/materials.h"
+#include "core/hash.h"
+
+uint64_t materialHash(const Material& mat) {
+	const int textures[] = {
+		mat.baseColorTextureIndex, mat.metallicRoughnessTextureIndex, mat.normalTextureIndex,
+		mat.occlusionTextureIndex, mat.emissiveTextureIndex, mat.transmissionTextureIndex,
+		mat.thicknessTextureIndex,
+		mat.baseColorTexCoordIndex, mat.metallicRoughnessTexCoordIndex, mat.normalTexCoordIndex,
+		mat.occlusionTexCoordIndex, mat.emissiveTexCoordIndex, mat.transmissionTexCoordIndex,
+		mat.thicknessTexCoordIndex,
+		mat.doubleSided ? 1 : 0,
+	};
+	const float factors[] = {
+		mat.baseColorFactor.r, mat.baseColorFactor.g, mat.baseColorFactor.b, mat.baseColorFactor.a,
+		mat.metallicFactor, mat.roughnessFactor,
+		mat.emissiveFactor.r, mat.emissiveFactor.g, mat.emissiveFactor.b,
+		mat.transmissionFactor, mat.thicknessFactor,
+		mat.attenuationColor.r, mat.attenuationColor.g, mat.attenuationColor.b, mat.attenuationColor.a,
+		mat.attenuationDistance, mat.ior, mat.alphaCutoff,
+	};
+	uint64_t hash = hashBytes(textures, sizeof(textures));
+	hash = hashBytes(factors, sizeof(factors), hash);
+	for (const TextureTransform* transform : {
+		&mat.baseColorTransform, &mat.metallicRoughnessTransform, &mat.normalTransform,
+		&mat.occlusionTransform, &mat.emissiveTransform, &mat.transmissionTransform })
+		hash = hashBytes(transform, sizeof(TextureTransform), hash);
+	return hashBytes(mat.alphaMode.data(), mat.alphaMode.size(), hash);
+}
@@ -45,4 +45,11 @@ struct Material {
     VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
     VkBuffer        materialBuffer = VK_NULL_HANDLE;
     VkDeviceMemory  materialMemory = VK_NULL_HANDLE;
-};
\ No newline at end of file
+
+    uint64_t cacheKey = 0;   // Scene::materialCache
+    uint32_t refCount = 0;   // models holding this
+};
+
+// Hash of every shaded parameter, texture indices included; equal hashes
+// share one material
+uint64_t materialHash(const Material& mat);
\ No newline at end of file
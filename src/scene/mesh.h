@@ -4,6 +4,9 @@
 #include <cstdint>
 #include <vulkan/vulkan.h>
 #include "core/math.h"
+#include "core/hash.h"
+#include "core/config.h"
+#include <cstring>
 
 
 struct Vertex {
@@ -60,24 +63,139 @@ struct Vertex {
 		return attributeDescriptions;
 
 	}
+	// Bitwise over every attribute, so welding never merges distinct vertices
 	bool operator==(const Vertex& other) const {
-		return pos == other.pos && color == other.color && texCoord0 == other.texCoord0;
+		return memcmp(this, &other, sizeof(Vertex)) == 0;
 	}
 };
+static_assert(sizeof(Vertex) == 18 * sizeof(float), "Vertex is hashed and compared bytewise; it must have no padding");
+
 namespace std {
 	template<> struct hash<Vertex> {
 		size_t operator()(Vertex const& vertex) const {
-			return ((hash<glm::vec3>()(vertex.pos) ^
-				(hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^
-				(hash<glm::vec2>()(vertex.texCoord0) << 1);
+			return (size_t)hashBytes(&vertex, sizeof(Vertex));
 		}
 	};
 }
+// Compact GPU vertex (VertexLayout::Compact). Normal and tangent are
+// octahedral snorm16, texcoords half floats, color unorm8 with the tangent
+// sign in alpha (1 = +1, 0 = -1). Built by packVertices.
+struct CompactVertex {
+	glm::vec3 pos;
+	uint32_t  color;
+	uint32_t  texCoord0;
+	uint32_t  texCoord1;
+	uint32_t  normal;
+	uint32_t  tangent;
+};
+static_assert(sizeof(CompactVertex) == 32);
+
+// CompactVertex with unorm16 positions over the mesh bounds, decoded by the
+// posOffset/posScale push constants (VertexLayout::CompactQuantized)
+struct QuantizedVertex {
+	uint16_t  pos[4];	// w unused
+	uint32_t  color;
+	uint32_t  texCoord0;
+	uint32_t  texCoord1;
+	uint32_t  normal;
+	uint32_t  tangent;
+};
+static_assert(sizeof(QuantizedVertex) == 28);
+
+template<typename V>
+std::array<VkVertexInputAttributeDescription, 6> packedAttributeDescriptions(VkFormat posFormat) {
+	return { {
+		{ .location = 0, .binding = 0, .format = posFormat,                   .offset = offsetof(V, pos) },
+		{ .location = 1, .binding = 0, .format = VK_FORMAT_R8G8B8A8_UNORM,    .offset = offsetof(V, color) },
+		{ .location = 2, .binding = 0, .format = VK_FORMAT_R16G16_SFLOAT,     .offset = offsetof(V, texCoord0) },
+		{ .location = 3, .binding = 0, .format = VK_FORMAT_R16G16_SFLOAT,     .offset = offsetof(V, texCoord1) },
+		{ .location = 4, .binding = 0, .format = VK_FORMAT_R16G16_SNORM,      .offset = offsetof(V, normal) },
+		{ .location = 5, .binding = 0, .format = VK_FORMAT_R16G16_SNORM,      .offset = offsetof(V, tangent) },
+	} };
+}
+
+inline uint32_t vertexStride(VertexLayout layout) {
+	switch (layout) {
+	case VertexLayout::Compact:          return sizeof(CompactVertex);
+	case VertexLayout::CompactQuantized: return sizeof(QuantizedVertex);
+	default:                             return sizeof(Vertex);
+	}
+}
+
+inline VkVertexInputBindingDescription vertexBindingDescription(VertexLayout layout) {
+	return {
+		.binding = 0,
+		.stride = vertexStride(layout),
+		.inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+	};
+}
+
+inline std::array<VkVertexInputAttributeDescription, 6> vertexAttributeDescriptions(VertexLayout layout) {
+	switch (layout) {
+	case VertexLayout::Compact:          return packedAttributeDescriptions<CompactVertex>(VK_FORMAT_R32G32B32_SFLOAT);
+	case VertexLayout::CompactQuantized: return packedAttributeDescriptions<QuantizedVertex>(VK_FORMAT_R16G16B16A16_UNORM);
+	default:                             return Vertex::getAttributeDescriptions();
+	}
+}
+
+// Per-instance node-local transform, one mat4 over locations 6-9
+inline VkVertexInputBindingDescription instanceBindingDescription() {
+	return {
+		.binding = 1,
+		.stride = sizeof(glm::mat4),
+		.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+	};
+}
+
+inline std::array<VkVertexInputAttributeDescription, 4> instanceAttributeDescriptions() {
+	std::array<VkVertexInputAttributeDescription, 4> columns{};
+	for (uint32_t i = 0; i < 4; i++)
+		columns[i] = { .location = 6 + i, .binding = 1, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = i * (uint32_t)sizeof(glm::vec4) };
+	return columns;
+}
+
+// JOINTS_0 / WEIGHTS_0 of one vertex, laid out for the skinning compute pass
+struct SkinVertex {
+	glm::uvec4 joints;
+	glm::vec4  weights;
+};
+static_assert(sizeof(SkinVertex) == 32);
+
+// A vertex moved by at least one morph target; its deltas are
+// Mesh::morphDeltas[firstDelta, firstDelta + deltaCount)
+struct MorphVertex {
+	uint32_t vertex;
+	uint32_t firstDelta;
+	uint32_t deltaCount;
+	uint32_t reserved;
+};
+static_assert(sizeof(MorphVertex) == 16);
+
+// Non-zero offset of one vertex in one morph target
+struct MorphDelta {
+	glm::vec3 position;
+	uint32_t  target;
+	glm::vec3 normal;
+	float     reserved0;
+	glm::vec3 tangent;
+	float     reserved1;
+};
+static_assert(sizeof(MorphDelta) == 48);
+
 struct Mesh {
+	// Filled only by parseSceneNodes for the cooker; loads decode straight
+	// into staging (decodeMeshBuffers)
 	std::vector<Vertex>   vertices;
 	std::vector<uint32_t> indices;
+	std::vector<SkinVertex> skinVertices;	// empty unless skinned
+	std::vector<MorphVertex> morphVertices;	// sparse: only vertices a target moves
+	std::vector<MorphDelta> morphDeltas;
+	uint32_t              vertexCount = 0;
+	uint32_t              indexCount = 0;
 	int                   materialIndex = -1;
 	int					  gpuIndex = -1;
+	uint32_t			  refCount = 0;	// nodes holding this mesh (see Node::addMesh)
+	uint64_t			  contentHash = 0;	// of the GPU blobs; hot reload keeps unchanged buffers
 
 	glm::vec3 minBounds;
 	glm::vec3 maxBounds;
@@ -88,4 +206,24 @@ struct Mesh {
 	VkDeviceMemory vertexMemory = VK_NULL_HANDLE;
 	VkBuffer       indexBuffer = VK_NULL_HANDLE;
 	VkDeviceMemory indexMemory = VK_NULL_HANDLE;
-}; 
+	VkIndexType    indexType = VK_INDEX_TYPE_UINT32;	// meshIndexType(vertexCount)
+	bool           skinned = false;
+	VkBuffer       skinBuffer = VK_NULL_HANDLE;	// SkinVertex per vertex
+	VkDeviceMemory skinMemory = VK_NULL_HANDLE;
+	uint32_t       morphTargetCount = 0;
+	uint32_t       morphVertexCount = 0;	// 0 if no target moves anything
+	uint32_t       morphDeltaCount = 0;
+	VkBuffer       morphBuffer = VK_NULL_HANDLE;	// morph vertices, then deltas
+	VkDeviceMemory morphMemory = VK_NULL_HANDLE;
+};
+
+// Skinned and morphed meshes are also read by the deformation passes, and
+// morphed ones copied out as each frame's starting pose
+inline VkBufferUsageFlags meshVertexUsage(const Mesh& mesh) {
+	VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	if (mesh.skinned || mesh.morphVertexCount)
+		usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	if (mesh.morphVertexCount)
+		usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	return usage;
+} 
@@ -3,25 +3,41 @@
 #include "scene/node.h"
 #include "scene/materials.h"
 #include "scene/animation.h"
+#include "scene/skin.h"
 #include "core/math.h"
 
 
 struct Model {
 	std::string name;
-	std::vector<Node*> nodes;
+	std::vector<Node*> nodes;          // by glTF node index while parsing; not owned
 	Node* rootNode = nullptr;
+	// rootNode's tree flattened by modelTransformsInit, parents first, not
+	// owned; linearParents holds each node's parent index, -1 for the root
 	std::vector<Node*> linearNodes;
+	std::vector<int32_t> linearParents;
+	std::vector<uint8_t> worldChanged;  // modelTransformsUpdate scratch
+	bool transformsDirty = false;      // some node is dirty
 	std::vector<Animation> animations;
+	int32_t activeAnimation = 0;       // played by animationsUpdate, -1 for none
+	std::vector<Skin> skins;
+	ModelSkinning* skinning = nullptr; // GPU side of the skins, see skinningCreate
 	glm::mat4 transform = glm::mat4(1.0f);
 
-	uint32_t baseMaterialIndex = 0;
-	uint32_t baseTextureIndex = 0;
+	// Model-space bounding sphere of the bind pose, radius < 0 until
+	// animationsUpdate first needs it
+	glm::vec3 boundsCenter = glm::vec3(0.0f);
+	float boundsRadius = -1.0f;
 
-	~Model() {
-		for (auto node : linearNodes) {
-			delete node;
-		}
-	}
+	// Node-local instance transforms of every instanced node, uploaded once
+	// as a per-instance vertex buffer (see Node::firstInstance)
+	std::vector<glm::mat4> instances;
+	VkBuffer instanceBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory instanceMemory = VK_NULL_HANDLE;
+
+	// Scene::materials / Scene::textures index of each of the model's own
+	// (glTF or package order); shared entries hold one reference per model
+	std::vector<uint32_t> materialIndices;
+	std::vector<uint32_t> textureIndices;
 
 	void translate(const glm::vec3& delta) {
 		transform = glm::translate(transform, delta);
@@ -75,46 +91,7 @@ struct Model {
 
 	void updateAnimation(uint32_t index, float deltaTime) {
 		assert(!animations.empty() && index < animations.size());
-
-
-
-		Animation& animation = animations[index];
-		animation.currentTime += deltaTime;
-		if (animation.currentTime > animation.end) {
-			animation.currentTime = animation.start;
-		}
-
-		for (auto& channel : animation.channels) {
-			AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
-
-			// Find the current key frame using binary search
-			auto keyFrameIt = std::ranges::lower_bound(sampler.inputs, animation.currentTime);
-			if (keyFrameIt != sampler.inputs.end() && keyFrameIt != sampler.inputs.begin()) {
-				size_t i = std::distance(sampler.inputs.begin(), keyFrameIt) - 1;
-				float t = (animation.currentTime - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]);
-
-				switch (channel.path) {
-				case AnimationChannel::TRANSLATION: {
-					glm::vec3 start = sampler.outputsVec3[i];
-					glm::vec3 end = sampler.outputsVec3[i + 1];
-					channel.node->translation = glm::mix(start, end, t);
-					break;
-				}
-				case AnimationChannel::ROTATION: {
-					glm::quat start = glm::quat(sampler.outputsVec4[i].w, sampler.outputsVec4[i].x, sampler.outputsVec4[i].y, sampler.outputsVec4[i].z);
-					glm::quat end = glm::quat(sampler.outputsVec4[i + 1].w, sampler.outputsVec4[i + 1].x, sampler.outputsVec4[i + 1].y, sampler.outputsVec4[i + 1].z);
-					channel.node->rotation = glm::slerp(start, end, t);
-					break;
-				}
-				case AnimationChannel::SCALE: {
-					glm::vec3 start = sampler.outputsVec3[i];
-					glm::vec3 end = sampler.outputsVec3[i + 1];
-					channel.node->scale = glm::mix(start, end, t);
-					break;
-				}
-				}
-				break;
-			}
-		}
+		if (animationEvaluate(animations[index], deltaTime))
+			transformsDirty = true;
 	}
 };
\ No newline at end of file
@@ -14,6 +14,31 @@ struct Node {
 	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
 	glm::vec3 scale = glm::vec3(1.0f);
 
+	// Cached by modelTransformsUpdate (scene/transforms.h). Set dirty, and
+	// the model's transformsDirty, after changing matrix or TRS.
+	glm::mat4 localMatrix = glm::mat4(1.0f);
+	glm::mat4 worldMatrix = glm::mat4(1.0f);	// model space
+	bool useMatrix = false;	// hasMatrix() at load
+	bool dirty = true;
+
+	// EXT_mesh_gpu_instancing: range of Model::instances drawn in one
+	// instanced draw per mesh; 0 draws the node once
+	uint32_t firstInstance = 0;
+	uint32_t instanceCount = 0;
+
+	// Model::skins index, -1 if unskinned. Skinned and morphed meshes draw
+	// from ModelSkinning::draws[firstSkinnedDraw + i] for meshes[i].
+	int32_t  skin = -1;
+	uint32_t firstSkinnedDraw = 0;
+
+	// Morph target weights of the node's meshes, animated by WEIGHTS tracks
+	std::vector<float> morphWeights;
+
+	// Meshes are shared between nodes instancing the same glTF mesh
+	void addMesh(Mesh* mesh) {
+		meshes.push_back(mesh);
+		mesh->refCount++;
+	}
 
 	bool hasMatrix() const
 	{
@@ -30,24 +55,4 @@ struct Node {
 		}
 		return false; // matrix is identity → no baked matrix
 	}
-
-	glm::mat4 getLocalMatrix() const
-	{
-		if (hasMatrix())
-			return matrix;   // glTF rule: matrix overrides TRS
-
-		glm::mat4 T = glm::translate(glm::mat4(1.0f), translation);
-		glm::mat4 R = glm::mat4_cast(rotation);
-		glm::mat4 S = glm::scale(glm::mat4(1.0f), scale);
-		return T * R * S;
-	}
-
-
-	glm::mat4 getGlobalMatrix() const {
-		if (parent)
-			return parent->getGlobalMatrix() * getLocalMatrix();
-		else
-			return getLocalMatrix();
-	}
-
 };
\ No newline at end of file
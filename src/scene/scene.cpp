@@ -3,3 +3,91 @@
 #include "scene/texture.h"
 #include "scene/materials.h"
 #include "scene/model.h"
+
+template<typename T>
+static uint32_t addToSlot(std::vector<T*>& slots, std::vector<uint32_t>& freeSlots, T* item) {
+	if (freeSlots.empty()) {
+		slots.push_back(item);
+		return (uint32_t)slots.size() - 1;
+	}
+	uint32_t index = freeSlots.back();
+	freeSlots.pop_back();
+	delete slots[index];
+	slots[index] = item;
+	return index;
+}
+
+// Drops a reference to slots[index]; the last one frees the slot
+template<typename T>
+static T* releaseSlot(std::vector<T*>& slots, std::vector<uint32_t>& freeSlots, std::unordered_map<uint64_t, uint32_t>& cache, uint32_t index) {
+	T* item = slots[index];
+	if (--item->refCount > 0)
+		return nullptr;
+	auto cached = cache.find(item->cacheKey);
+	if (cached != cache.end() && cached->second == index)
+		cache.erase(cached);
+	slots[index] = new T{};
+	freeSlots.push_back(index);
+	return item;
+}
+
+int sceneAcquireTexture(Scene* scene, uint64_t key) {
+	std::lock_guard<std::mutex> lock(scene->cacheMutex);
+	auto cached = scene->textureCache.find(key);
+	if (cached == scene->textureCache.end())
+		return -1;
+	scene->textures[cached->second]->refCount++;
+	return (int)cached->second;
+}
+
+uint32_t sceneAddTexture(Scene* scene, Texture* tex, uint64_t key) {
+	std::lock_guard<std::mutex> lock(scene->cacheMutex);
+	tex->refCount = 1;
+	tex->cacheKey = key;
+	uint32_t index = addToSlot(scene->textures, scene->freeTextureSlots, tex);
+	scene->textureCache.emplace(key, index);
+	return index;
+}
+
+Texture* sceneReleaseTexture(Scene* scene, uint32_t index) {
+	std::lock_guard<std::mutex> lock(scene->cacheMutex);
+	return releaseSlot(scene->textures, scene->freeTextureSlots, scene->textureCache, index);
+}
+
+uint32_t sceneInternMaterial(Scene* scene, Material* mat, const std::vector<uint32_t>& textureIndices, bool* added) {
+	for (int* index : {
+		&mat->baseColorTextureIndex, &mat->metallicRoughnessTextureIndex, &mat->normalTextureIndex,
+		&mat->occlusionTextureIndex, &mat->emissiveTextureIndex, &mat->transmissionTextureIndex,
+		&mat->thicknessTextureIndex })
+		*index = *index >= 0 && *index < (int)textureIndices.size() ? (int)textureIndices[*index] : -1;
+
+	uint64_t key = materialHash(*mat);
+	std::lock_guard<std::mutex> lock(scene->cacheMutex);
+	auto cached = scene->materialCache.find(key);
+	if (added)
+		*added = cached == scene->materialCache.end();
+	if (cached != scene->materialCache.end()) {
+		delete mat;
+		scene->materials[cached->second]->refCount++;
+		return cached->second;
+	}
+
+	mat->refCount = 1;
+	mat->cacheKey = key;
+	uint32_t index = addToSlot(scene->materials, scene->freeMaterialSlots, mat);
+	scene->materialCache.emplace(key, index);
+	return index;
+}
+
+Material* sceneReleaseMaterial(Scene* scene, uint32_t index) {
+	std::lock_guard<std::mutex> lock(scene->cacheMutex);
+	return releaseSlot(scene->materials, scene->freeMaterialSlots, scene->materialCache, index);
+}
+
+void sceneClearCaches(Scene* scene) {
+	std::lock_guard<std::mutex> lock(scene->cacheMutex);
+	scene->textureCache.clear();
+	scene->materialCache.clear();
+	scene->freeTextureSlots.clear();
+	scene->freeMaterialSlots.clear();
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include <vector>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
 struct Model;
 struct Texture;
 struct Material;
@@ -12,4 +15,33 @@ struct Scene {
 	std::vector<Texture*> textures;
 	std::vector<Material*> materials;
 	Camera *camera;
-};
\ No newline at end of file
+
+	// Content-addressed sharing between models: textures by textureCacheKey,
+	// materials by materialHash. Freed slots hold empty placeholders until
+	// reused. The mutex guards the tables, free lists and refCounts, since
+	// async decodes acquire textures from worker threads.
+	std::unordered_map<uint64_t, uint32_t> textureCache;
+	std::unordered_map<uint64_t, uint32_t> materialCache;
+	std::vector<uint32_t> freeTextureSlots;
+	std::vector<uint32_t> freeMaterialSlots;
+	std::mutex cacheMutex;
+};
+
+// Index of the texture cached under key, with one more reference, or -1
+int sceneAcquireTexture(Scene* scene, uint64_t key);
+// Stores tex under key with one reference and returns its index
+uint32_t sceneAddTexture(Scene* scene, Texture* tex, uint64_t key);
+// Drops a reference. Returns the texture when that was the last one, for the
+// caller to destroy once no frame uses it; its slot is already freed.
+Texture* sceneReleaseTexture(Scene* scene, uint32_t index);
+
+// Points mat's model-local texture indices at textureIndices, then returns
+// the index of an identical material with one more reference, deleting mat,
+// or stores mat with one reference. added tells which happened; new
+// materials still need their descriptor set written.
+uint32_t sceneInternMaterial(Scene* scene, Material* mat, const std::vector<uint32_t>& textureIndices, bool* added = nullptr);
+// As sceneReleaseTexture
+Material* sceneReleaseMaterial(Scene* scene, uint32_t index);
+
+// Forgets every cached entry; for modelUnload, which destroys them all
+void sceneClearCaches(Scene* scene);
@@ -0,0 +1,14 @@
+#pragma once
+#include <vector>
+#include <string>
+#include "core/math.h"
+struct Node;
+struct ModelSkinning;
+
+// glTF skin: joint nodes and their inverse bind matrices, index-aligned.
+// A joint outside the loaded scene is nullptr and contributes identity.
+struct Skin {
+	std::string name;
+	std::vector<Node*> joints;
+	std::vector<glm::mat4> inverseBindMatrices;
+};
@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 #include <unordered_map>
 #include "core/math.h"
+#include "core/hash.h"
 #include <iostream>
 #include <cstdio>
 #include <cstdlib>
@@ -11,6 +12,8 @@
 #include <vector>
 #include <array>
 
+struct TextureStream;
+
 enum TextureRole {
 	BaseColor,
 	MetallicRoughness,
@@ -20,6 +23,13 @@ enum TextureRole {
 	Emissive
 };
 
+// Data roles are sampled as UNORM, colour roles as sRGB
+inline bool textureRoleIsLinear(TextureRole role) {
+	return role == TextureRole::Normal ||
+		role == TextureRole::MetallicRoughness ||
+		role == TextureRole::Occlusion;
+}
+
 struct Texture{
 	std::string name;
 	VkImage textureImage;
@@ -111,8 +121,18 @@ struct Texture{
 	VkFormat lutFormat;
 
 	TextureRole role = TextureRole::BaseColor;
+	uint64_t contentHash = 0;	// of the uploaded mip chain, or of the encoded image when not cooked
+	uint64_t cacheKey = 0;		// Scene::textureCache, see textureCacheKey
+	uint32_t refCount = 0;		// models holding this
+	TextureStream* stream = nullptr;	// packaged textures whose finer mips stream
 };
 
+// Cache key of an image uploaded for role; the same bytes become different
+// textures as sRGB colour and as linear data
+inline uint64_t textureCacheKey(uint64_t contentHash, TextureRole role) {
+	return hashCombine(contentHash, (uint64_t)role + 1);
+}
+
 struct TextureTransform {
 	glm::vec2 offset = { 0,0 };
 	glm::vec2 scale = { 1,1 };
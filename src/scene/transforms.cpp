@@ -0,0 +1,113 @@
+#include "scene/transforms.h"
+#include "scene/node.h"
+#include "scene/model.h"
+#include "scene/scene.h"
+#include "core/jobs.h"
+#include "core/state.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define RUNE_TRANSFORMS_SSE 1
+#include <xmmintrin.h>
+#endif
+
+void mat4Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#ifdef RUNE_TRANSFORMS_SSE
+	// Column c of the product is a's columns weighted by b[c]
+	const float* pa = glm::value_ptr(a);
+	const float* pb = glm::value_ptr(b);
+	__m128 a0 = _mm_loadu_ps(pa);
+	__m128 a1 = _mm_loadu_ps(pa + 4);
+	__m128 a2 = _mm_loadu_ps(pa + 8);
+	__m128 a3 = _mm_loadu_ps(pa + 12);
+	__m128 columns[4];
+	for (int c = 0; c < 4; c++) {
+		const float* column = pb + 4 * c;
+		__m128 sum = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+		columns[c] = sum;
+	}
+	float* po = glm::value_ptr(out);
+	for (int c = 0; c < 4; c++)
+		_mm_storeu_ps(po + 4 * c, columns[c]);
+#else
+	out = a * b;
+#endif
+}
+
+// T * R * S without the two general products
+static glm::mat4 localMatrix(const Node* node) {
+	if (node->useMatrix)
+		return node->matrix;
+	glm::mat4 m = glm::mat4_cast(node->rotation);
+	m[0] *= node->scale.x;
+	m[1] *= node->scale.y;
+	m[2] *= node->scale.z;
+	m[3] = glm::vec4(node->translation, 1.0f);
+	return m;
+}
+
+void modelTransformsInit(Model* model) {
+	model->linearNodes.clear();
+	model->linearParents.clear();
+	if (!model->rootNode)
+		return;
+
+	// Pre-order, so the list walks the tree in the order recursion did
+	std::vector<std::pair<Node*, int32_t>> stack{ { model->rootNode, -1 } };
+	while (!stack.empty()) {
+		auto [node, parent] = stack.back();
+		stack.pop_back();
+		int32_t index = (int32_t)model->linearNodes.size();
+		model->linearNodes.push_back(node);
+		model->linearParents.push_back(parent);
+		node->useMatrix = node->hasMatrix();
+		node->dirty = true;
+		for (auto child = node->children.rbegin(); child != node->children.rend(); ++child)
+			stack.push_back({ *child, index });
+	}
+	model->worldChanged.assign(model->linearNodes.size(), 0);
+	model->transformsDirty = true;
+	modelTransformsUpdate(model);
+}
+
+void modelTransformsUpdate(Model* model) {
+	if (!model->transformsDirty)
+		return;
+	model->transformsDirty = false;
+
+	// Parents come first, so one pass sees every changed ancestor before
+	// its descendants
+	Node* const* nodes = model->linearNodes.data();
+	const int32_t* parents = model->linearParents.data();
+	uint8_t* changed = model->worldChanged.data();
+	for (size_t i = 0; i < model->linearNodes.size(); i++) {
+		Node* node = nodes[i];
+		int32_t parent = parents[i];
+		bool dirty = node->dirty;
+		if (dirty) {
+			node->localMatrix = localMatrix(node);
+			node->dirty = false;
+		}
+		changed[i] = dirty || (parent >= 0 && changed[parent]);
+		if (!changed[i])
+			continue;
+		if (parent >= 0)
+			mat4Multiply(nodes[parent]->worldMatrix, node->localMatrix, node->worldMatrix);
+		else
+			node->worldMatrix = node->localMatrix;
+	}
+}
+
+void transformsUpdate(State* state) {
+	std::vector<Model*> moved;
+	for (Model* model : state->scene->models) {
+		if (model->transformsDirty)
+			moved.push_back(model);
+	}
+	if (moved.size() == 1)
+		modelTransformsUpdate(moved[0]);
+	else if (!moved.empty())
+		parallelFor(state->jobs, moved.size(), [&](size_t i) { modelTransformsUpdate(moved[i]); });
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "core/math.h"
+struct State;
+struct Model;
+
+// out = a * b, four columns at a time where SSE is available. out may alias
+// either operand.
+void mat4Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+
+// Flattens the model's node tree into Model::linearNodes, parents before
+// children in draw order, and computes every node's cached matrices. Call
+// once the tree is built, on the thread that owns the model.
+void modelTransformsInit(Model* model);
+
+// Recomputes local matrices of dirty nodes and world matrices of their
+// subtrees in one pass over linearNodes. Does nothing unless
+// Model::transformsDirty is set.
+void modelTransformsUpdate(Model* model);
+
+// Brings every model's world matrices up to date after animation; models
+// nothing moved cost one flag check.
+void transformsUpdate(State* state);
@@ -0,0 +1,153 @@
+// Accessor decode microbenchmark.
+//
+// For every vertex attribute and index accessor in res/models/*.glb this times
+//   scalar : the old per-element loop switching on componentType per component
+//   kernel : accessorReadFloats / accessorReadIndices
+//   memcpy : a straight copy of the same source and destination bytes
+// and prints throughput per model. When kernel is close to memcpy the decode is
+// bandwidth-bound; the gap to scalar is what the branchy loop was costing.
+//
+// usage: rune-accessor-bench [modelDir=res/models] [repeats=20]
+#define _CRT_SECURE_NO_WARNINGS
+#define TINYGLTF_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <tiny_gltf.h>
+#include "loader/gltf_accessors.h"
+#include "scene/mesh.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static float readFloat(const unsigned char* src, int componentType) {
+	switch (componentType) {
+	case TINYGLTF_COMPONENT_TYPE_FLOAT:          return *reinterpret_cast<const float*>(src);
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  return (*src) / 255.0f;
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return (*reinterpret_cast<const uint16_t*>(src)) / 65535.0f;
+	case TINYGLTF_COMPONENT_TYPE_BYTE:           return std::max(*reinterpret_cast<const int8_t*>(src) / 127.0f, -1.0f);
+	case TINYGLTF_COMPONENT_TYPE_SHORT:          return std::max(*reinterpret_cast<const int16_t*>(src) / 32767.0f, -1.0f);
+	default: throw std::runtime_error("Unsupported componentType");
+	}
+}
+
+static void scalarFloats(const AccessorView& view, float* dst, size_t dstStride, int outComponents) {
+	size_t componentSize = tinygltf::GetComponentSizeInBytes(view.componentType);
+	unsigned char* out = reinterpret_cast<unsigned char*>(dst);
+	for (size_t i = 0; i < view.count; ++i) {
+		float* f = reinterpret_cast<float*>(out + i * dstStride);
+		for (int c = 0; c < outComponents; ++c)
+			f[c] = readFloat(view.data + i * view.stride + c * componentSize, view.componentType);
+	}
+}
+
+static void scalarIndices(const AccessorView& view, uint32_t* dst, uint32_t baseVertex) {
+	for (size_t i = 0; i < view.count; ++i) {
+		uint32_t idx = 0;
+		switch (view.componentType) {
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: idx = reinterpret_cast<const uint16_t*>(view.data)[i]; break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:   idx = reinterpret_cast<const uint32_t*>(view.data)[i]; break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  idx = view.data[i]; break;
+		}
+		dst[i] = baseVertex + idx;
+	}
+}
+
+static double bestSeconds(int repeats, const std::function<void()>& fn) {
+	double best = 1e30;
+	for (int r = 0; r < repeats; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+struct Totals {
+	size_t elements = 0;
+	size_t bytes = 0;   // source + destination bytes touched
+	double scalar = 0.0;
+	double kernel = 0.0;
+	double copy = 0.0;
+};
+
+static void benchFloats(const AccessorView& view, int outComponents, int repeats, Totals& totals) {
+	std::vector<Vertex> vertices(view.count);
+	size_t elementSize = view.components * tinygltf::GetComponentSizeInBytes(view.componentType);
+	std::vector<unsigned char> copySrc(view.count * elementSize);
+	std::vector<unsigned char> copyDst(view.count * sizeof(Vertex));
+	float* dst = reinterpret_cast<float*>(vertices.data());
+
+	totals.elements += view.count;
+	totals.bytes += view.count * (elementSize + outComponents * sizeof(float));
+	totals.scalar += bestSeconds(repeats, [&] { scalarFloats(view, dst, sizeof(Vertex), outComponents); });
+	totals.kernel += bestSeconds(repeats, [&] { accessorReadFloats(view, dst, sizeof(Vertex), outComponents); });
+	totals.copy += bestSeconds(repeats, [&] {
+		std::memcpy(copySrc.data(), view.data, copySrc.size());
+		std::memcpy(copyDst.data(), vertices.data(), copyDst.size());
+	});
+}
+
+static void benchIndices(const AccessorView& view, int repeats, Totals& totals) {
+	std::vector<uint32_t> indices(view.count);
+	std::vector<unsigned char> copyDst(view.count * view.stride);
+
+	totals.elements += view.count;
+	totals.bytes += view.count * (view.stride + sizeof(uint32_t));
+	totals.scalar += bestSeconds(repeats, [&] { scalarIndices(view, indices.data(), 7); });
+	totals.kernel += bestSeconds(repeats, [&] { accessorReadIndices(view, indices.data(), 7); });
+	totals.copy += bestSeconds(repeats, [&] { std::memcpy(copyDst.data(), view.data, copyDst.size()); });
+}
+
+static void printRow(const char* name, const Totals& t) {
+	auto gbps = [&](double seconds) { return seconds > 0.0 ? t.bytes / seconds / 1e9 : 0.0; };
+	printf("  %-10s %10zu elems %8.2f MB | scalar %7.2f GB/s | kernel %7.2f GB/s | memcpy %7.2f GB/s | kernel/memcpy %5.1f%%\n",
+		name, t.elements, t.bytes / 1e6, gbps(t.scalar), gbps(t.kernel), gbps(t.copy),
+		t.kernel > 0.0 ? 100.0 * t.copy / t.kernel : 0.0);
+}
+
+int main(int argc, char** argv) {
+	std::filesystem::path dir = argc > 1 ? argv[1] : "res/models";
+	int repeats = argc > 2 ? std::max(1, atoi(argv[2])) : 20;
+
+	for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+		if (entry.path().extension() != ".glb")
+			continue;
+
+		tinygltf::TinyGLTF loader;
+		tinygltf::Model gltf;
+		std::string err, warn;
+		if (!loader.LoadBinaryFromFile(&gltf, &err, &warn, entry.path().string())) {
+			fprintf(stderr, "%s: %s\n", entry.path().string().c_str(), err.c_str());
+			continue;
+		}
+
+		GltfBuffers buffers = gltfBufferSpans(gltf);
+		Totals attributes, indices;
+		for (const tinygltf::Mesh& mesh : gltf.meshes) {
+			for (const tinygltf::Primitive& primitive : mesh.primitives) {
+				for (const auto& [name, accessor] : primitive.attributes) {
+					AccessorView view = accessorView(gltf, buffers, accessor);
+					int outComponents = name.rfind("COLOR_", 0) == 0 ? 3 : view.components;
+					if (name.rfind("TEXCOORD_", 0) == 0 || name.rfind("COLOR_", 0) == 0)
+						view.normalized = true;
+					if (view.components > 4)
+						continue;
+					benchFloats(view, outComponents, repeats, attributes);
+				}
+				if (primitive.indices >= 0)
+					benchIndices(accessorView(gltf, buffers, primitive.indices), repeats, indices);
+			}
+		}
+
+		printf("%s\n", entry.path().filename().string().c_str());
+		printRow("attributes", attributes);
+		printRow("indices", indices);
+	}
+	return 0;
+}
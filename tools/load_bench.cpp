@@ -0,0 +1,332 @@
+// Loader phase benchmark.
+//
+// Loads each glTF --runs times through loadModelFromGltf on a real device and
+// reports, per load:
+//   stages    : wall time of parse, image decode, texture upload, nodes and
+//               mesh upload (core/load_stats.h)
+//   decoded   : bytes of mip chains and packed vertex/index data produced
+//   uploaded  : bytes staged for device-local buffers and images
+//   allocs    : operator new calls and bytes
+// plus the process peak RSS after each model. Image decode runs on the job
+// system and is summed over workers, so it can exceed the wall time of the
+// load it belongs to. Texture streaming is off, so every mip is uploaded.
+//
+// usage: rune-loadbench [--runs N=5] [--json file] [--no-cache] [model|dir ...=res/models]
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "loader/gltf_loader.h"
+#include "resources/buffers.h"
+#include "resources/staging_arena.h"
+#include "render/command_buffers.h"
+#include "render/descriptors.h"
+#include "render/renderer.h"
+#include "scene/model.h"
+#include "scene/scene.h"
+#include "scene/texture.h"
+#include "core/context.h"
+#include "core/window.h"
+#include "core/config.h"
+#include "core/jobs.h"
+#include "core/load_stats.h"
+#include "core/state.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Allocation counting
+// ─────────────────────────────────────────────
+static std::atomic<uint64_t> allocationCount{ 0 };
+static std::atomic<uint64_t> allocationBytes{ 0 };
+
+void* operator new(size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+static uint64_t peakRssBytes() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return (uint64_t)usage.ru_maxrss;
+#else
+	return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+// ─────────────────────────────────────────────
+// Results
+// ─────────────────────────────────────────────
+static constexpr size_t STAGE_COUNT = (size_t)LoadStage::Count;
+
+struct Run {
+	double wallMs = 0.0;
+	double stageMs[STAGE_COUNT] = {};
+	uint64_t bytesDecoded = 0;
+	uint64_t bytesUploaded = 0;
+	uint64_t allocations = 0;
+	uint64_t allocatedBytes = 0;
+};
+
+struct ModelResult {
+	std::string path;
+	std::vector<Run> runs;
+	uint64_t peakRss = 0;
+	std::string error;
+};
+
+static double mib(uint64_t bytes) {
+	return bytes / (1024.0 * 1024.0);
+}
+
+template <typename Field>
+static void meanMin(const std::vector<Run>& runs, Field field, double& mean, double& min) {
+	mean = 0.0;
+	min = 1e30;
+	for (const Run& run : runs) {
+		double value = field(run);
+		mean += value;
+		min = std::min(min, value);
+	}
+	mean /= runs.size();
+}
+
+static void printModel(const ModelResult& result) {
+	printf("\n%s (%zu runs)\n", result.path.c_str(), result.runs.size());
+	if (!result.error.empty())
+		printf("  failed: %s\n", result.error.c_str());
+	if (result.runs.empty())
+		return;
+
+	double mean, min;
+	printf("  %-16s %10s %10s\n", "stage", "mean ms", "min ms");
+	for (size_t s = 0; s < STAGE_COUNT; s++) {
+		meanMin(result.runs, [s](const Run& r) { return r.stageMs[s]; }, mean, min);
+		printf("  %-16s %10.2f %10.2f\n", loadStageName((LoadStage)s), mean, min);
+	}
+	meanMin(result.runs, [](const Run& r) { return r.wallMs; }, mean, min);
+	printf("  %-16s %10.2f %10.2f\n", "load (wall)", mean, min);
+
+	const Run& last = result.runs.back();
+	printf("  decoded %.2f MiB, uploaded %.2f MiB, %llu allocations (%.2f MiB), peak RSS %.1f MiB\n",
+		mib(last.bytesDecoded), mib(last.bytesUploaded),
+		(unsigned long long)last.allocations, mib(last.allocatedBytes), mib(result.peakRss));
+}
+
+static std::string jsonString(const std::string& s) {
+	std::string out = "\"";
+	for (char c : s) {
+		if (c == '"' || c == '\\')
+			out += '\\';
+		out += c;
+	}
+	return out + "\"";
+}
+
+static bool writeJson(const std::string& path, const std::vector<ModelResult>& results) {
+	FILE* f = fopen(path.c_str(), "wb");
+	if (!f)
+		return false;
+	fprintf(f, "{\n  \"models\": [");
+	for (size_t m = 0; m < results.size(); m++) {
+		const ModelResult& result = results[m];
+		fprintf(f, "%s\n    {\n      \"path\": %s,\n", m ? "," : "", jsonString(result.path).c_str());
+		if (!result.error.empty())
+			fprintf(f, "      \"error\": %s,\n", jsonString(result.error).c_str());
+		fprintf(f, "      \"peakRssBytes\": %llu,\n      \"runs\": [", (unsigned long long)result.peakRss);
+		for (size_t r = 0; r < result.runs.size(); r++) {
+			const Run& run = result.runs[r];
+			fprintf(f, "%s\n        { \"wallMs\": %.3f, \"stagesMs\": {", r ? "," : "", run.wallMs);
+			for (size_t s = 0; s < STAGE_COUNT; s++)
+				fprintf(f, "%s\"%s\": %.3f", s ? ", " : " ", loadStageName((LoadStage)s), run.stageMs[s]);
+			fprintf(f, " }, \"bytesDecoded\": %llu, \"bytesUploaded\": %llu, \"allocations\": %llu, \"allocatedBytes\": %llu }",
+				(unsigned long long)run.bytesDecoded, (unsigned long long)run.bytesUploaded,
+				(unsigned long long)run.allocations, (unsigned long long)run.allocatedBytes);
+		}
+		fprintf(f, "\n      ]\n    }");
+	}
+	fprintf(f, "\n  ]\n}\n");
+	fclose(f);
+	return true;
+}
+
+// ─────────────────────────────────────────────
+// Device
+// ─────────────────────────────────────────────
+// Just what loadModelFromGltf needs. Device selection wants a surface to
+// present to, so there is a window; it is never shown.
+static void deviceSetup(State* state) {
+	state->context = new Context{};
+	state->renderer = new Renderer{};
+	state->buffers = new Buffers{};
+	state->texture = new Texture{};
+	state->scene = new Scene{};
+	state->jobs = new JobSystem{};
+	jobSystemCreate(state);
+
+	initGLFW(false);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	state->window.handle = glfwCreateWindow(64, 64, state->config->windowTitle.c_str(), nullptr, nullptr);
+	instanceCreate(state);
+	surfaceCreate(state);
+	deviceCreate(state);
+	commandPoolCreate(state);
+	skinSetLayoutCreate(state);
+	morphSetLayoutCreate(state);
+}
+
+static void deviceTeardown(State* state) {
+	stagingArenaDestroy(state);
+	skinSetLayoutDestroy(state);
+	morphSetLayoutDestroy(state);
+	commandPoolDestroy(state);
+	deviceDestroy(state);
+	windowDestroy(state);
+	jobSystemDestroy(state);
+}
+
+static Run loadOnce(State* state, const std::string& path) {
+	LoadStats& stats = *state->loadStats;
+	loadStatsReset(stats);
+	uint64_t allocationsBefore = allocationCount.load();
+	uint64_t bytesBefore = allocationBytes.load();
+
+	Model* model = new Model{};
+	auto start = std::chrono::steady_clock::now();
+	std::exception_ptr error;
+	try {
+		loadModelFromGltf(state, model, path);
+	}
+	catch (...) {
+		error = std::current_exception();
+	}
+	std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - start;
+
+	Run run;
+	run.wallMs = wall.count();
+	for (size_t s = 0; s < STAGE_COUNT; s++)
+		run.stageMs[s] = stats.stageNanoseconds[s] / 1e6;
+	run.bytesDecoded = stats.bytesDecoded;
+	run.bytesUploaded = stats.bytesUploaded;
+	run.allocations = allocationCount.load() - allocationsBefore;
+	run.allocatedBytes = allocationBytes.load() - bytesBefore;
+
+	// Uploads wait on the queue as they go; this only covers the last one
+	vkDeviceWaitIdle(state->context->device);
+	state->scene->models.push_back(model);
+	modelUnload(state);
+
+	if (error)
+		std::rethrow_exception(error);
+	return run;
+}
+
+static void collectModels(const std::filesystem::path& path, std::vector<std::string>& out) {
+	if (!std::filesystem::is_directory(path)) {
+		out.push_back(path.generic_string());
+		return;
+	}
+	std::vector<std::string> found;
+	for (const auto& entry : std::filesystem::directory_iterator(path)) {
+		std::string ext = entry.path().extension().string();
+		if (entry.is_regular_file() && (ext == ".glb" || ext == ".gltf"))
+			found.push_back(entry.path().generic_string());
+	}
+	std::sort(found.begin(), found.end());
+	out.insert(out.end(), found.begin(), found.end());
+}
+
+int main(int argc, char** argv) {
+	int runs = 5;
+	std::string jsonPath;
+	bool textureCache = true;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+			runs = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+			jsonPath = argv[++i];
+		else if (!strcmp(argv[i], "--no-cache"))
+			textureCache = false;
+		else
+			collectModels(argv[i], paths);
+	}
+	if (paths.empty() && std::filesystem::is_directory("res/models"))
+		collectModels("res/models", paths);
+	if (paths.empty()) {
+		fprintf(stderr, "rune-loadbench: no models given and none in res/models\n");
+		return 1;
+	}
+
+	Config config
+	{
+		.windowTitle = "rune-loadbench",
+		.windowResizable = false,
+		.swapchainBuffering = SWAPCHAIN_TRIPPLE_BUFFERING,
+		.DEFAULT_TEXTURE_PATH = "./res/textures/default_texture.ktx2",
+		.TEXTURE_CACHE_DIR = textureCache ? "./cache/textures" : "",
+		.meshOptimization = true,
+		.vertexLayout = VertexLayout::Compact,
+		.textureBudget = 0,
+	};
+	LoadStats stats;
+	State state;
+	state.config = &config;
+	state.loadStats = &stats;
+	deviceSetup(&state);
+
+	std::vector<ModelResult> results;
+	for (const std::string& path : paths) {
+		ModelResult result;
+		result.path = path;
+		for (int r = 0; r < runs; r++) {
+			try {
+				result.runs.push_back(loadOnce(&state, path));
+			}
+			catch (const std::exception& e) {
+				result.error = e.what();
+				break;
+			}
+		}
+		result.peakRss = peakRssBytes();
+		results.push_back(std::move(result));
+	}
+
+	deviceTeardown(&state);
+
+	// After every load, so the loaders' own logging does not split the tables
+	for (const ModelResult& result : results)
+		printModel(result);
+	if (!jsonPath.empty() && !writeJson(jsonPath, results)) {
+		fprintf(stderr, "rune-loadbench: cannot write %s\n", jsonPath.c_str());
+		return 1;
+	}
+	return 0;
+}